@@ -0,0 +1,282 @@
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QSysInfo>
+#include <QTemporaryDir>
+
+#include "Extract.h"
+#include "ExtractionSink.h"
+#include "LocalHTTPServer.h"
+#include "ProcessStats.h"
+#include "SyntheticArchive.h"
+#include "VPKArchive.h"
+
+namespace {
+
+struct Measurement {
+	QString name;
+	qint64 bytes = 0;
+	qint64 files = 0;
+	bool ok = false;
+	double seconds = 0.0;
+	ProcessStats::Snapshot before;
+	ProcessStats::Snapshot after;
+	std::optional<qint64> peakRSSKB;
+};
+
+template<typename F>
+[[nodiscard]] Measurement measure(const QString& name, qint64 bytes, qint64 files, F&& run) {
+	Measurement measurement;
+	measurement.name = name;
+	measurement.bytes = bytes;
+	measurement.files = files;
+
+	ProcessStats::resetPeakRSS();
+	measurement.before = ProcessStats::take();
+	const auto start = std::chrono::steady_clock::now();
+	measurement.ok = run();
+	const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	measurement.after = ProcessStats::take();
+	measurement.peakRSSKB = ProcessStats::getPeakRSSKB();
+	measurement.seconds = elapsed.count();
+	return measurement;
+}
+
+[[nodiscard]] std::optional<qint64> delta(const std::optional<qint64>& before, const std::optional<qint64>& after) {
+	if (!before || !after) {
+		return std::nullopt;
+	}
+	return *after - *before;
+}
+
+[[nodiscard]] QJsonObject toJSON(const Measurement& measurement) {
+	const auto toValue = [](const std::optional<qint64>& value) {
+		return value ? QJsonValue{static_cast<double>(*value)} : QJsonValue{QJsonValue::Null};
+	};
+	return {
+		{"name", measurement.name},
+		{"ok", measurement.ok},
+		{"bytes", static_cast<double>(measurement.bytes)},
+		{"files", static_cast<double>(measurement.files)},
+		{"seconds", measurement.seconds},
+		{"mb_per_s", measurement.bytes / (1024.0 * 1024.0) / measurement.seconds},
+		{"files_per_s", measurement.files / measurement.seconds},
+		{"peak_rss_kb", toValue(measurement.peakRSSKB)},
+		{"read_io_calls", toValue(::delta(measurement.before.readCalls, measurement.after.readCalls))},
+		{"write_io_calls", toValue(::delta(measurement.before.writeCalls, measurement.after.writeCalls))},
+		{"bytes_read", toValue(::delta(measurement.before.bytesRead, measurement.after.bytesRead))},
+		{"bytes_written", toValue(::delta(measurement.before.bytesWritten, measurement.after.bytesWritten))},
+	};
+}
+
+void print(const Measurement& measurement) {
+	if (!measurement.ok) {
+		std::printf("%-36s failed\n", measurement.name.toLocal8Bit().constData());
+		return;
+	}
+	const auto count = [](const std::optional<qint64>& value) {
+		return value ? static_cast<long long>(*value) : -1ll;
+	};
+	std::printf("%-36s %8.3f s %9.1f MB/s %10.0f files/s %8lld KiB peak %9lld read calls %9lld write calls\n",
+		measurement.name.toLocal8Bit().constData(),
+		measurement.seconds,
+		measurement.bytes / (1024.0 * 1024.0) / measurement.seconds,
+		measurement.files / measurement.seconds,
+		count(measurement.peakRSSKB),
+		count(::delta(measurement.before.readCalls, measurement.after.readCalls)),
+		count(::delta(measurement.before.writeCalls, measurement.after.writeCalls)));
+}
+
+[[nodiscard]] std::optional<Measurement> benchmarkExtraction(const QString& profile, const SyntheticArchive::Archive& archive, const char* backendName, ExtractionSink::Backend backend) {
+	const auto sink = ExtractionSink::create(backend);
+	if (backend != ExtractionSink::Backend::QFILE && dynamic_cast<QFileExtractionSink*>(sink.get())) {
+		std::printf("%-36s unsupported on this system, skipping\n", QString{"extract/%1/%2"}.arg(profile, backendName).toLocal8Bit().constData());
+		return std::nullopt;
+	}
+	const QTemporaryDir outputDir;
+	return ::measure(QString{"extract/%1/%2"}.arg(profile, backendName), archive.uncompressedSize, archive.fileCount, [&] {
+		return ::extractZIP(archive.zip, outputDir.path(), *sink);
+	});
+}
+
+/// Downloads the archive the same way NewModDialog does, hashing and appending each chunk as it arrives
+[[nodiscard]] Measurement benchmarkDownload(const QString& profile, const SyntheticArchive::Archive& archive) {
+	LocalHTTPServer server{archive.zip};
+	const auto url = server.start();
+	QNetworkAccessManager network;
+	return ::measure(QString{"download/%1"}.arg(profile), archive.zip.size(), 1, [&] {
+		if (url.isEmpty()) {
+			return false;
+		}
+		QByteArray data;
+		QCryptographicHash hash{QCryptographicHash::Sha256};
+		QEventLoop loop;
+		auto* reply = network.get(QNetworkRequest{QUrl{url}});
+		QObject::connect(reply, &QNetworkReply::readyRead, &loop, [reply, &data, &hash] {
+			const auto chunk = reply->readAll();
+			hash.addData(chunk);
+			data += chunk;
+		});
+		QObject::connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+		loop.exec();
+		if (const auto chunk = reply->readAll(); !chunk.isEmpty()) {
+			hash.addData(chunk);
+			data += chunk;
+		}
+		const bool ok = reply->error() == QNetworkReply::NoError && data.size() == archive.zip.size() && !hash.result().isEmpty();
+		reply->deleteLater();
+		return ok;
+	});
+}
+
+/// Indexes a generated VPK, looks up every file by its path in uppercase, finds every file through prefix searches of
+/// the top level folders, then extracts everything. Each step checks its results against what was generated.
+[[nodiscard]] std::vector<Measurement> benchmarkVPK(const QString& profile) {
+	const QTemporaryDir outputDir;
+	const auto vpk = SyntheticArchive::generateVPK(profile, outputDir.path() + "/vpk");
+	if (vpk.dirPath.isEmpty()) {
+		Measurement failed;
+		failed.name = QString{"vpk/%1/index"}.arg(profile);
+		return {failed};
+	}
+
+	std::vector<Measurement> measurements;
+	std::unique_ptr<VPKArchive> archive;
+	measurements.push_back(::measure(QString{"vpk/%1/index"}.arg(profile), QFileInfo{vpk.dirPath}.size(), vpk.fileCount, [&] {
+		archive = VPKArchive::open(vpk.dirPath);
+		return archive && archive->getFiles().size() == vpk.fileCount;
+	}));
+	if (!archive) {
+		return measurements;
+	}
+
+	QStringList paths;
+	for (qsizetype i = 0; i < archive->getFiles().size(); i++) {
+		paths.push_back(archive->getFilePath(static_cast<quint32>(i)).toUpper());
+	}
+	measurements.push_back(::measure(QString{"vpk/%1/lookup"}.arg(profile), 0, vpk.fileCount, [&] {
+		for (qsizetype i = 0; i < paths.size(); i++) {
+			if (archive->findFile(paths[i]) != static_cast<quint32>(i)) {
+				return false;
+			}
+		}
+		return true;
+	}));
+	measurements.push_back(::measure(QString{"vpk/%1/prefix"}.arg(profile), 0, vpk.fileCount, [&] {
+		const auto& root = archive->getDirectories().first();
+		qsizetype found = root.files.size();
+		for (const auto directory : root.subdirectories) {
+			found += archive->findByPrefix(QString::fromUtf8(archive->getDirectories()[directory].name) + '/').size();
+		}
+		return found == vpk.fileCount;
+	}));
+	measurements.push_back(::measure(QString{"vpk/%1/extract"}.arg(profile), vpk.uncompressedSize, vpk.fileCount, [&] {
+		for (qsizetype i = 0; i < archive->getFiles().size(); i++) {
+			if (!archive->extract(static_cast<quint32>(i), archive->getOutputPath(static_cast<quint32>(i), outputDir.path() + "/extracted"))) {
+				return false;
+			}
+		}
+		return true;
+	}));
+	return measurements;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+	QCoreApplication app(argc, argv);
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Measures template extraction, download and VPK throughput on synthetic archives.");
+	parser.addHelpOption();
+	const QCommandLineOption profileOption{"profile", "Only run the given archive profile, can be repeated.", "name"};
+	const QCommandLineOption listOption{"list", "List the archive profiles and exit."};
+	const QCommandLineOption jsonOption{"json", "Write the results as JSON to the given file.", "path"};
+	const QCommandLineOption skipExtractionOption{"skip-extraction", "Don't run the extraction benchmarks."};
+	const QCommandLineOption skipDownloadOption{"skip-download", "Don't run the download benchmarks."};
+	const QCommandLineOption skipVPKOption{"skip-vpk", "Don't run the VPK benchmarks."};
+	parser.addOptions({profileOption, listOption, jsonOption, skipExtractionOption, skipDownloadOption, skipVPKOption});
+	parser.process(app);
+
+	if (parser.isSet(listOption)) {
+		for (const auto& [name, description] : SyntheticArchive::getProfiles()) {
+			std::printf("%-16s %s\n", name.toLocal8Bit().constData(), description.toLocal8Bit().constData());
+		}
+		return 0;
+	}
+
+	const auto selectedProfiles = parser.values(profileOption);
+	QJsonArray results;
+	bool allOK = true;
+	std::printf("Read and write calls don't include open, mkdir, close or I/O submitted through io_uring.\n");
+	for (const auto& [profile, description] : SyntheticArchive::getProfiles()) {
+		if (!selectedProfiles.isEmpty() && !selectedProfiles.contains(profile)) {
+			continue;
+		}
+
+		const auto archive = SyntheticArchive::generate(profile);
+		if (archive.zip.isEmpty()) {
+			std::printf("Failed to generate the %s archive\n", profile.toLocal8Bit().constData());
+			return 1;
+		}
+		std::printf("%s: %s (%lld byte archive)\n", profile.toLocal8Bit().constData(), description.toLocal8Bit().constData(), static_cast<long long>(archive.zip.size()));
+
+		std::vector<Measurement> measurements;
+		if (!parser.isSet(skipExtractionOption)) {
+			for (const auto& [backendName, backend] : {std::pair{"QFile", ExtractionSink::Backend::QFILE}, std::pair{"io_uring", ExtractionSink::Backend::IO_URING}}) {
+				if (auto measurement = ::benchmarkExtraction(profile, archive, backendName, backend)) {
+					measurements.push_back(std::move(*measurement));
+				}
+			}
+		}
+		if (!parser.isSet(skipDownloadOption)) {
+			measurements.push_back(::benchmarkDownload(profile, archive));
+		}
+		if (!parser.isSet(skipVPKOption)) {
+			for (auto& measurement : ::benchmarkVPK(profile)) {
+				measurements.push_back(std::move(measurement));
+			}
+		}
+
+		for (const auto& measurement : measurements) {
+			::print(measurement);
+			results.push_back(::toJSON(measurement));
+			allOK = allOK && measurement.ok;
+		}
+	}
+
+	if (parser.isSet(jsonOption)) {
+		const QJsonObject root{
+			{"version", 2},
+			{"system", QJsonObject{
+				{"os", QSysInfo::prettyProductName()},
+				{"kernel", QSysInfo::kernelVersion()},
+				{"cpu_architecture", QSysInfo::currentCpuArchitecture()},
+				{"qt", qVersion()},
+			}},
+			{"results", results},
+		};
+		QFile out{parser.value(jsonOption)};
+		if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+			std::printf("Failed to write %s\n", parser.value(jsonOption).toLocal8Bit().constData());
+			return 1;
+		}
+		out.write(QJsonDocument{root}.toJson());
+	}
+	return allOK ? 0 : 1;
+}
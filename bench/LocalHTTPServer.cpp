@@ -0,0 +1,61 @@
+#include "LocalHTTPServer.h"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+#include <QTcpSocket>
+
+LocalHTTPServer::LocalHTTPServer(QByteArray body_, QObject* parent)
+		: QTcpServer(parent)
+		, body(std::move(body_)) {}
+
+QString LocalHTTPServer::start() {
+	if (!this->listen(QHostAddress::LocalHost, 0)) {
+		return {};
+	}
+	return QString{"http://127.0.0.1:%1/template.zip"}.arg(this->serverPort());
+}
+
+void LocalHTTPServer::incomingConnection(qintptr socketDescriptor) {
+	auto* socket = new QTcpSocket{this};
+	if (!socket->setSocketDescriptor(socketDescriptor)) {
+		socket->deleteLater();
+		return;
+	}
+	QObject::connect(socket, &QTcpSocket::disconnected, socket, &QTcpSocket::deleteLater);
+
+	auto request = std::make_shared<QByteArray>();
+	auto sent = std::make_shared<qint64>(-1);
+	const auto sendNextChunk = [this, socket, sent] {
+		if (*sent >= this->body.size()) {
+			if (socket->bytesToWrite() == 0) {
+				socket->disconnectFromHost();
+			}
+			return;
+		}
+		const auto chunk = std::min(CHUNK_SIZE, this->body.size() - *sent);
+		socket->write(this->body.constData() + *sent, chunk);
+		*sent += chunk;
+	};
+	QObject::connect(socket, &QTcpSocket::bytesWritten, socket, [socket, sendNextChunk] {
+		if (socket->bytesToWrite() < CHUNK_SIZE) {
+			sendNextChunk();
+		}
+	});
+	QObject::connect(socket, &QTcpSocket::readyRead, socket, [this, socket, request, sent, sendNextChunk] {
+		*request += socket->readAll();
+		// Whatever was asked for, answer once the headers are complete
+		if (*sent >= 0 || !request->contains("\r\n\r\n")) {
+			return;
+		}
+		socket->write(
+			"HTTP/1.1 200 OK\r\n"
+			"Content-Type: application/zip\r\n"
+			"Content-Length: " + QByteArray::number(this->body.size()) + "\r\n"
+			"Connection: close\r\n"
+			"\r\n");
+		*sent = 0;
+		sendNextChunk();
+	});
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <QByteArray>
+#include <QTcpServer>
+
+/// Serves one fixed body over plain HTTP on localhost, standing in for the template host.
+/// Writes are paced by bytesWritten so the server never buffers more than a chunk per connection.
+class LocalHTTPServer : public QTcpServer {
+	Q_OBJECT;
+
+public:
+	explicit LocalHTTPServer(QByteArray body_, QObject* parent = nullptr);
+
+	/// Listens on a free port, returns the URL to download from or an empty string on failure
+	[[nodiscard]] QString start();
+
+protected:
+	void incomingConnection(qintptr socketDescriptor) override;
+
+private:
+	static constexpr qint64 CHUNK_SIZE = 1024 * 1024;
+
+	QByteArray body;
+};
@@ -0,0 +1,87 @@
+#include "ProcessStats.h"
+
+#include <QFile>
+
+#ifdef _WIN32
+	#include <Windows.h>
+	#include <psapi.h>
+#else
+	#include <sys/resource.h>
+#endif
+
+namespace {
+
+#ifdef __linux__
+/// Reads "key: value" pairs like /proc/self/io and /proc/self/status have
+[[nodiscard]] std::optional<qint64> readProcField(const char* path, QByteArrayView key) {
+	QFile file{path};
+	if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+		return std::nullopt;
+	}
+	for (const auto& line : file.readAll().split('\n')) {
+		if (!line.startsWith(key) || line.size() <= key.size() || line[key.size()] != ':') {
+			continue;
+		}
+		bool ok = false;
+		const auto value = line.sliced(key.size() + 1).trimmed().split(' ').first().toLongLong(&ok);
+		if (ok) {
+			return value;
+		}
+	}
+	return std::nullopt;
+}
+#endif
+
+} // namespace
+
+ProcessStats::Snapshot ProcessStats::take() {
+	Snapshot snapshot;
+#if defined(__linux__)
+	snapshot.readCalls = ::readProcField("/proc/self/io", "syscr");
+	snapshot.writeCalls = ::readProcField("/proc/self/io", "syscw");
+	snapshot.bytesRead = ::readProcField("/proc/self/io", "rchar");
+	snapshot.bytesWritten = ::readProcField("/proc/self/io", "wchar");
+#elif defined(_WIN32)
+	if (IO_COUNTERS counters; GetProcessIoCounters(GetCurrentProcess(), &counters)) {
+		snapshot.readCalls = static_cast<qint64>(counters.ReadOperationCount);
+		snapshot.writeCalls = static_cast<qint64>(counters.WriteOperationCount);
+		snapshot.bytesRead = static_cast<qint64>(counters.ReadTransferCount);
+		snapshot.bytesWritten = static_cast<qint64>(counters.WriteTransferCount);
+	}
+#endif
+	return snapshot;
+}
+
+void ProcessStats::resetPeakRSS() {
+#ifdef __linux__
+	// Writing 5 to clear_refs resets VmHWM (Linux 4.0+)
+	if (QFile clearRefs{"/proc/self/clear_refs"}; clearRefs.open(QIODevice::WriteOnly)) {
+		clearRefs.write("5");
+	}
+#endif
+}
+
+std::optional<qint64> ProcessStats::getPeakRSSKB() {
+#if defined(__linux__)
+	if (const auto peak = ::readProcField("/proc/self/status", "VmHWM")) {
+		return peak;
+	}
+#endif
+#if defined(_WIN32)
+	if (PROCESS_MEMORY_COUNTERS counters; GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+		return static_cast<qint64>(counters.PeakWorkingSetSize / 1024);
+	}
+	return std::nullopt;
+#else
+	rusage usage{};
+	if (getrusage(RUSAGE_SELF, &usage) != 0) {
+		return std::nullopt;
+	}
+	#ifdef __APPLE__
+	// Reported in bytes on macOS
+	return static_cast<qint64>(usage.ru_maxrss / 1024);
+	#else
+	return static_cast<qint64>(usage.ru_maxrss);
+	#endif
+#endif
+}
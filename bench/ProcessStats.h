@@ -0,0 +1,27 @@
+#pragma once
+
+#include <optional>
+
+#include <QtGlobal>
+
+/// Resource usage of the benchmark process, fields the platform can't report are left empty
+namespace ProcessStats {
+
+struct Snapshot {
+	/// Read and write calls the OS accounted to the process (syscr and syscw on Linux). These aren't every syscall:
+	/// open, mkdir and close aren't counted, and neither is anything submitted through io_uring, so the io_uring
+	/// sink's numbers can't be compared with the QFile sink's.
+	std::optional<qint64> readCalls;
+	std::optional<qint64> writeCalls;
+	std::optional<qint64> bytesRead;
+	std::optional<qint64> bytesWritten;
+};
+
+[[nodiscard]] Snapshot take();
+
+/// Resets the peak resident set size where the platform allows it, so the next benchmark reports its own peak
+void resetPeakRSS();
+
+[[nodiscard]] std::optional<qint64> getPeakRSSKB();
+
+} // namespace ProcessStats
@@ -0,0 +1,243 @@
+#include "SyntheticArchive.h"
+
+#include <functional>
+
+#include <QDir>
+#include <QFile>
+#include <QMap>
+
+#include <miniz.h>
+
+namespace {
+
+/// Files up to this size are stored in the generated VPK's directory file rather than a chunk
+constexpr qint64 SMALL_FILE_SIZE = 1024;
+
+constexpr qint64 CHUNK_SIZE = 200ll * 1024 * 1024;
+
+/// Calls back for every file of the profile with its path inside the archive and its size
+using FileGenerator = std::function<void(const std::function<bool(const QByteArray& path, qint64 size)>&)>;
+
+[[nodiscard]] FileGenerator getGenerator(const QString& profile) {
+	if (profile == "many_small") {
+		// Materials, scripts and the like: thousands of tiny files over a few nested folders
+		return [](const auto& addFile) {
+			for (int i = 0; i < 20'000; i++) {
+				if (!addFile(QString{"template-main/dir%1/sub%2/file%3.txt"}.arg(i / 1000).arg(i / 50).arg(i).toUtf8(), 512)) {
+					return;
+				}
+			}
+		};
+	}
+	if (profile == "few_huge") {
+		// Packed content, a handful of VPK-sized files
+		return [](const auto& addFile) {
+			for (int i = 0; i < 4; i++) {
+				if (!addFile(QString{"template-main/pak01_%1.vpk"}.arg(i, 3, 10, QChar{'0'}).toUtf8(), 64ll * 1024 * 1024)) {
+					return;
+				}
+			}
+		};
+	}
+	if (profile == "deep_nesting") {
+		// Long paths, every file in its own chain of folders
+		return [](const auto& addFile) {
+			for (int i = 0; i < 2'000; i++) {
+				QByteArray path = "template-main";
+				for (int depth = 0; depth < 32; depth++) {
+					path += "/level" + QByteArray::number((i + depth) % 8);
+				}
+				if (!addFile(path + "/file" + QByteArray::number(i) + ".vmt", 2048)) {
+					return;
+				}
+			}
+		};
+	}
+	if (profile == "template_mix") {
+		// Roughly the shape of a real mod template
+		return [](const auto& addFile) {
+			for (int i = 0; i < 5'000; i++) {
+				if (!addFile(QString{"template-main/materials/dir%1/file%2.vmt"}.arg(i / 100).arg(i).toUtf8(), 300 + i % 2000)) {
+					return;
+				}
+			}
+			for (int i = 0; i < 200; i++) {
+				if (!addFile(QString{"template-main/models/dir%1/file%2.mdl"}.arg(i / 20).arg(i).toUtf8(), 256 * 1024)) {
+					return;
+				}
+			}
+			(void) addFile("template-main/pak01_dir.vpk", 128ll * 1024 * 1024);
+		};
+	}
+	return {};
+}
+
+/// Half text-like and half noise, so the data compresses about as well as real content
+void fillContents(QByteArray& contents, qint64 size, qint64 fileIndex, quint32& state) {
+	contents.resize(size);
+	for (qint64 i = 0; i < size; i++) {
+		state = state * 1664525 + 1013904223;
+		contents[i] = i % 2 ? static_cast<char>('a' + (i / 2 + fileIndex) % 26) : static_cast<char>(state >> 24);
+	}
+}
+
+template<typename T>
+void appendLittleEndian(QByteArray& out, T value) {
+	for (size_t i = 0; i < sizeof(T); i++) {
+		out += static_cast<char>((static_cast<quint64>(value) >> (i * 8)) & 0xff);
+	}
+}
+
+} // namespace
+
+const QList<SyntheticArchive::Profile>& SyntheticArchive::getProfiles() {
+	static const QList<Profile> profiles{
+		{"many_small", "20000 files of 512 bytes in nested folders"},
+		{"few_huge", "4 files of 64 MiB"},
+		{"deep_nesting", "2000 files of 2 KiB, 32 folders deep"},
+		{"template_mix", "5000 small files, 200 medium files and one 128 MiB file"},
+	};
+	return profiles;
+}
+
+SyntheticArchive::Archive SyntheticArchive::generate(const QString& profile) {
+	const auto generator = ::getGenerator(profile);
+	if (!generator) {
+		return {};
+	}
+
+	mz_zip_archive zip{};
+	if (!mz_zip_writer_init_heap(&zip, 0, 0)) {
+		return {};
+	}
+
+	Archive out;
+	bool ok = true;
+	QByteArray contents;
+	quint32 state = 0x12345678;
+	generator([&](const QByteArray& path, qint64 size) {
+		::fillContents(contents, size, out.fileCount, state);
+		if (!mz_zip_writer_add_mem(&zip, path.constData(), contents.constData(), contents.size(), MZ_DEFAULT_COMPRESSION)) {
+			ok = false;
+			return false;
+		}
+		out.fileCount++;
+		out.uncompressedSize += size;
+		return true;
+	});
+
+	void* buffer = nullptr;
+	size_t size = 0;
+	if (!ok || !mz_zip_writer_finalize_heap_archive(&zip, &buffer, &size)) {
+		mz_zip_writer_end(&zip);
+		return {};
+	}
+	out.zip = QByteArray{static_cast<const char*>(buffer), static_cast<qsizetype>(size)};
+	mz_free(buffer);
+	mz_zip_writer_end(&zip);
+	return out;
+}
+
+SyntheticArchive::VPK SyntheticArchive::generateVPK(const QString& profile, const QString& outputDir) {
+	const auto generator = ::getGenerator(profile);
+	if (!generator || !QDir{}.mkpath(outputDir)) {
+		return {};
+	}
+
+	struct Entry {
+		QByteArray name;
+		quint32 crc32;
+		quint16 archiveIndex;
+		quint32 offset;
+		quint32 size;
+	};
+	// Grouped by extension, then by directory, the way the tree is laid out
+	QMap<QByteArray, QMap<QByteArray, QList<Entry>>> tree;
+
+	VPK out;
+	bool ok = true;
+	QByteArray contents;
+	QByteArray dirData;
+	QFile chunk;
+	quint16 chunkIndex = 0;
+	quint32 state = 0x12345678;
+	generator([&](QByteArray path, qint64 size) {
+		// The template's root folder isn't part of game content
+		path = path.sliced(path.indexOf('/') + 1);
+		const auto slash = path.lastIndexOf('/');
+		const auto fileName = slash < 0 ? path : path.sliced(slash + 1);
+		const auto dot = fileName.lastIndexOf('.');
+
+		::fillContents(contents, size, out.fileCount, state);
+		Entry entry{dot < 0 ? fileName : fileName.first(dot), static_cast<quint32>(mz_crc32(MZ_CRC32_INIT, reinterpret_cast<const mz_uint8*>(contents.constData()), contents.size())), 0, 0, static_cast<quint32>(size)};
+
+		// Small files are kept in the directory file and the rest go in chunks of up to 200 MiB, like Valve's tools
+		if (size <= SMALL_FILE_SIZE) {
+			entry.archiveIndex = 0x7fff;
+			entry.offset = static_cast<quint32>(dirData.size());
+			dirData += contents;
+		} else {
+			if (chunk.isOpen() && chunk.size() + size > CHUNK_SIZE) {
+				chunk.close();
+				chunkIndex++;
+			}
+			if (!chunk.isOpen()) {
+				chunk.setFileName(outputDir + QString{"/pak01_%1.vpk"}.arg(chunkIndex, 3, 10, QChar{'0'}));
+				if (!chunk.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+					ok = false;
+					return false;
+				}
+			}
+			entry.archiveIndex = chunkIndex;
+			entry.offset = static_cast<quint32>(chunk.size());
+			if (chunk.write(contents) != contents.size()) {
+				ok = false;
+				return false;
+			}
+		}
+		tree[dot < 0 ? " " : fileName.sliced(dot + 1)][slash < 0 ? " " : path.first(slash)].push_back(std::move(entry));
+		out.fileCount++;
+		out.uncompressedSize += size;
+		return true;
+	});
+	chunk.close();
+	if (!ok) {
+		return {};
+	}
+
+	QByteArray treeData;
+	for (const auto& [extension, directories] : tree.asKeyValueRange()) {
+		treeData += extension + '\0';
+		for (const auto& [directory, entries] : directories.asKeyValueRange()) {
+			treeData += directory + '\0';
+			for (const auto& entry : entries) {
+				treeData += entry.name + '\0';
+				::appendLittleEndian<quint32>(treeData, entry.crc32);
+				::appendLittleEndian<quint16>(treeData, 0);
+				::appendLittleEndian<quint16>(treeData, entry.archiveIndex);
+				::appendLittleEndian<quint32>(treeData, entry.offset);
+				::appendLittleEndian<quint32>(treeData, entry.size);
+				::appendLittleEndian<quint16>(treeData, 0xffff);
+			}
+			treeData += '\0';
+		}
+		treeData += '\0';
+	}
+	treeData += '\0';
+
+	QByteArray header;
+	::appendLittleEndian<quint32>(header, 0x55aa1234);
+	::appendLittleEndian<quint32>(header, 2);
+	::appendLittleEndian<quint32>(header, treeData.size());
+	::appendLittleEndian<quint32>(header, dirData.size());
+	::appendLittleEndian<quint32>(header, 0);
+	::appendLittleEndian<quint32>(header, 0);
+	::appendLittleEndian<quint32>(header, 0);
+
+	out.dirPath = outputDir + "/pak01_dir.vpk";
+	QFile dirFile{out.dirPath};
+	if (!dirFile.open(QIODevice::WriteOnly | QIODevice::Truncate) || dirFile.write(header + treeData + dirData) != header.size() + treeData.size() + dirData.size()) {
+		return {};
+	}
+	return out;
+}
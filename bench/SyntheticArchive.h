@@ -0,0 +1,36 @@
+#pragma once
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+
+/// Template-shaped ZIPs generated in memory with miniz, and VPKs with the same files written to disk
+namespace SyntheticArchive {
+
+struct Profile {
+	QString name;
+	QString description;
+};
+
+struct Archive {
+	QByteArray zip;
+	qint64 fileCount = 0;
+	qint64 uncompressedSize = 0;
+};
+
+[[nodiscard]] const QList<Profile>& getProfiles();
+
+/// Returns an empty archive if the profile doesn't exist or miniz fails
+[[nodiscard]] Archive generate(const QString& profile);
+
+struct VPK {
+	QString dirPath;
+	qint64 fileCount = 0;
+	qint64 uncompressedSize = 0;
+};
+
+/// Writes a version 2 VPK to the output directory, with small files in the directory file and the rest in chunks.
+/// Returns an empty path if the profile doesn't exist or a file can't be written.
+[[nodiscard]] VPK generateVPK(const QString& profile, const QString& outputDir);
+
+} // namespace SyntheticArchive
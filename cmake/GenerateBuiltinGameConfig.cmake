@@ -0,0 +1,367 @@
+# Compiles a game config into constexpr tables at configure time, so the default config needs no parsing at runtime.
+# Entries are filtered by OS here, and any schema errors in the config are reported as configure errors.
+
+function(_sdk_launcher_config_error CONTEXT MESSAGE)
+    message(FATAL_ERROR "Invalid game config ${BUILTIN_CONFIG_JSON_PATH} at ${CONTEXT}: ${MESSAGE}")
+endfunction()
+
+# Gets a value from the config, and verifies its type. Arrays and objects return their length.
+# Sets ${OUT}_FOUND to whether the value exists.
+function(_sdk_launcher_config_get OUT JSON EXPECTED_TYPE CONTEXT)
+    string(JSON TYPE ERROR_VARIABLE ERR TYPE "${JSON}" ${ARGN})
+    if(ERR)
+        set(${OUT}_FOUND OFF PARENT_SCOPE)
+        return()
+    endif()
+    if(NOT TYPE STREQUAL EXPECTED_TYPE)
+        _sdk_launcher_config_error("${CONTEXT}" "expected ${EXPECTED_TYPE}, found ${TYPE}")
+    endif()
+    if(TYPE STREQUAL "ARRAY" OR TYPE STREQUAL "OBJECT")
+        string(JSON VALUE LENGTH "${JSON}" ${ARGN})
+    else()
+        string(JSON VALUE GET "${JSON}" ${ARGN})
+    endif()
+    if(TYPE STREQUAL "NUMBER" AND NOT VALUE MATCHES "^-?[0-9]+$")
+        _sdk_launcher_config_error("${CONTEXT}" "expected an integer, found ${VALUE}")
+    endif()
+    set(${OUT} "${VALUE}" PARENT_SCOPE)
+    set(${OUT}_FOUND ON PARENT_SCOPE)
+endfunction()
+
+# Turns a string into a UTF-16 C++ string literal
+function(_sdk_launcher_config_literal OUT VALUE)
+    string(REPLACE "\\" "\\\\" VALUE "${VALUE}")
+    string(REPLACE "\"" "\\\"" VALUE "${VALUE}")
+    string(REPLACE "\n" "\\n" VALUE "${VALUE}")
+    string(REPLACE "\t" "\\t" VALUE "${VALUE}")
+    # Every other control character (like the \r of a CRLF file) as a \u escape, which unlike \x has a fixed length
+    set(HEX_DIGITS "0123456789ABCDEF")
+    foreach(CODE RANGE 1 127)
+        if(CODE GREATER 31 AND CODE LESS 127)
+            continue()
+        endif()
+        string(ASCII ${CODE} CHAR)
+        math(EXPR HIGH "${CODE} / 16")
+        math(EXPR LOW "${CODE} % 16")
+        string(SUBSTRING "${HEX_DIGITS}" ${HIGH} 1 HIGH)
+        string(SUBSTRING "${HEX_DIGITS}" ${LOW} 1 LOW)
+        string(REPLACE "${CHAR}" "\\u00${HIGH}${LOW}" VALUE "${VALUE}")
+    endforeach()
+    set(${OUT} "u\"${VALUE}\"" PARENT_SCOPE)
+endfunction()
+
+# Turns a list of initializers into a std::array initializer
+function(_sdk_launcher_config_array OUT COUNT ITEMS)
+    if(COUNT EQUAL 0)
+        set(${OUT} "{}" PARENT_SCOPE)
+    else()
+        set(${OUT} "{{\n${ITEMS}}}" PARENT_SCOPE)
+    endif()
+endfunction()
+
+function(sdk_launcher_generate_builtin_game_config JSON_PATH RESOURCE_PATH TEMPLATE_PATH OUTPUT_PATH)
+    set(BUILTIN_CONFIG_JSON_PATH "${JSON_PATH}")
+    set_property(DIRECTORY APPEND PROPERTY CMAKE_CONFIGURE_DEPENDS "${JSON_PATH}")
+    file(READ "${JSON_PATH}" JSON)
+
+    string(JSON ROOT_TYPE ERROR_VARIABLE ERR TYPE "${JSON}")
+    if(ERR)
+        _sdk_launcher_config_error("root" "${ERR}")
+    elseif(NOT ROOT_TYPE STREQUAL "OBJECT")
+        _sdk_launcher_config_error("root" "expected OBJECT, found ${ROOT_TYPE}")
+    endif()
+
+    # Matches the OS filtering done in GameConfig::parse
+    if(WIN32)
+        set(CURRENT_OS "windows")
+    elseif(CMAKE_SYSTEM_NAME STREQUAL "Linux")
+        set(CURRENT_OS "linux")
+    else()
+        set(CURRENT_OS "")
+    endif()
+
+    _sdk_launcher_config_get(GAME_DEFAULT "${JSON}" STRING "game_default" game_default)
+    if(NOT GAME_DEFAULT_FOUND)
+        _sdk_launcher_config_error("game_default" "missing required value")
+    endif()
+    _sdk_launcher_config_literal(BUILTIN_CONFIG_GAME_DEFAULT "${GAME_DEFAULT}")
+
+    _sdk_launcher_config_get(GAME_ICON "${JSON}" STRING "game_icon" game_icon)
+    if(NOT GAME_ICON_FOUND)
+        set(GAME_ICON "\${ROOT}/\${GAME}/resource/game.ico")
+    endif()
+    _sdk_launcher_config_literal(BUILTIN_CONFIG_GAME_ICON "${GAME_ICON}")
+
+    _sdk_launcher_config_get(USES_LEGACY_BIN_DIR "${JSON}" BOOLEAN "uses_legacy_bin_dir" uses_legacy_bin_dir)
+    if(USES_LEGACY_BIN_DIR_FOUND AND USES_LEGACY_BIN_DIR)
+        set(BUILTIN_CONFIG_USES_LEGACY_BIN_DIR "true")
+    else()
+        set(BUILTIN_CONFIG_USES_LEGACY_BIN_DIR "false")
+    endif()
+
+    _sdk_launcher_config_get(WINDOW_WIDTH "${JSON}" NUMBER "window_width" window_width)
+    if(WINDOW_WIDTH_FOUND)
+        set(BUILTIN_CONFIG_WINDOW_WIDTH "${WINDOW_WIDTH}")
+    else()
+        set(BUILTIN_CONFIG_WINDOW_WIDTH "DEFAULT_WINDOW_WIDTH")
+    endif()
+
+    _sdk_launcher_config_get(WINDOW_HEIGHT "${JSON}" NUMBER "window_height" window_height)
+    if(WINDOW_HEIGHT_FOUND)
+        set(BUILTIN_CONFIG_WINDOW_HEIGHT "${WINDOW_HEIGHT}")
+    else()
+        set(BUILTIN_CONFIG_WINDOW_HEIGHT "DEFAULT_WINDOW_HEIGHT")
+    endif()
+
+    set(MOD_TEMPLATES "")
+    set(MOD_TEMPLATES_COUNT 0)
+    string(JSON MOD_TEMPLATE_URL_TYPE ERROR_VARIABLE ERR TYPE "${JSON}" "mod_template_url")
+    if(MOD_TEMPLATE_URL_TYPE STREQUAL "STRING")
+        string(JSON URL GET "${JSON}" "mod_template_url")
+        _sdk_launcher_config_literal(URL "${URL}")
+        set(MOD_TEMPLATES "\t{u\"Mod Template\", ${URL}, u\"\"},\n")
+        set(MOD_TEMPLATES_COUNT 1)
+    elseif(MOD_TEMPLATE_URL_TYPE STREQUAL "OBJECT")
+        string(JSON MOD_TEMPLATES_COUNT LENGTH "${JSON}" "mod_template_url")
+        if(MOD_TEMPLATES_COUNT GREATER 0)
+            math(EXPR LAST "${MOD_TEMPLATES_COUNT} - 1")
+            foreach(I RANGE ${LAST})
+                string(JSON DESC MEMBER "${JSON}" "mod_template_url" ${I})
+                set(CONTEXT "mod_template_url.${DESC}")
+                string(JSON TYPE TYPE "${JSON}" "mod_template_url" "${DESC}")
+                set(SHA256 "")
+                if(TYPE STREQUAL "OBJECT")
+                    _sdk_launcher_config_get(URL "${JSON}" STRING "${CONTEXT}.url" "mod_template_url" "${DESC}" url)
+                    if(NOT URL_FOUND)
+                        _sdk_launcher_config_error("${CONTEXT}" "missing required value url")
+                    endif()
+                    _sdk_launcher_config_get(SHA256 "${JSON}" STRING "${CONTEXT}.sha256" "mod_template_url" "${DESC}" sha256)
+                    if(NOT SHA256_FOUND)
+                        set(SHA256 "")
+                    elseif(NOT SHA256 MATCHES "^[0-9a-fA-F]+$")
+                        _sdk_launcher_config_error("${CONTEXT}.sha256" "expected a hex string")
+                    else()
+                        string(LENGTH "${SHA256}" SHA256_LENGTH)
+                        if(NOT SHA256_LENGTH EQUAL 64)
+                            _sdk_launcher_config_error("${CONTEXT}.sha256" "expected 64 hex digits")
+                        endif()
+                        string(TOLOWER "${SHA256}" SHA256)
+                    endif()
+                else()
+                    _sdk_launcher_config_get(URL "${JSON}" STRING "${CONTEXT}" "mod_template_url" "${DESC}")
+                endif()
+                _sdk_launcher_config_literal(DESC "${DESC}")
+                _sdk_launcher_config_literal(URL "${URL}")
+                _sdk_launcher_config_literal(SHA256 "${SHA256}")
+                string(APPEND MOD_TEMPLATES "\t{${DESC}, ${URL}, ${SHA256}},\n")
+            endforeach()
+        endif()
+    elseif(NOT ERR)
+        _sdk_launcher_config_error("mod_template_url" "expected STRING or OBJECT, found ${MOD_TEMPLATE_URL_TYPE}")
+    endif()
+    set(BUILTIN_CONFIG_MOD_TEMPLATES_COUNT "${MOD_TEMPLATES_COUNT}")
+    _sdk_launcher_config_array(BUILTIN_CONFIG_MOD_TEMPLATES "${MOD_TEMPLATES_COUNT}" "${MOD_TEMPLATES}")
+
+    _sdk_launcher_config_get(SUPPORTS_P2CE_ADDONS "${JSON}" BOOLEAN "supports_p2ce_addons" supports_p2ce_addons)
+    if(SUPPORTS_P2CE_ADDONS_FOUND AND SUPPORTS_P2CE_ADDONS)
+        set(BUILTIN_CONFIG_SUPPORTS_P2CE_ADDONS "true")
+    else()
+        set(BUILTIN_CONFIG_SUPPORTS_P2CE_ADDONS "false")
+    endif()
+
+    set(PREWARM_FILES "")
+    _sdk_launcher_config_get(PREWARM_FILES_COUNT "${JSON}" ARRAY "prewarm_files" prewarm_files)
+    if(NOT PREWARM_FILES_COUNT_FOUND)
+        set(PREWARM_FILES_COUNT 0)
+    elseif(PREWARM_FILES_COUNT GREATER 0)
+        math(EXPR LAST "${PREWARM_FILES_COUNT} - 1")
+        foreach(I RANGE ${LAST})
+            _sdk_launcher_config_get(PREWARM_FILE "${JSON}" STRING "prewarm_files[${I}]" prewarm_files ${I})
+            _sdk_launcher_config_literal(PREWARM_FILE "${PREWARM_FILE}")
+            string(APPEND PREWARM_FILES "\t${PREWARM_FILE},\n")
+        endforeach()
+    endif()
+    set(BUILTIN_CONFIG_PREWARM_FILES_COUNT "${PREWARM_FILES_COUNT}")
+    _sdk_launcher_config_array(BUILTIN_CONFIG_PREWARM_FILES "${PREWARM_FILES_COUNT}" "${PREWARM_FILES}")
+
+    _sdk_launcher_config_get(PREWARM_BUDGET_MB "${JSON}" NUMBER "prewarm_budget_mb" prewarm_budget_mb)
+    if(PREWARM_BUDGET_MB_FOUND)
+        set(BUILTIN_CONFIG_PREWARM_BUDGET_MB "${PREWARM_BUDGET_MB}")
+    else()
+        set(BUILTIN_CONFIG_PREWARM_BUDGET_MB "DEFAULT_PREWARM_BUDGET_MB")
+    endif()
+
+    _sdk_launcher_config_get(SECTIONS_COUNT "${JSON}" ARRAY "sections" sections)
+    if(NOT SECTIONS_COUNT_FOUND)
+        _sdk_launcher_config_error("sections" "missing required value")
+    endif()
+
+    set(SECTIONS "")
+    set(ENTRIES "")
+    set(ARGUMENTS "")
+    set(CPU_AFFINITY "")
+    set(ENVIRONMENT "")
+    set(OUT_SECTIONS_COUNT 0)
+    set(OUT_ENTRIES_COUNT 0)
+    set(OUT_ARGUMENTS_COUNT 0)
+    set(OUT_CPU_AFFINITY_COUNT 0)
+    set(OUT_ENVIRONMENT_COUNT 0)
+    if(SECTIONS_COUNT GREATER 0)
+        math(EXPR LAST_SECTION "${SECTIONS_COUNT} - 1")
+        foreach(S RANGE ${LAST_SECTION})
+            set(SECTION_CONTEXT "sections[${S}]")
+            _sdk_launcher_config_get(SECTION_NAME "${JSON}" STRING "${SECTION_CONTEXT}.name" sections ${S} name)
+            _sdk_launcher_config_get(ENTRIES_COUNT "${JSON}" ARRAY "${SECTION_CONTEXT}.entries" sections ${S} entries)
+            if(NOT SECTION_NAME_FOUND OR NOT ENTRIES_COUNT_FOUND)
+                _sdk_launcher_config_error("${SECTION_CONTEXT}" "sections must have a name and entries")
+            endif()
+
+            set(SECTION_ENTRIES_BEGIN ${OUT_ENTRIES_COUNT})
+            if(ENTRIES_COUNT GREATER 0)
+                math(EXPR LAST_ENTRY "${ENTRIES_COUNT} - 1")
+                foreach(E RANGE ${LAST_ENTRY})
+                    set(ENTRY_CONTEXT "${SECTION_CONTEXT}.entries[${E}]")
+                    set(ENTRY_PATH sections ${S} entries ${E})
+
+                    _sdk_launcher_config_get(NAME "${JSON}" STRING "${ENTRY_CONTEXT}.name" ${ENTRY_PATH} name)
+                    _sdk_launcher_config_get(TYPE "${JSON}" STRING "${ENTRY_CONTEXT}.type" ${ENTRY_PATH} type)
+                    _sdk_launcher_config_get(ACTION "${JSON}" STRING "${ENTRY_CONTEXT}.action" ${ENTRY_PATH} action)
+                    if(NOT NAME_FOUND OR NOT TYPE_FOUND OR NOT ACTION_FOUND)
+                        _sdk_launcher_config_error("${ENTRY_CONTEXT}" "entries must have a name, type and action")
+                    endif()
+                    if(NOT TYPE MATCHES "^(command|link|directory)$")
+                        _sdk_launcher_config_error("${ENTRY_CONTEXT}.type" "unknown type \"${TYPE}\"")
+                    endif()
+                    string(TOUPPER "${TYPE}" TYPE)
+
+                    _sdk_launcher_config_get(OS "${JSON}" STRING "${ENTRY_CONTEXT}.os" ${ENTRY_PATH} os)
+                    if(OS_FOUND AND NOT CURRENT_OS STREQUAL "" AND OS MATCHES "windows|linux|macos" AND NOT OS MATCHES "${CURRENT_OS}")
+                        continue()
+                    endif()
+
+                    _sdk_launcher_config_get(ICON_OVERRIDE "${JSON}" STRING "${ENTRY_CONTEXT}.icon_override" ${ENTRY_PATH} icon_override)
+                    if(NOT ICON_OVERRIDE_FOUND)
+                        set(ICON_OVERRIDE "")
+                    endif()
+
+                    set(ARGUMENTS_BEGIN ${OUT_ARGUMENTS_COUNT})
+                    _sdk_launcher_config_get(ARGUMENTS_COUNT "${JSON}" ARRAY "${ENTRY_CONTEXT}.arguments" ${ENTRY_PATH} arguments)
+                    if(ARGUMENTS_COUNT_FOUND AND ARGUMENTS_COUNT GREATER 0)
+                        math(EXPR LAST "${ARGUMENTS_COUNT} - 1")
+                        foreach(I RANGE ${LAST})
+                            _sdk_launcher_config_get(ARGUMENT "${JSON}" STRING "${ENTRY_CONTEXT}.arguments[${I}]" ${ENTRY_PATH} arguments ${I})
+                            _sdk_launcher_config_literal(ARGUMENT "${ARGUMENT}")
+                            string(APPEND ARGUMENTS "\t${ARGUMENT},\n")
+                            math(EXPR OUT_ARGUMENTS_COUNT "${OUT_ARGUMENTS_COUNT} + 1")
+                        endforeach()
+                    endif()
+                    math(EXPR ARGUMENTS_COUNT "${OUT_ARGUMENTS_COUNT} - ${ARGUMENTS_BEGIN}")
+
+                    _sdk_launcher_config_get(PRIORITY "${JSON}" NUMBER "${ENTRY_CONTEXT}.priority" ${ENTRY_PATH} priority)
+                    if(NOT PRIORITY_FOUND)
+                        set(PRIORITY 0)
+                    endif()
+
+                    set(CPU_AFFINITY_BEGIN ${OUT_CPU_AFFINITY_COUNT})
+                    _sdk_launcher_config_get(CPU_AFFINITY_COUNT "${JSON}" ARRAY "${ENTRY_CONTEXT}.cpu_affinity" ${ENTRY_PATH} cpu_affinity)
+                    if(CPU_AFFINITY_COUNT_FOUND AND CPU_AFFINITY_COUNT GREATER 0)
+                        math(EXPR LAST "${CPU_AFFINITY_COUNT} - 1")
+                        foreach(I RANGE ${LAST})
+                            _sdk_launcher_config_get(CPU "${JSON}" NUMBER "${ENTRY_CONTEXT}.cpu_affinity[${I}]" ${ENTRY_PATH} cpu_affinity ${I})
+                            string(APPEND CPU_AFFINITY "\t${CPU},\n")
+                            math(EXPR OUT_CPU_AFFINITY_COUNT "${OUT_CPU_AFFINITY_COUNT} + 1")
+                        endforeach()
+                    endif()
+                    math(EXPR CPU_AFFINITY_COUNT "${OUT_CPU_AFFINITY_COUNT} - ${CPU_AFFINITY_BEGIN}")
+
+                    set(ENVIRONMENT_BEGIN ${OUT_ENVIRONMENT_COUNT})
+                    _sdk_launcher_config_get(ENVIRONMENT_COUNT "${JSON}" OBJECT "${ENTRY_CONTEXT}.environment" ${ENTRY_PATH} environment)
+                    if(ENVIRONMENT_COUNT_FOUND AND ENVIRONMENT_COUNT GREATER 0)
+                        math(EXPR LAST "${ENVIRONMENT_COUNT} - 1")
+                        foreach(I RANGE ${LAST})
+                            string(JSON KEY MEMBER "${JSON}" ${ENTRY_PATH} environment ${I})
+                            _sdk_launcher_config_get(VALUE "${JSON}" STRING "${ENTRY_CONTEXT}.environment.${KEY}" ${ENTRY_PATH} environment "${KEY}")
+                            _sdk_launcher_config_literal(KEY "${KEY}")
+                            _sdk_launcher_config_literal(VALUE "${VALUE}")
+                            string(APPEND ENVIRONMENT "\t{${KEY}, ${VALUE}},\n")
+                            math(EXPR OUT_ENVIRONMENT_COUNT "${OUT_ENVIRONMENT_COUNT} + 1")
+                        endforeach()
+                    endif()
+                    math(EXPR ENVIRONMENT_COUNT "${OUT_ENVIRONMENT_COUNT} - ${ENVIRONMENT_BEGIN}")
+
+                    _sdk_launcher_config_get(MEMORY_LIMIT_MB "${JSON}" NUMBER "${ENTRY_CONTEXT}.memory_limit_mb" ${ENTRY_PATH} memory_limit_mb)
+                    if(NOT MEMORY_LIMIT_MB_FOUND)
+                        set(MEMORY_LIMIT_MB 0)
+                    endif()
+
+                    _sdk_launcher_config_get(INSTANCES "${JSON}" NUMBER "${ENTRY_CONTEXT}.instances" ${ENTRY_PATH} instances)
+                    if(NOT INSTANCES_FOUND)
+                        set(INSTANCES 1)
+                    elseif(INSTANCES LESS 1 OR INSTANCES GREATER 64)
+                        _sdk_launcher_config_error("${ENTRY_CONTEXT}.instances" "should be between 1 and 64")
+                    endif()
+
+                    _sdk_launcher_config_get(INSTANCE_STAGGER_MS "${JSON}" NUMBER "${ENTRY_CONTEXT}.instance_stagger_ms" ${ENTRY_PATH} instance_stagger_ms)
+                    if(NOT INSTANCE_STAGGER_MS_FOUND)
+                        set(INSTANCE_STAGGER_MS "DEFAULT_INSTANCE_STAGGER_MS")
+                    endif()
+
+                    _sdk_launcher_config_get(INSTANCE_SPREAD_CPUS "${JSON}" BOOLEAN "${ENTRY_CONTEXT}.instance_spread_cpus" ${ENTRY_PATH} instance_spread_cpus)
+                    if(INSTANCE_SPREAD_CPUS_FOUND AND INSTANCE_SPREAD_CPUS)
+                        set(INSTANCE_SPREAD_CPUS "true")
+                    else()
+                        set(INSTANCE_SPREAD_CPUS "false")
+                    endif()
+
+                    _sdk_launcher_config_get(PROGRESS_PATTERN "${JSON}" STRING "${ENTRY_CONTEXT}.progress_pattern" ${ENTRY_PATH} progress_pattern)
+                    if(NOT PROGRESS_PATTERN_FOUND)
+                        set(PROGRESS_PATTERN "")
+                    endif()
+
+                    _sdk_launcher_config_get(PROGRESS_MAX "${JSON}" NUMBER "${ENTRY_CONTEXT}.progress_max" ${ENTRY_PATH} progress_max)
+                    if(NOT PROGRESS_MAX_FOUND)
+                        set(PROGRESS_MAX "DEFAULT_PROGRESS_MAX")
+                    elseif(PROGRESS_MAX LESS 1)
+                        _sdk_launcher_config_error("${ENTRY_CONTEXT}.progress_max" "should be at least 1")
+                    endif()
+
+                    _sdk_launcher_config_get(PROGRESS_PHASE_PATTERN "${JSON}" STRING "${ENTRY_CONTEXT}.progress_phase_pattern" ${ENTRY_PATH} progress_phase_pattern)
+                    if(NOT PROGRESS_PHASE_PATTERN_FOUND)
+                        set(PROGRESS_PHASE_PATTERN "")
+                    endif()
+
+                    _sdk_launcher_config_literal(NAME "${NAME}")
+                    _sdk_launcher_config_literal(ACTION "${ACTION}")
+                    _sdk_launcher_config_literal(ICON_OVERRIDE "${ICON_OVERRIDE}")
+                    _sdk_launcher_config_literal(PROGRESS_PATTERN "${PROGRESS_PATTERN}")
+                    _sdk_launcher_config_literal(PROGRESS_PHASE_PATTERN "${PROGRESS_PHASE_PATTERN}")
+                    string(APPEND ENTRIES "\t{${NAME}, GameConfig::ActionType::${TYPE}, ${ACTION}, ${ARGUMENTS_BEGIN}, ${ARGUMENTS_COUNT}, ${ICON_OVERRIDE}, ${PRIORITY}, ${CPU_AFFINITY_BEGIN}, ${CPU_AFFINITY_COUNT}, ${ENVIRONMENT_BEGIN}, ${ENVIRONMENT_COUNT}, ${MEMORY_LIMIT_MB}, ${INSTANCES}, ${INSTANCE_STAGGER_MS}, ${INSTANCE_SPREAD_CPUS}, ${PROGRESS_PATTERN}, ${PROGRESS_MAX}, ${PROGRESS_PHASE_PATTERN}},\n")
+                    math(EXPR OUT_ENTRIES_COUNT "${OUT_ENTRIES_COUNT} + 1")
+                endforeach()
+            endif()
+
+            # Sections with no entries on this OS are dropped, same as at runtime
+            math(EXPR SECTION_ENTRIES_COUNT "${OUT_ENTRIES_COUNT} - ${SECTION_ENTRIES_BEGIN}")
+            if(SECTION_ENTRIES_COUNT GREATER 0)
+                _sdk_launcher_config_literal(SECTION_NAME "${SECTION_NAME}")
+                string(APPEND SECTIONS "\t{${SECTION_NAME}, ${SECTION_ENTRIES_BEGIN}, ${SECTION_ENTRIES_COUNT}},\n")
+                math(EXPR OUT_SECTIONS_COUNT "${OUT_SECTIONS_COUNT} + 1")
+            endif()
+        endforeach()
+    endif()
+
+    set(BUILTIN_CONFIG_SECTIONS_COUNT "${OUT_SECTIONS_COUNT}")
+    _sdk_launcher_config_array(BUILTIN_CONFIG_SECTIONS "${OUT_SECTIONS_COUNT}" "${SECTIONS}")
+    set(BUILTIN_CONFIG_ENTRIES_COUNT "${OUT_ENTRIES_COUNT}")
+    _sdk_launcher_config_array(BUILTIN_CONFIG_ENTRIES "${OUT_ENTRIES_COUNT}" "${ENTRIES}")
+    set(BUILTIN_CONFIG_ARGUMENTS_COUNT "${OUT_ARGUMENTS_COUNT}")
+    _sdk_launcher_config_array(BUILTIN_CONFIG_ARGUMENTS "${OUT_ARGUMENTS_COUNT}" "${ARGUMENTS}")
+    set(BUILTIN_CONFIG_CPU_AFFINITY_COUNT "${OUT_CPU_AFFINITY_COUNT}")
+    _sdk_launcher_config_array(BUILTIN_CONFIG_CPU_AFFINITY "${OUT_CPU_AFFINITY_COUNT}" "${CPU_AFFINITY}")
+    set(BUILTIN_CONFIG_ENVIRONMENT_COUNT "${OUT_ENVIRONMENT_COUNT}")
+    _sdk_launcher_config_array(BUILTIN_CONFIG_ENVIRONMENT "${OUT_ENVIRONMENT_COUNT}" "${ENVIRONMENT}")
+
+    _sdk_launcher_config_literal(BUILTIN_CONFIG_PATH "${RESOURCE_PATH}")
+    file(RELATIVE_PATH BUILTIN_CONFIG_SOURCE "${CMAKE_CURRENT_SOURCE_DIR}" "${JSON_PATH}")
+    configure_file("${TEMPLATE_PATH}" "${OUTPUT_PATH}" @ONLY)
+endfunction()
@@ -0,0 +1,298 @@
+#include "AddonIndex.h"
+
+#include <algorithm>
+#include <functional>
+#include <optional>
+#include <utility>
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QSaveFile>
+#include <QSet>
+#include <QStandardPaths>
+#include <QTimer>
+#include <QtConcurrent>
+
+#include "KV3.h"
+
+namespace {
+
+constexpr quint32 CACHE_MAGIC = 0x4b563349; // KV3I
+constexpr quint32 CACHE_VERSION = 1;
+
+[[nodiscard]] qint64 getDirectorySize(const QString& path) {
+	qint64 size = 0;
+	QDirIterator it{path, QDir::Files | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot, QDirIterator::Subdirectories};
+	while (it.hasNext()) {
+		it.next();
+		size += it.fileInfo().size();
+	}
+	return size;
+}
+
+[[nodiscard]] AddonIndex::Addon readAddon(const QFileInfo& dir, const QFileInfo& kv3Info, bool enabled) {
+	AddonIndex::Addon addon;
+	addon.folder = dir.fileName();
+	addon.name = addon.folder;
+	addon.enabled = enabled;
+	addon.kv3Modified = kv3Info.lastModified().toMSecsSinceEpoch();
+	addon.dirModified = dir.lastModified().toMSecsSinceEpoch();
+	addon.size = ::getDirectorySize(dir.absoluteFilePath());
+
+	QFile file{kv3Info.absoluteFilePath()};
+	if (!file.open(QIODevice::ReadOnly)) {
+		addon.valid = false;
+		return addon;
+	}
+	const auto kv3 = KV3::parse(file.readAll());
+	if (!kv3 || kv3->type != KV3::Value::Type::OBJECT) {
+		addon.valid = false;
+		return addon;
+	}
+
+	if (const auto* name = kv3->find(u"mod"); name && !name->toString().isEmpty()) {
+		addon.name = name->toString();
+	}
+	if (const auto* type = kv3->find(u"type")) {
+		addon.type = type->toString();
+	}
+	if (const auto* id = kv3->find(u"id"); id && id->toString() != "0") {
+		addon.workshopID = id->toString();
+	}
+	if (const auto* dependencies = kv3->find(u"dependencies"); dependencies && dependencies->type == KV3::Value::Type::ARRAY) {
+		for (const auto& dependency : dependencies->array) {
+			if (auto str = dependency.toString(); !str.isEmpty()) {
+				addon.dependencies.push_back(std::move(str));
+			}
+		}
+	}
+	return addon;
+}
+
+[[nodiscard]] std::optional<QList<AddonIndex::Addon>> readCache(const QString& cachePath, const QString& gameRoot) {
+	QFile file{cachePath};
+	if (!file.open(QIODevice::ReadOnly)) {
+		return std::nullopt;
+	}
+	QDataStream in{&file};
+	quint32 magic, version;
+	QString cachedGameRoot;
+	qint64 count;
+	in >> magic >> version >> cachedGameRoot >> count;
+	if (in.status() != QDataStream::Ok || magic != CACHE_MAGIC || version != CACHE_VERSION || cachedGameRoot != gameRoot || count < 0) {
+		return std::nullopt;
+	}
+
+	QList<AddonIndex::Addon> addons;
+	addons.reserve(std::min<qint64>(count, 4096));
+	for (qint64 i = 0; i < count && in.status() == QDataStream::Ok; i++) {
+		auto& addon = addons.emplace_back();
+		in >> addon.folder >> addon.name >> addon.type >> addon.workshopID >> addon.dependencies >> addon.size >> addon.enabled >> addon.valid >> addon.kv3Modified >> addon.dirModified;
+	}
+	if (in.status() != QDataStream::Ok) {
+		return std::nullopt;
+	}
+	return addons;
+}
+
+void writeCache(const QString& cachePath, const QString& gameRoot, const QList<AddonIndex::Addon>& addons) {
+	(void) QDir{}.mkpath(QFileInfo{cachePath}.absolutePath());
+	QSaveFile file{cachePath};
+	if (!file.open(QIODevice::WriteOnly)) {
+		return;
+	}
+	QDataStream out{&file};
+	out << CACHE_MAGIC << CACHE_VERSION << gameRoot << static_cast<qint64>(addons.size());
+	for (const auto& addon : addons) {
+		out << addon.folder << addon.name << addon.type << addon.workshopID << addon.dependencies << addon.size << addon.enabled << addon.valid << addon.kv3Modified << addon.dirModified;
+	}
+	(void) file.commit();
+}
+
+/// Scans both addon directories. Addons whose addon.kv3 and directory timestamps match the previous scan are reused
+/// as-is, only new or changed addons have their KV3 parsed and their size measured.
+[[nodiscard]] QList<AddonIndex::Addon> scanAddons(const QString& gameRoot, const QList<AddonIndex::Addon>& previous, const QString& cachePath) {
+	QHash<QString, const AddonIndex::Addon*> previousByFolder;
+	for (const auto& addon : previous) {
+		previousByFolder.insert(addon.folder, &addon);
+	}
+
+	QList<AddonIndex::Addon> addons;
+	for (const bool enabled : {true, false}) {
+		const QDir addonsDir{gameRoot + QDir::separator() + (enabled ? AddonIndex::ENABLED_ADDONS_DIR : AddonIndex::DISABLED_ADDONS_DIR)};
+		for (const auto& dir : addonsDir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+			const QFileInfo kv3Info{dir.absoluteFilePath() + QDir::separator() + "addon.kv3"};
+			if (!kv3Info.isFile()) {
+				continue;
+			}
+			if (const auto* cached = previousByFolder.value(dir.fileName()); cached && cached->kv3Modified == kv3Info.lastModified().toMSecsSinceEpoch() && cached->dirModified == dir.lastModified().toMSecsSinceEpoch()) {
+				auto& addon = addons.emplace_back(*cached);
+				addon.enabled = enabled;
+				continue;
+			}
+			addons.push_back(::readAddon(dir, kv3Info, enabled));
+		}
+	}
+	std::sort(addons.begin(), addons.end(), [](const AddonIndex::Addon& lhs, const AddonIndex::Addon& rhs) {
+		return lhs.name.compare(rhs.name, Qt::CaseInsensitive) < 0;
+	});
+
+	::writeCache(cachePath, gameRoot, addons);
+	return addons;
+}
+
+} // namespace
+
+AddonIndex::AddonIndex(QString gameRoot_, QObject* parent)
+		: QObject(parent)
+		, gameRoot(std::move(gameRoot_))
+		, watcher(new QFileSystemWatcher{this})
+		, refreshTimer(new QTimer{this})
+		, scan(new QFutureWatcher<QList<Addon>>{this}) {
+	// Bursts of file changes (e.g. extracting an addon) only trigger one scan
+	this->refreshTimer->setSingleShot(true);
+	this->refreshTimer->setInterval(250);
+	QObject::connect(this->refreshTimer, &QTimer::timeout, this, &AddonIndex::refresh);
+	QObject::connect(this->watcher, &QFileSystemWatcher::directoryChanged, this->refreshTimer, qOverload<>(&QTimer::start));
+	QObject::connect(this->watcher, &QFileSystemWatcher::fileChanged, this->refreshTimer, qOverload<>(&QTimer::start));
+
+	QObject::connect(this->scan, &QFutureWatcher<QList<Addon>>::finished, this, [this] {
+		if (this->scan->future().isValid() && this->scan->future().resultCount() > 0) {
+			this->setAddons(this->scan->result());
+		}
+		this->watchDirectories();
+		if (this->refreshQueued) {
+			this->refresh();
+		}
+	});
+
+	if (auto cached = ::readCache(this->getCachePath(), this->gameRoot)) {
+		this->setAddons(std::move(*cached));
+	}
+	this->refresh();
+}
+
+const AddonIndex::Addon* AddonIndex::find(const QString& folderOrWorkshopID) const {
+	if (const auto it = this->lookup.constFind(folderOrWorkshopID); it != this->lookup.constEnd()) {
+		return &this->addons[*it];
+	}
+	return nullptr;
+}
+
+QStringList AddonIndex::resolveDependencies(const QString& folder, QStringList* missing) const {
+	QStringList out;
+	QSet<QString> visited{folder};
+	const std::function<void(const Addon&)> visit = [&](const Addon& addon) {
+		for (const auto& dependency : addon.dependencies) {
+			const auto* dependencyAddon = this->find(dependency);
+			if (!dependencyAddon) {
+				if (missing && !missing->contains(dependency)) {
+					missing->push_back(dependency);
+				}
+				continue;
+			}
+			if (visited.contains(dependencyAddon->folder)) {
+				continue;
+			}
+			visited.insert(dependencyAddon->folder);
+			visit(*dependencyAddon);
+			out.push_back(dependencyAddon->folder);
+		}
+	};
+	if (const auto* addon = this->find(folder)) {
+		visit(*addon);
+	}
+	return out;
+}
+
+QStringList AddonIndex::getDependents(const QString& folder) const {
+	QStringList out;
+	for (const auto& addon : this->addons) {
+		if (addon.enabled && addon.folder != folder && this->resolveDependencies(addon.folder).contains(folder)) {
+			out.push_back(addon.folder);
+		}
+	}
+	return out;
+}
+
+bool AddonIndex::setEnabled(const QString& folder, bool enabled) {
+	const auto it = this->lookup.constFind(folder);
+	if (it == this->lookup.constEnd()) {
+		return false;
+	}
+	auto& addon = this->addons[*it];
+	if (addon.enabled == enabled) {
+		return true;
+	}
+
+	const QDir root{this->gameRoot};
+	const QString targetDir = enabled ? ENABLED_ADDONS_DIR : DISABLED_ADDONS_DIR;
+	if (!root.mkpath(targetDir)) {
+		return false;
+	}
+	const auto from = root.filePath(QString{enabled ? DISABLED_ADDONS_DIR : ENABLED_ADDONS_DIR} + QDir::separator() + folder);
+	const auto to = root.filePath(targetDir + QDir::separator() + folder);
+	if (QFileInfo::exists(to) || !QDir{}.rename(from, to)) {
+		return false;
+	}
+
+	// Renaming doesn't touch the timestamps, so the next scan reuses this entry instead of reading it again
+	addon.enabled = enabled;
+	emit this->changed();
+	this->refresh();
+	return true;
+}
+
+void AddonIndex::refresh() {
+	if (this->scan->isRunning()) {
+		this->refreshQueued = true;
+		return;
+	}
+	this->refreshQueued = false;
+	this->scan->setFuture(QtConcurrent::run(::scanAddons, this->gameRoot, this->addons, this->getCachePath()));
+}
+
+QString AddonIndex::getCachePath() const {
+	const auto gameRootHash = QCryptographicHash::hash(this->gameRoot.toUtf8(), QCryptographicHash::Sha1).toHex();
+	return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QDir::separator() + "addons" + QDir::separator() + gameRootHash + ".bin";
+}
+
+void AddonIndex::setAddons(QList<Addon> addons_) {
+	this->addons = std::move(addons_);
+	this->lookup.clear();
+	for (qsizetype i = 0; i < this->addons.size(); i++) {
+		this->lookup.insert(this->addons[i].folder, i);
+	}
+	// Folder names win over workshop IDs if they ever collide
+	for (qsizetype i = 0; i < this->addons.size(); i++) {
+		if (!this->addons[i].workshopID.isEmpty() && !this->lookup.contains(this->addons[i].workshopID)) {
+			this->lookup.insert(this->addons[i].workshopID, i);
+		}
+	}
+	emit this->changed();
+}
+
+void AddonIndex::watchDirectories() {
+	// On Linux this is backed by inotify, watching each addon directory catches addon.kv3 being replaced
+	if (const auto watched = this->watcher->directories(); !watched.isEmpty()) {
+		(void) this->watcher->removePaths(watched);
+	}
+	QStringList paths;
+	for (const auto* dirName : {ENABLED_ADDONS_DIR, DISABLED_ADDONS_DIR}) {
+		if (const QDir dir{this->gameRoot + QDir::separator() + dirName}; dir.exists()) {
+			paths.push_back(dir.absolutePath());
+		}
+	}
+	for (const auto& addon : this->addons) {
+		paths.push_back(this->gameRoot + QDir::separator() + (addon.enabled ? ENABLED_ADDONS_DIR : DISABLED_ADDONS_DIR) + QDir::separator() + addon.folder);
+	}
+	if (!paths.isEmpty()) {
+		(void) this->watcher->addPaths(paths);
+	}
+}
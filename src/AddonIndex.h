@@ -0,0 +1,75 @@
+#pragma once
+
+#include <QFutureWatcher>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QStringList>
+
+class QFileSystemWatcher;
+class QTimer;
+
+/// Installed addons of a game, from ${GAME}/addons/*/addon.kv3 and ${GAME}/addons_disabled/*/addon.kv3.
+/// The index is cached on disk and only addons whose files changed since the last scan are read again.
+class AddonIndex : public QObject {
+	Q_OBJECT;
+
+public:
+	static constexpr auto ENABLED_ADDONS_DIR = "addons";
+	static constexpr auto DISABLED_ADDONS_DIR = "addons_disabled";
+
+	struct Addon {
+		/// Folder name, which doubles as the addon ID
+		QString folder;
+		QString name;
+		QString type;
+		/// Workshop ID from the KV3, empty if the addon was never published
+		QString workshopID;
+		QStringList dependencies;
+		qint64 size = 0;
+		bool enabled = true;
+		bool valid = true;
+		qint64 kv3Modified = 0;
+		qint64 dirModified = 0;
+	};
+
+	/// Loads the cached index right away and starts a refresh in the background
+	explicit AddonIndex(QString gameRoot_, QObject* parent = nullptr);
+
+	[[nodiscard]] const QString& getGameRoot() const { return this->gameRoot; }
+
+	[[nodiscard]] const QList<Addon>& getAddons() const { return this->addons; }
+
+	/// Looks an addon up by its folder name or its workshop ID
+	[[nodiscard]] const Addon* find(const QString& folderOrWorkshopID) const;
+
+	/// Every addon that needs to be enabled along with the given one, dependencies first.
+	/// Dependencies that aren't installed are put in missing.
+	[[nodiscard]] QStringList resolveDependencies(const QString& folder, QStringList* missing = nullptr) const;
+
+	/// Enabled addons that depend on the given one, directly or not
+	[[nodiscard]] QStringList getDependents(const QString& folder) const;
+
+	/// Moves the addon between the enabled and disabled addon directories
+	[[nodiscard]] bool setEnabled(const QString& folder, bool enabled);
+
+	void refresh();
+
+signals:
+	void changed();
+
+private:
+	QString gameRoot;
+	QList<Addon> addons;
+	QHash<QString, qsizetype> lookup;
+	QFileSystemWatcher* watcher;
+	QTimer* refreshTimer;
+	QFutureWatcher<QList<Addon>>* scan;
+	bool refreshQueued = false;
+
+	[[nodiscard]] QString getCachePath() const;
+
+	void setAddons(QList<Addon> addons_);
+
+	void watchDirectories();
+};
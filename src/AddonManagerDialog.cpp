@@ -0,0 +1,150 @@
+#include "AddonManagerDialog.h"
+
+#include <QDesktopServices>
+#include <QDialogButtonBox>
+#include <QDir>
+#include <QHeaderView>
+#include <QLocale>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QTreeWidget>
+#include <QUrl>
+#include <QVBoxLayout>
+
+#include "AddonIndex.h"
+
+namespace {
+
+enum Column {
+	COLUMN_NAME,
+	COLUMN_TYPE,
+	COLUMN_SIZE,
+	COLUMN_DEPENDENCIES,
+};
+
+} // namespace
+
+AddonManagerDialog::AddonManagerDialog(AddonIndex* index_, QWidget* parent)
+		: QDialog(parent)
+		, index(index_) {
+	// Window setup
+	this->setModal(true);
+	this->setWindowTitle(tr("Manage Addons"));
+	this->setMinimumSize(560, 360);
+
+	// Create UI elements
+	auto* layout = new QVBoxLayout{this};
+
+	this->addons = new QTreeWidget{this};
+	this->addons->setHeaderLabels({tr("Name"), tr("Type"), tr("Size"), tr("Dependencies")});
+	this->addons->setRootIsDecorated(false);
+	this->addons->setSortingEnabled(true);
+	this->addons->sortByColumn(COLUMN_NAME, Qt::AscendingOrder);
+	this->addons->header()->setSectionResizeMode(COLUMN_NAME, QHeaderView::Stretch);
+	layout->addWidget(this->addons);
+
+	auto* buttonBox = new QDialogButtonBox{QDialogButtonBox::Close, Qt::Horizontal, this};
+	auto* openFolder = buttonBox->addButton(tr("Open Folder"), QDialogButtonBox::ActionRole);
+	layout->addWidget(buttonBox);
+
+	QObject::connect(this->addons, &QTreeWidget::itemChanged, this, [this](QTreeWidgetItem* item, int column) {
+		if (this->populating || column != COLUMN_NAME) {
+			return;
+		}
+		// Toggling repopulates the tree, so don't do it while the item is still emitting
+		QMetaObject::invokeMethod(this, [this, folder = item->data(COLUMN_NAME, Qt::UserRole).toString(), enable = item->checkState(COLUMN_NAME) == Qt::Checked] {
+			this->toggle(folder, enable);
+		}, Qt::QueuedConnection);
+	});
+	QObject::connect(openFolder, &QPushButton::clicked, this, [this] {
+		const auto* item = this->addons->currentItem();
+		if (!item) {
+			return;
+		}
+		const auto* addon = this->index->find(item->data(COLUMN_NAME, Qt::UserRole).toString());
+		if (!addon) {
+			return;
+		}
+		QDesktopServices::openUrl(QUrl::fromLocalFile(this->index->getGameRoot() + QDir::separator() + (addon->enabled ? AddonIndex::ENABLED_ADDONS_DIR : AddonIndex::DISABLED_ADDONS_DIR) + QDir::separator() + addon->folder));
+	});
+	QObject::connect(buttonBox, &QDialogButtonBox::rejected, this, &AddonManagerDialog::reject);
+
+	// The index fills itself from its cache, and updates in the background as addons change
+	QObject::connect(this->index, &AddonIndex::changed, this, &AddonManagerDialog::populate);
+	this->populate();
+}
+
+void AddonManagerDialog::populate() {
+	this->populating = true;
+	const auto current = this->addons->currentItem() ? this->addons->currentItem()->data(COLUMN_NAME, Qt::UserRole).toString() : QString{};
+	this->addons->setSortingEnabled(false);
+	this->addons->clear();
+
+	const QLocale locale;
+	for (const auto& addon : this->index->getAddons()) {
+		QStringList dependencyNames;
+		for (const auto& dependency : addon.dependencies) {
+			const auto* dependencyAddon = this->index->find(dependency);
+			dependencyNames.push_back(dependencyAddon ? dependencyAddon->name : tr("%1 (missing)").arg(dependency));
+		}
+
+		auto* item = new QTreeWidgetItem{this->addons};
+		item->setText(COLUMN_NAME, addon.name);
+		item->setData(COLUMN_NAME, Qt::UserRole, addon.folder);
+		item->setCheckState(COLUMN_NAME, addon.enabled ? Qt::Checked : Qt::Unchecked);
+		item->setToolTip(COLUMN_NAME, addon.valid ? addon.folder : tr("%1: addon.kv3 could not be read.").arg(addon.folder));
+		item->setText(COLUMN_TYPE, addon.type);
+		item->setText(COLUMN_SIZE, locale.formattedDataSize(addon.size));
+		item->setText(COLUMN_DEPENDENCIES, dependencyNames.join(", "));
+		if (addon.folder == current) {
+			this->addons->setCurrentItem(item);
+		}
+	}
+
+	this->addons->setSortingEnabled(true);
+	this->populating = false;
+}
+
+void AddonManagerDialog::toggle(const QString& folder, bool enable) {
+	// Dependencies come from the index, no addon.kv3 is read here
+	QStringList toggled;
+	if (enable) {
+		QStringList missing;
+		for (const auto& dependency : this->index->resolveDependencies(folder, &missing)) {
+			if (const auto* addon = this->index->find(dependency); addon && !addon->enabled) {
+				toggled.push_back(dependency);
+			}
+		}
+		if (!missing.isEmpty()) {
+			QMessageBox::warning(this, tr("Missing Dependencies"), tr("This addon depends on addons that are not installed:\n\n%1").arg(missing.join('\n')));
+		}
+		if (!toggled.isEmpty() && QMessageBox::question(this, tr("Enable Dependencies"), tr("This addon depends on the following disabled addons, enable them too?\n\n%1").arg(toggled.join('\n'))) != QMessageBox::Yes) {
+			toggled.clear();
+		}
+	} else {
+		toggled = this->index->getDependents(folder);
+		if (!toggled.isEmpty() && QMessageBox::question(this, tr("Disable Dependents"), tr("The following enabled addons depend on this addon and will be disabled too:\n\n%1").arg(toggled.join('\n')), QMessageBox::Ok | QMessageBox::Cancel) != QMessageBox::Ok) {
+			this->populate();
+			return;
+		}
+	}
+	toggled.push_back(folder);
+
+	QStringList failed;
+	for (const auto& addon : toggled) {
+		if (!this->index->setEnabled(addon, enable)) {
+			failed.push_back(addon);
+		}
+	}
+	if (!failed.isEmpty()) {
+		QMessageBox::critical(this, tr("Error"), tr("Failed to move the following addons:\n\n%1").arg(failed.join('\n')));
+	}
+	// Also puts the checkbox back if the user backed out
+	this->populate();
+}
+
+void AddonManagerDialog::open(AddonIndex* index, QWidget* parent) {
+	auto* dialog = new AddonManagerDialog{index, parent};
+	dialog->exec();
+	dialog->deleteLater();
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <QDialog>
+
+class QTreeWidget;
+
+class AddonIndex;
+
+class AddonManagerDialog : public QDialog {
+	Q_OBJECT;
+
+public:
+	explicit AddonManagerDialog(AddonIndex* index_, QWidget* parent = nullptr);
+
+	static void open(AddonIndex* index, QWidget* parent = nullptr);
+
+private:
+	AddonIndex* index;
+	QTreeWidget* addons;
+	bool populating = false;
+
+	void populate();
+
+	void toggle(const QString& folder, bool enable);
+};
@@ -0,0 +1,615 @@
+#include "ArchiveReader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <optional>
+
+#include <miniz.h>
+#include <QStringList>
+
+#include "ExtractionSink.h"
+
+#ifdef SDK_LAUNCHER_USE_ZSTD
+	#include <atomic>
+	#include <functional>
+	#include <limits>
+
+	#include <QDir>
+	#include <QFile>
+	#include <QFileInfo>
+	#include <QHash>
+	#include <QMutex>
+	#include <QQueue>
+	#include <QThread>
+	#include <QtConcurrent>
+	#include <QWaitCondition>
+	#include <zstd.h>
+#endif
+
+namespace {
+
+constexpr quint32 ZSTD_FRAME_MAGIC = 0xfd2fb528;
+constexpr quint32 ZSTD_SKIPPABLE_FRAME_MAGIC = 0x184d2a50;
+constexpr quint32 ZSTD_SKIPPABLE_FRAME_MASK = 0xfffffff0;
+
+[[nodiscard]] quint32 readLE32(const char* data) {
+	const auto* bytes = reinterpret_cast<const unsigned char*>(data);
+	return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (static_cast<quint32>(bytes[3]) << 24);
+}
+
+[[nodiscard]] bool isZstd(const QByteArray& archive) {
+	if (archive.size() < 4) {
+		return false;
+	}
+	// pzstd puts a skippable frame in front of every frame
+	const auto magic = ::readLE32(archive.constData());
+	return magic == ZSTD_FRAME_MAGIC || (magic & ZSTD_SKIPPABLE_FRAME_MASK) == ZSTD_SKIPPABLE_FRAME_MAGIC;
+}
+
+#ifdef SDK_LAUNCHER_USE_ZSTD
+
+constexpr qsizetype TAR_BLOCK_SIZE = 512;
+/// Created inside the output dir, so staged files can be renamed into place
+constexpr auto TAR_STAGING_DIR_NAME = ".sdk_launcher_extracting";
+/// Nothing larger is decompressed, whatever the archive claims
+constexpr qint64 MAX_TAR_SIZE = 8LL * 1024 * 1024 * 1024;
+/// Frames that say they're larger than this are streamed in chunks instead of being decompressed in one go
+constexpr unsigned long long MAX_FRAME_ALLOCATION = 64 * 1024 * 1024;
+/// A zstd block takes at least 3 bytes and holds at most 128 KiB, which bounds what a frame can expand to
+constexpr unsigned long long ZSTD_MAX_EXPANSION = 128 * 1024 / 3;
+constexpr qsizetype STREAM_CHUNK_SIZE = 1024 * 1024;
+/// How far the decoder may run ahead of the tar parser
+constexpr qint64 MAX_QUEUED_BYTES = 64 * 1024 * 1024;
+
+/// Hands decompressed data from the decoder to the tar parser as it's produced, so parsing overlaps
+/// decompression even when the archive is a single frame
+class ChunkQueue {
+public:
+	/// Waits while the parser is too far behind. Returns false if the parser doesn't want any more.
+	[[nodiscard]] bool push(QByteArray chunk) {
+		QMutexLocker lock{&this->mutex};
+		while (this->queuedBytes >= MAX_QUEUED_BYTES && !this->abandoned) {
+			this->drained.wait(&this->mutex);
+		}
+		if (this->abandoned) {
+			return false;
+		}
+		this->queuedBytes += chunk.size();
+		this->chunks.enqueue(std::move(chunk));
+		this->filled.wakeOne();
+		return true;
+	}
+
+	/// Nothing more is coming
+	void close() {
+		QMutexLocker lock{&this->mutex};
+		this->closed = true;
+		this->filled.wakeOne();
+	}
+
+	/// Waits for the next chunk, returns std::nullopt once the queue is closed and empty
+	[[nodiscard]] std::optional<QByteArray> pop() {
+		QMutexLocker lock{&this->mutex};
+		while (this->chunks.isEmpty() && !this->closed) {
+			this->filled.wait(&this->mutex);
+		}
+		if (this->chunks.isEmpty()) {
+			return std::nullopt;
+		}
+		auto chunk = this->chunks.dequeue();
+		this->queuedBytes -= chunk.size();
+		this->drained.wakeOne();
+		return chunk;
+	}
+
+	/// The parser has stopped reading, so the decoder can stop too
+	void abandon() {
+		QMutexLocker lock{&this->mutex};
+		this->abandoned = true;
+		this->chunks.clear();
+		this->queuedBytes = 0;
+		this->drained.wakeOne();
+	}
+
+	[[nodiscard]] bool isAbandoned() {
+		QMutexLocker lock{&this->mutex};
+		return this->abandoned;
+	}
+
+private:
+	QMutex mutex;
+	QWaitCondition filled;
+	QWaitCondition drained;
+	QQueue<QByteArray> chunks;
+	qint64 queuedBytes = 0;
+	bool closed = false;
+	bool abandoned = false;
+};
+
+/// Called with how much of the compressed archive has been used up, returns false to stop
+using ConsumedCallback = std::function<bool(qsizetype)>;
+
+/// Decompresses one frame in chunks, for frames that don't record their size or are too big to trust it
+[[nodiscard]] bool streamZstdFrame(ZSTD_DStream* stream, const char* frame, size_t frameSize, qsizetype frameOffset, ChunkQueue& queue, qint64& total, const ConsumedCallback& consumed) {
+	ZSTD_inBuffer input{frame, frameSize, 0};
+	size_t hint;
+	do {
+		QByteArray chunk(STREAM_CHUNK_SIZE, Qt::Uninitialized);
+		ZSTD_outBuffer output{chunk.data(), static_cast<size_t>(chunk.size()), 0};
+		hint = ZSTD_decompressStream(stream, &output, &input);
+		if (ZSTD_isError(hint)) {
+			return false;
+		}
+		// Ran out of input in the middle of the frame
+		if (output.pos == 0 && input.pos == input.size && hint != 0) {
+			return false;
+		}
+		total += static_cast<qint64>(output.pos);
+		if (total > MAX_TAR_SIZE) {
+			return false;
+		}
+		chunk.resize(static_cast<qsizetype>(output.pos));
+		if (!chunk.isEmpty() && !queue.push(std::move(chunk))) {
+			return false;
+		}
+		if (!consumed(frameOffset + static_cast<qsizetype>(input.pos))) {
+			return false;
+		}
+	} while (hint != 0);
+	return true;
+}
+
+/// Decompresses every frame into the queue, in order. libzstd can't split a single frame across threads, but runs of
+/// independent frames that record their size (pzstd, or zstd with a frame size limit) are decompressed in parallel.
+/// Declared sizes are checked against the frame's compressed size and the limits above before anything is allocated.
+[[nodiscard]] bool decompressZstd(const QByteArray& archive, ChunkQueue& queue, const ConsumedCallback& consumed) {
+	struct Frame {
+		const char* input;
+		size_t inputSize;
+		size_t outputSize;
+		QByteArray output;
+	};
+	QList<Frame> frames;
+	qsizetype pos = 0;
+	const auto flushFrames = [&frames, &queue, &consumed, &pos] {
+		std::atomic_bool ok = true;
+		QtConcurrent::blockingMap(frames, [&ok](Frame& frame) {
+			frame.output = QByteArray(static_cast<qsizetype>(frame.outputSize), Qt::Uninitialized);
+			const auto written = ZSTD_decompress(frame.output.data(), frame.outputSize, frame.input, frame.inputSize);
+			if (ZSTD_isError(written) || written != frame.outputSize) {
+				ok = false;
+			}
+		});
+		for (auto& frame : frames) {
+			if (ok && !frame.output.isEmpty() && !queue.push(std::move(frame.output))) {
+				ok = false;
+			}
+		}
+		const bool flushed = frames.isEmpty() || consumed(pos);
+		frames.clear();
+		return ok && flushed;
+	};
+
+	const std::unique_ptr<ZSTD_DStream, decltype(&ZSTD_freeDStream)> stream{ZSTD_createDStream(), &ZSTD_freeDStream};
+	if (!stream) {
+		return false;
+	}
+	const auto maxParallelFrames = std::max(QThread::idealThreadCount(), 1);
+	qint64 total = 0;
+	while (pos < archive.size()) {
+		const auto frameOffset = pos;
+		const auto* frame = archive.constData() + pos;
+		const auto remaining = static_cast<size_t>(archive.size() - pos);
+		const auto frameSize = ZSTD_findFrameCompressedSize(frame, remaining);
+		if (ZSTD_isError(frameSize)) {
+			return false;
+		}
+		pos += static_cast<qsizetype>(frameSize);
+		if ((::readLE32(frame) & ZSTD_SKIPPABLE_FRAME_MASK) == ZSTD_SKIPPABLE_FRAME_MAGIC) {
+			continue;
+		}
+		const auto contentSize = ZSTD_getFrameContentSize(frame, frameSize);
+		if (contentSize == ZSTD_CONTENTSIZE_ERROR) {
+			return false;
+		}
+		if (contentSize != ZSTD_CONTENTSIZE_UNKNOWN) {
+			if (contentSize > frameSize * ZSTD_MAX_EXPANSION || contentSize > static_cast<unsigned long long>(MAX_TAR_SIZE - total)) {
+				return false;
+			}
+			if (contentSize <= MAX_FRAME_ALLOCATION) {
+				frames.push_back({frame, frameSize, static_cast<size_t>(contentSize), {}});
+				total += static_cast<qint64>(contentSize);
+				if (frames.size() >= maxParallelFrames && !flushFrames()) {
+					return false;
+				}
+				continue;
+			}
+		}
+		if (!flushFrames() || !::streamZstdFrame(stream.get(), frame, frameSize, frameOffset, queue, total, consumed)) {
+			return false;
+		}
+	}
+	return flushFrames();
+}
+
+/// Pulls bytes out of the queue for the tar parser
+class TarStream {
+public:
+	explicit TarStream(ChunkQueue& queue_)
+			: queue(queue_) {}
+
+	/// Appends the next size bytes to out, or skips them if out is null. Returns false if the data ends first.
+	[[nodiscard]] bool read(qint64 size, QByteArray* out) {
+		while (size > 0) {
+			if (this->offset == this->chunk.size()) {
+				auto next = this->queue.pop();
+				if (!next) {
+					return false;
+				}
+				this->chunk = std::move(*next);
+				this->offset = 0;
+			}
+			const auto available = static_cast<qsizetype>(std::min<qint64>(size, this->chunk.size() - this->offset));
+			if (out) {
+				out->append(this->chunk.constData() + this->offset, available);
+			}
+			this->offset += available;
+			size -= available;
+		}
+		return true;
+	}
+
+private:
+	ChunkQueue& queue;
+	QByteArray chunk;
+	qsizetype offset = 0;
+};
+
+/// Octal, or GNU base-256 for values that don't fit
+[[nodiscard]] std::optional<qint64> parseTarNumber(const char* field, qsizetype size) {
+	qint64 value = 0;
+	if (static_cast<unsigned char>(field[0]) & 0x80) {
+		value = static_cast<unsigned char>(field[0]) & 0x7f;
+		for (qsizetype i = 1; i < size; i++) {
+			if (value > (std::numeric_limits<qint64>::max() >> 8)) {
+				return std::nullopt;
+			}
+			value = (value << 8) | static_cast<unsigned char>(field[i]);
+		}
+		return value;
+	}
+	qsizetype i = 0;
+	while (i < size && (field[i] == ' ' || field[i] == '\0')) {
+		i++;
+	}
+	for (; i < size && field[i] >= '0' && field[i] <= '7'; i++) {
+		if (value > (std::numeric_limits<qint64>::max() >> 3)) {
+			return std::nullopt;
+		}
+		value = (value << 3) | (field[i] - '0');
+	}
+	if (i < size && field[i] != ' ' && field[i] != '\0') {
+		return std::nullopt;
+	}
+	return value;
+}
+
+[[nodiscard]] bool verifyTarChecksum(const char* header) {
+	const auto stored = ::parseTarNumber(header + 148, 8);
+	if (!stored) {
+		return false;
+	}
+	// The checksum field counts as spaces. Some old writers summed signed bytes, so accept either.
+	qint64 unsignedSum = 0;
+	qint64 signedSum = 0;
+	for (qsizetype i = 0; i < TAR_BLOCK_SIZE; i++) {
+		const char c = i >= 148 && i < 156 ? ' ' : header[i];
+		unsignedSum += static_cast<unsigned char>(c);
+		signedSum += static_cast<signed char>(c);
+	}
+	return *stored == unsignedSum || *stored == signedSum;
+}
+
+[[nodiscard]] QString readTarString(const char* field, qsizetype size) {
+	return QString::fromUtf8(field, static_cast<qsizetype>(qstrnlen(field, static_cast<size_t>(size))));
+}
+
+[[nodiscard]] QString getTarHeaderPath(const char* header) {
+	auto path = ::readTarString(header, 100);
+	// POSIX ustar splits long paths into a prefix and a name, old GNU tar uses those bytes for something else
+	if (std::memcmp(header + 257, "ustar\0", 6) == 0) {
+		if (const auto prefix = ::readTarString(header + 345, 155); !prefix.isEmpty()) {
+			path = prefix + '/' + path;
+		}
+	}
+	return path;
+}
+
+/// Reads the "path" and "size" records of a pax extended header, they override the next entry's header
+void parsePaxHeader(QByteArrayView records, QString& path, std::optional<qint64>& size) {
+	while (!records.isEmpty()) {
+		const auto space = records.indexOf(' ');
+		if (space <= 0) {
+			return;
+		}
+		bool ok = false;
+		const auto length = records.first(space).toLongLong(&ok);
+		if (!ok || length < space + 2 || length > records.size()) {
+			return;
+		}
+		// "<length> <key>=<value>\n", where length counts the whole record
+		const auto record = records.sliced(space + 1, length - space - 2);
+		records = records.sliced(length);
+		const auto equals = record.indexOf('=');
+		if (equals < 0) {
+			continue;
+		}
+		const auto key = record.first(equals).toByteArray();
+		const auto value = record.sliced(equals + 1);
+		if (key == "path") {
+			path = QString::fromUtf8(value);
+		} else if (key == "size") {
+			if (const auto parsed = value.toLongLong(&ok); ok && parsed >= 0) {
+				size = parsed;
+			}
+		}
+	}
+}
+
+/// A zstd compressed tar. Tar has no index, so the root dirs can't be known until every header has been seen.
+/// Files are written to a staging dir through the sink as they're decompressed, and moved into place by extract().
+class TarZstdArchiveReader : public ArchiveReader {
+public:
+	~TarZstdArchiveReader() override {
+		// Whatever wasn't moved into place, like conflicting files in an update
+		if (!this->stagingDir.isEmpty()) {
+			QDir{this->stagingDir}.removeRecursively();
+		}
+	}
+
+	[[nodiscard]] static std::unique_ptr<TarZstdArchiveReader> open(const QByteArray& archive, const QString& outputDir, ExtractionSink& sink, const ExtractProgressCallback& progress) {
+		std::unique_ptr<TarZstdArchiveReader> reader{new TarZstdArchiveReader};
+		reader->stagingDir = outputDir + '/' + TAR_STAGING_DIR_NAME;
+		// Left over if the launcher was closed in the middle of an extraction
+		QDir{reader->stagingDir}.removeRecursively();
+
+		ChunkQueue queue;
+		bool parsed = false;
+		const std::unique_ptr<QThread> parser{QThread::create([&reader, &queue, &sink, &parsed] {
+			parsed = reader->parse(queue, sink);
+			// Anything after the end of the tar (or after an error) isn't needed
+			queue.abandon();
+		})};
+		parser->start();
+		// Progress is in KiB of the compressed archive, so it fits in a progress bar
+		const bool decompressed = ::decompressZstd(archive, queue, [&progress, total = archive.size() / 1024](qsizetype consumed) {
+			return !progress || progress(consumed / 1024, total);
+		}) || queue.isAbandoned();
+		// The decoder is told to stop once the parser is done, that's not a failure
+		queue.close();
+		parser->wait();
+
+		// Queued writes have to land before the files are moved, or before the staging dir is removed on failure
+		const bool written = sink.finish();
+		if (!decompressed || !parsed || !written || !reader->finishFileList()) {
+			return nullptr;
+		}
+		return reader;
+	}
+
+	[[nodiscard]] bool extract(qsizetype index, const QString& destination, ExtractionSink& /*sink*/) override {
+		if (index < 0 || index >= this->stagedPaths.size()) {
+			return false;
+		}
+		// Already written while the archive was read, it only has to be moved into place
+		if (!QDir{}.mkpath(QFileInfo{destination}.absolutePath())) {
+			return false;
+		}
+		QFile::remove(destination);
+		return QFile::rename(this->stagedPaths[index], destination);
+	}
+
+private:
+	QString stagingDir;
+	QStringList stagedPaths;
+
+	TarZstdArchiveReader() = default;
+
+	[[nodiscard]] bool parse(ChunkQueue& queue, ExtractionSink& sink) {
+		TarStream stream{queue};
+		QHash<QString, qsizetype> indices;
+		QString extendedPath;
+		std::optional<qint64> extendedSize;
+		while (true) {
+			QByteArray header;
+			if (!stream.read(TAR_BLOCK_SIZE, &header)) {
+				break;
+			}
+			// The archive ends with two empty blocks
+			if (std::all_of(header.cbegin(), header.cend(), [](char c) { return c == '\0'; })) {
+				break;
+			}
+			if (!::verifyTarChecksum(header.constData())) {
+				return false;
+			}
+			const auto headerSize = ::parseTarNumber(header.constData() + 124, 12);
+			if (!headerSize) {
+				return false;
+			}
+
+			const char type = header[156];
+			const bool isFile = type == '0' || type == '\0' || type == '7';
+			const qint64 contentSize = isFile && extendedSize ? *extendedSize : *headerSize;
+			if (contentSize < 0 || contentSize > MAX_TAR_SIZE) {
+				return false;
+			}
+			// Directories, links and devices have nothing to extract
+			const bool keepContent = isFile || type == 'L' || type == 'x';
+			QByteArray content;
+			if (!stream.read(contentSize, keepContent ? &content : nullptr)) {
+				return false;
+			}
+
+			if (type == 'L') {
+				// GNU long name, for the next entry
+				extendedPath = ::readTarString(content.constData(), content.size());
+			} else if (type == 'x') {
+				::parsePaxHeader(content, extendedPath, extendedSize);
+			} else if (type != 'g') {
+				auto path = extendedPath.isEmpty() ? ::getTarHeaderPath(header.constData()) : extendedPath;
+				path.replace('\\', '/');
+				if (isFile && !path.endsWith('/')) {
+					// Checked before anything is written, the staging dir is inside the output dir
+					if (!ArchiveReader::isSafePath(path)) {
+						return false;
+					}
+					const TemplateFile info{static_cast<quint32>(mz_crc32(MZ_CRC32_INIT, reinterpret_cast<const mz_uint8*>(content.constData()), static_cast<size_t>(content.size()))), static_cast<quint64>(contentSize)};
+					auto stagedPath = this->stagingDir + '/' + path;
+					if (!sink.write(stagedPath, std::move(content))) {
+						return false;
+					}
+					if (const auto existing = indices.constFind(path); existing != indices.constEnd()) {
+						// A later entry with the same path replaces the earlier one, same as tar itself
+						this->files[*existing].info = info;
+					} else {
+						indices.insert(path, this->files.size());
+						this->files.push_back({std::move(path), info});
+						this->stagedPaths.push_back(std::move(stagedPath));
+					}
+				} else if (type == '1' || type == '2') {
+					// Links could point anywhere, so they aren't recreated
+					this->skippedLinks.push_back(std::move(path));
+				}
+				extendedPath.clear();
+				extendedSize.reset();
+			}
+			// Some writers leave the padding off the last entry
+			if (!stream.read((TAR_BLOCK_SIZE - contentSize % TAR_BLOCK_SIZE) % TAR_BLOCK_SIZE, nullptr)) {
+				break;
+			}
+		}
+		return true;
+	}
+};
+
+#endif
+
+} // namespace
+
+bool ArchiveReader::isSafePath(const QString& path) {
+	auto normalized = path;
+	normalized.replace('\\', '/');
+	// Absolute paths and drive letters ignore the output dir entirely, ".." climbs out of it
+	if (normalized.startsWith('/') || (normalized.size() >= 2 && normalized[1] == ':')) {
+		return false;
+	}
+	return !normalized.split('/').contains("..");
+}
+
+bool ArchiveReader::finishFileList() {
+	if (this->files.isEmpty()) {
+		return false;
+	}
+	QList<QStringList> pathSplits;
+	for (auto& file : this->files) {
+		if (!ArchiveReader::isSafePath(file.path)) {
+			return false;
+		}
+		file.path.replace('\\', '/');
+		pathSplits.push_back(file.path.split('/'));
+	}
+
+	// Find root dir(s) using probably the slowest algorithm ever
+	QStringList rootDirList;
+	while (true) {
+		bool allTheSame = true;
+		QString first = pathSplits[0][0];
+		for (const auto& path : pathSplits) {
+			if (path.length() == 1) {
+				allTheSame = false;
+				break;
+			}
+			if (path[0] != first) {
+				allTheSame = false;
+				break;
+			}
+		}
+		if (!allTheSame) {
+			break;
+		}
+		rootDirList.push_back(std::move(first));
+		for (auto& path : pathSplits) {
+			path.pop_front();
+		}
+	}
+
+	// Strip root dir(s), and the separator following them
+	if (const qsizetype rootDirLen = rootDirList.join('/').length(); !rootDirList.isEmpty()) {
+		for (auto& file : this->files) {
+			file.path = file.path.sliced(rootDirLen + 1);
+		}
+	}
+	return true;
+}
+
+std::unique_ptr<ArchiveReader> ArchiveReader::open(const QByteArray& archive, const QString& outputDir, ExtractionSink& sink, const ExtractProgressCallback& progress) {
+	if (::isZstd(archive)) {
+#ifdef SDK_LAUNCHER_USE_ZSTD
+		return TarZstdArchiveReader::open(archive, outputDir, sink, progress);
+#else
+		return nullptr;
+#endif
+	}
+	// Anything else is handed to miniz, which finds the central directory from the end (so self-extracting zips work too)
+	return ZIPArchiveReader::open(archive);
+}
+
+struct ZIPArchiveReader::State {
+	mz_zip_archive archive{};
+};
+
+ZIPArchiveReader::ZIPArchiveReader()
+		: state(std::make_unique<State>()) {}
+
+ZIPArchiveReader::~ZIPArchiveReader() {
+	mz_zip_reader_end(&this->state->archive);
+}
+
+bool ZIPArchiveReader::extract(qsizetype index, const QString& destination, ExtractionSink& sink) {
+	if (index < 0 || index >= this->indices.size()) {
+		return false;
+	}
+	// miniz checks the file's CRC-32 as part of extraction
+	QByteArray fileData;
+	fileData.resize(static_cast<qsizetype>(this->files[index].info.size));
+	if (!mz_zip_reader_extract_to_mem(&this->state->archive, this->indices[index], fileData.data(), fileData.size(), 0)) {
+		return false;
+	}
+	return sink.write(destination, std::move(fileData));
+}
+
+std::unique_ptr<ZIPArchiveReader> ZIPArchiveReader::open(const QByteArray& archive) {
+	std::unique_ptr<ZIPArchiveReader> reader{new ZIPArchiveReader};
+	reader->archive = archive;
+	if (!mz_zip_reader_init_mem(&reader->state->archive, reader->archive.constData(), reader->archive.size(), 0)) {
+		return nullptr;
+	}
+
+	const unsigned int fileCount = mz_zip_reader_get_num_files(&reader->state->archive);
+	for (mz_uint i = 0; i < fileCount; i++) {
+		if (mz_zip_reader_is_file_a_directory(&reader->state->archive, i)) {
+			continue;
+		}
+
+		mz_zip_archive_file_stat fileStat;
+		if (!mz_zip_reader_file_stat(&reader->state->archive, i, &fileStat)) {
+			return nullptr;
+		}
+		reader->files.push_back({fileStat.m_filename, {fileStat.m_crc32, fileStat.m_uncomp_size}});
+		reader->indices.push_back(i);
+	}
+	if (!reader->finishFileList()) {
+		return nullptr;
+	}
+	return reader;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <memory>
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+#include "Extract.h"
+
+/// Reads the files out of a mod template archive held in memory.
+/// Paths are relative to the root dir(s) shared by every file, and are never absolute or contain "..".
+class ArchiveReader {
+public:
+	struct File {
+		QString path;
+		TemplateFile info;
+	};
+
+	virtual ~ArchiveReader() = default;
+
+	/// Every file in the archive, in the order they're stored
+	[[nodiscard]] const QList<File>& getFiles() const { return this->files; }
+
+	/// Symbolic and hard links found in the archive, which aren't extracted
+	[[nodiscard]] const QStringList& getSkippedLinks() const { return this->skippedLinks; }
+
+	/// Writes a file to the destination path, by its index in getFiles()
+	[[nodiscard]] virtual bool extract(qsizetype index, const QString& destination, ExtractionSink& sink) = 0;
+
+	/// Picks a reader by looking at the first bytes of the archive. Returns nullptr if the format isn't recognized,
+	/// isn't supported by this build, the archive is damaged, or the progress callback cancelled it.
+	/// Archives that can only be read front to back are decompressed into a hidden staging dir inside the output dir
+	/// through the sink while they're opened, reporting progress, and extract() moves each file into place.
+	[[nodiscard]] static std::unique_ptr<ArchiveReader> open(const QByteArray& archive, const QString& outputDir, ExtractionSink& sink, const ExtractProgressCallback& progress = {});
+
+protected:
+	QList<File> files;
+	QStringList skippedLinks;
+
+	/// False for absolute paths, drive letters and paths containing ".."
+	[[nodiscard]] static bool isSafePath(const QString& path);
+
+	/// Strips the root dir(s) shared by every file, and returns false if there are no files or a path is unsafe
+	[[nodiscard]] bool finishFileList();
+};
+
+/// ZIP archives through miniz, which checks each file's CRC-32 as it is extracted.
+class ZIPArchiveReader : public ArchiveReader {
+public:
+	~ZIPArchiveReader() override;
+
+	[[nodiscard]] bool extract(qsizetype index, const QString& destination, ExtractionSink& sink) override;
+
+	[[nodiscard]] static std::unique_ptr<ZIPArchiveReader> open(const QByteArray& archive);
+
+private:
+	ZIPArchiveReader();
+
+	/// Kept alive for miniz, which reads straight out of it
+	QByteArray archive;
+	QList<quint32> indices;
+	struct State;
+	std::unique_ptr<State> state;
+};
@@ -0,0 +1,68 @@
+#include "CommandPreflight.h"
+
+#include <QDateTime>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QStandardPaths>
+#include <QtConcurrent>
+
+namespace {
+
+struct CacheEntry {
+	QDateTime directoryModified;
+	CommandPreflight::Result result;
+};
+
+QMutex g_cacheMutex;
+QHash<QString, CacheEntry> g_cache;
+
+[[nodiscard]] QString getExecutablePath(const QString& action) {
+#ifdef _WIN32
+	// QProcess appends .exe on Windows if the program has no suffix
+	if (QFileInfo{action}.suffix().isEmpty()) {
+		return action + ".exe";
+	}
+#endif
+	return action;
+}
+
+} // namespace
+
+CommandPreflight::Result CommandPreflight::check(const QString& action) {
+	const auto path = ::getExecutablePath(action);
+
+	// Bare program names are looked up in PATH by QProcess
+	if (!path.contains('/') && !path.contains('\\')) {
+		if (auto found = QStandardPaths::findExecutable(path); !found.isEmpty()) {
+			return {Status::OK, std::move(found), {}};
+		}
+		return {Status::MISSING, path, QObject::tr("The program \"%1\" could not be found in PATH.").arg(path)};
+	}
+
+	const QFileInfo info{path};
+	const auto directoryModified = QFileInfo{info.absolutePath()}.lastModified();
+	{
+		QMutexLocker lock{&g_cacheMutex};
+		if (const auto it = g_cache.constFind(path); it != g_cache.constEnd() && it->directoryModified == directoryModified) {
+			return it->result;
+		}
+	}
+
+	Result result{Status::OK, path, {}};
+	if (!info.exists()) {
+		result.status = Status::MISSING;
+		result.reason = QObject::tr("The executable \"%1\" does not exist.").arg(path);
+	} else if (!info.isFile() || !info.isExecutable()) {
+		result.status = Status::NOT_EXECUTABLE;
+		result.reason = QObject::tr("The file \"%1\" is not executable.").arg(path);
+	}
+
+	QMutexLocker lock{&g_cacheMutex};
+	g_cache[path] = {directoryModified, result};
+	return result;
+}
+
+QFuture<CommandPreflight::Result> CommandPreflight::checkAll(QStringList actions) {
+	return QtConcurrent::mapped(std::move(actions), &CommandPreflight::check);
+}
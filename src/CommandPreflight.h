@@ -0,0 +1,28 @@
+#pragma once
+
+#include <QFuture>
+#include <QString>
+#include <QStringList>
+
+namespace CommandPreflight {
+
+enum class Status : unsigned char {
+	OK,
+	MISSING,
+	NOT_EXECUTABLE,
+};
+
+struct Result {
+	Status status;
+	QString path;
+	QString reason;
+};
+
+/// Checks that the file a command action points to exists and can be executed.
+/// Results are cached until the directory containing the executable changes.
+[[nodiscard]] Result check(const QString& action);
+
+/// Runs check() over every action on the global thread pool. Results are in the same order as the actions.
+[[nodiscard]] QFuture<Result> checkAll(QStringList actions);
+
+} // namespace CommandPreflight
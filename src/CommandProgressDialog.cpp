@@ -0,0 +1,200 @@
+#include "CommandProgressDialog.h"
+
+#include <algorithm>
+
+#include <QDialogButtonBox>
+#include <QFontDatabase>
+#include <QLabel>
+#include <QPlainTextEdit>
+#include <QProcess>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QTimer>
+#include <QVBoxLayout>
+
+namespace {
+
+/// Estimates from progress are too noisy to show before this much of it is done
+constexpr double MIN_ESTIMATE_FRACTION = 0.02;
+
+[[nodiscard]] QString formatDuration(qint64 ms) {
+	const auto seconds = ms / 1000;
+	if (seconds < 60) {
+		return QObject::tr("%1s").arg(seconds);
+	}
+	if (seconds < 60 * 60) {
+		return QObject::tr("%1m %2s").arg(seconds / 60).arg(seconds % 60);
+	}
+	return QObject::tr("%1h %2m").arg(seconds / (60 * 60)).arg(seconds / 60 % 60);
+}
+
+} // namespace
+
+CommandProgressDialog::CommandProgressDialog(QProcess* process_, const QString& title, const GameConfig::Command& command, std::optional<qint64> expectedRunTimeMs_, QWidget* parent)
+		: QDialog(parent)
+		, process(process_)
+		, parser(command.progressPattern, command.progressMax, command.progressPhasePattern)
+		, hasPhases(!command.progressPhasePattern.isEmpty())
+		, expectedRunTimeMs(expectedRunTimeMs_) {
+	// Window setup
+	this->setModal(false);
+	this->setWindowTitle(title);
+	this->setMinimumSize(480, 320);
+
+	// Create UI elements
+	auto* layout = new QVBoxLayout{this};
+
+	this->phase = new QLabel{tr("Starting..."), this};
+	layout->addWidget(this->phase);
+
+	this->progress = new QProgressBar{this};
+	this->progress->setRange(0, this->parser.getMax());
+	this->progress->setValue(0);
+	layout->addWidget(this->progress);
+
+	this->time = new QLabel{this};
+	layout->addWidget(this->time);
+
+	this->log = new QPlainTextEdit{this};
+	this->log->setReadOnly(true);
+	this->log->setMaximumBlockCount(MAX_LOG_LINES);
+	this->log->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+	layout->addWidget(this->log, 1);
+
+	auto* buttonBox = new QDialogButtonBox{QDialogButtonBox::Close, Qt::Horizontal, this};
+	this->cancel = buttonBox->addButton(tr("Cancel Command"), QDialogButtonBox::DestructiveRole);
+	layout->addWidget(buttonBox);
+
+	this->timeUpdate = new QTimer{this};
+	this->timeUpdate->setInterval(1000);
+
+	QObject::connect(this->process, &QProcess::started, this, [this] {
+		this->runTimer.start();
+		this->phaseTimer.start();
+		if (!this->hasPhases) {
+			this->phase->setText(tr("Running..."));
+		}
+		this->timeUpdate->start();
+		this->updateTime();
+	});
+	QObject::connect(this->process, &QProcess::readyReadStandardOutput, this, &CommandProgressDialog::readOutput);
+	QObject::connect(this->process, &QProcess::finished, this, [this](int exitCode, QProcess::ExitStatus exitStatus) {
+		this->readOutput();
+		const auto elapsed = ::formatDuration(this->runTimer.elapsed());
+		if (this->cancelled) {
+			this->finish(tr("Cancelled after %1.").arg(elapsed));
+		} else if (exitStatus == QProcess::CrashExit) {
+			this->finish(tr("Crashed after %1.").arg(elapsed));
+		} else if (exitCode != 0) {
+			this->finish(tr("Failed with exit code %1 after %2.").arg(exitCode).arg(elapsed));
+		} else {
+			this->progress->setValue(this->progress->maximum());
+			this->finish(tr("Finished in %1.").arg(elapsed));
+		}
+	});
+	QObject::connect(this->process, &QProcess::errorOccurred, this, [this](QProcess::ProcessError code) {
+		if (code == QProcess::FailedToStart) {
+			this->finish(tr("Failed to start."));
+		}
+	});
+
+	// Asked to exit first so tools get a chance to clean up, then killed if they don't
+	QObject::connect(this->cancel, &QPushButton::clicked, this, [this] {
+		this->cancelled = true;
+		this->cancel->setEnabled(false);
+		this->phase->setText(tr("Cancelling..."));
+		this->process->setProperty(CANCELLED_PROPERTY, true);
+		this->process->terminate();
+		QTimer::singleShot(CANCEL_GRACE_MS, this->process, [process = this->process] {
+			if (process->state() != QProcess::NotRunning) {
+				process->kill();
+			}
+		});
+	});
+	QObject::connect(buttonBox, &QDialogButtonBox::rejected, this, &CommandProgressDialog::reject);
+	QObject::connect(this->timeUpdate, &QTimer::timeout, this, &CommandProgressDialog::updateTime);
+
+	// Closing the dialog while the command runs only hides it
+	QObject::connect(this, &QDialog::finished, this, [this] {
+		if (this->commandFinished) {
+			this->deleteLater();
+		}
+	});
+}
+
+bool CommandProgressDialog::wasCancelled(const QProcess* process) {
+	return process->property(CANCELLED_PROPERTY).toBool();
+}
+
+void CommandProgressDialog::readOutput() {
+	const auto output = this->decoder.decode(this->process->readAllStandardOutput());
+	if (output.isEmpty()) {
+		return;
+	}
+	this->log->moveCursor(QTextCursor::End);
+	this->log->insertPlainText(output);
+	this->log->ensureCursorVisible();
+
+	const auto previousPhase = this->parser.getPhase();
+	if (!this->parser.feed(output)) {
+		return;
+	}
+	if (this->hasPhases && this->parser.getPhase() != previousPhase) {
+		this->phase->setText(this->parser.getPhase());
+		this->phaseTimer.restart();
+	}
+	this->progress->setValue(this->parser.getValue());
+	this->updateTime();
+}
+
+void CommandProgressDialog::updateTime() {
+	if (!this->runTimer.isValid() || this->commandFinished) {
+		return;
+	}
+	const auto elapsed = this->runTimer.elapsed();
+	const auto fraction = this->parser.getFraction();
+	QString text = tr("Elapsed: %1").arg(::formatDuration(elapsed));
+
+	// Steps don't say how many of them are left, so only the current one can be estimated
+	if (this->hasPhases) {
+		if (fraction >= MIN_ESTIMATE_FRACTION && fraction < 1.0) {
+			const auto phaseElapsed = this->phaseTimer.elapsed();
+			text += tr(", about %1 left in this step").arg(::formatDuration(static_cast<qint64>(static_cast<double>(phaseElapsed) * (1.0 - fraction) / fraction)));
+		} else if (this->expectedRunTimeMs) {
+			text += tr(", usually takes %1").arg(::formatDuration(*this->expectedRunTimeMs));
+		}
+		this->time->setText(text);
+		return;
+	}
+
+	// Previous runs are all there is to go on at first, and the progress is trusted more the further along it is
+	std::optional<qint64> remaining;
+	const auto fromHistory = this->expectedRunTimeMs ? std::optional{std::max<qint64>(*this->expectedRunTimeMs - elapsed, 0)} : std::nullopt;
+	if (fraction >= MIN_ESTIMATE_FRACTION) {
+		const auto fromProgress = static_cast<double>(elapsed) * (1.0 - fraction) / fraction;
+		remaining = static_cast<qint64>(fromHistory ? fraction * fromProgress + (1.0 - fraction) * static_cast<double>(*fromHistory) : fromProgress);
+	} else {
+		remaining = fromHistory;
+	}
+	if (fraction < MIN_ESTIMATE_FRACTION && fromHistory == 0) {
+		text += tr(", taking longer than usual");
+	} else if (remaining) {
+		text += tr(", about %1 left").arg(::formatDuration(*remaining));
+	}
+	this->time->setText(text);
+}
+
+void CommandProgressDialog::finish(const QString& status) {
+	if (this->commandFinished) {
+		return;
+	}
+	this->commandFinished = true;
+	this->timeUpdate->stop();
+	this->cancel->setEnabled(false);
+	this->phase->setText(status);
+	this->time->clear();
+
+	if (!this->isVisible()) {
+		this->deleteLater();
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <optional>
+
+#include <QDialog>
+#include <QElapsedTimer>
+#include <QStringDecoder>
+
+#include "GameConfig.h"
+#include "ProgressParser.h"
+
+class QLabel;
+class QPlainTextEdit;
+class QProcess;
+class QProgressBar;
+class QPushButton;
+class QTimer;
+
+/// Follows the output of a long running command like a map compile, showing its progress and the time left.
+/// The dialog isn't modal and closing it leaves the command running, it deletes itself once it's closed after the
+/// command finishes.
+class CommandProgressDialog : public QDialog {
+	Q_OBJECT;
+
+public:
+	/// Must be created before the process is started. The process's output channels should be merged, or the
+	/// progress is only read from stdout.
+	CommandProgressDialog(QProcess* process, const QString& title, const GameConfig::Command& command, std::optional<qint64> expectedRunTimeMs, QWidget* parent = nullptr);
+
+	/// True if the process was stopped with the cancel button, so it exiting from a signal isn't a crash
+	[[nodiscard]] static bool wasCancelled(const QProcess* process);
+
+private:
+	/// A terminated process gets this long to exit before it's killed
+	static constexpr int CANCEL_GRACE_MS = 3000;
+
+	/// Set on the process before it's terminated
+	static constexpr auto CANCELLED_PROPERTY = "sdkLauncherCancelled";
+
+	/// Lines of output kept in the log
+	static constexpr int MAX_LOG_LINES = 500;
+
+	QProcess* process;
+	ProgressParser parser;
+	bool hasPhases;
+	std::optional<qint64> expectedRunTimeMs;
+	QStringDecoder decoder{QStringDecoder::System};
+	QElapsedTimer runTimer;
+	QElapsedTimer phaseTimer;
+	bool cancelled = false;
+	bool commandFinished = false;
+
+	QLabel* phase;
+	QProgressBar* progress;
+	QLabel* time;
+	QPlainTextEdit* log;
+	QPushButton* cancel;
+	QTimer* timeUpdate;
+
+	void readOutput();
+
+	void updateTime();
+
+	void finish(const QString& status);
+};
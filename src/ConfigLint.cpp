@@ -0,0 +1,177 @@
+#include "ConfigLint.h"
+
+#include <algorithm>
+
+#include <QCommandLineParser>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QSet>
+#include <QTextStream>
+#include <QtConcurrent>
+
+#include "CommandPreflight.h"
+#include "GameConfig.h"
+#include "Steam.h"
+
+namespace {
+
+/// Substituted when a command is started rather than when the config is loaded
+const QSet<QString> LAUNCH_VARIABLES{"INSTANCE", "INSTANCE_COUNT", "PORT"};
+
+/// Every ${VAR} in the string that isn't substituted at launch
+[[nodiscard]] QStringList getUnresolvedVariables(const QString& str) {
+	static const QRegularExpression variable{R"(\$\{([^}]*)\})"};
+	QStringList out;
+	for (const auto& match : variable.globalMatch(str)) {
+		if (auto name = match.captured(1); !LAUNCH_VARIABLES.contains(name) && !out.contains(name)) {
+			out.push_back(std::move(name));
+		}
+	}
+	return out;
+}
+
+[[nodiscard]] QStringList findConfigs(const QStringList& targets, QList<ConfigLint::Diagnostic>& missing) {
+	QStringList out;
+	for (const auto& target : targets) {
+		const QFileInfo info{target};
+		if (info.isDir()) {
+			QStringList found;
+			QDirIterator it{info.absoluteFilePath(), {"*.json"}, QDir::Files, QDirIterator::Subdirectories};
+			while (it.hasNext()) {
+				found.push_back(it.next());
+			}
+			// Directory order isn't stable, and the output should diff cleanly between runs
+			std::sort(found.begin(), found.end());
+			out += found;
+		} else if (info.isFile()) {
+			out.push_back(info.absoluteFilePath());
+		} else {
+			missing.push_back({target, 0, 0, true, QObject::tr("No such file or directory")});
+		}
+	}
+	out.removeDuplicates();
+	return out;
+}
+
+void print(QTextStream& out, const ConfigLint::Diagnostic& diagnostic) {
+	out << QDir::toNativeSeparators(diagnostic.file) << ':';
+	if (diagnostic.line > 0) {
+		out << diagnostic.line << ':' << diagnostic.column << ':';
+	}
+	out << (diagnostic.error ? " error: " : " warning: ") << diagnostic.message << '\n';
+}
+
+} // namespace
+
+QList<ConfigLint::Diagnostic> ConfigLint::lint(const QString& path, const QString& rootPath) {
+	QList<Diagnostic> out;
+
+	// Anything parsing skips is a problem here, even if the rest of the config still loads
+	QList<GameConfig::Diagnostic> parseDiagnostics;
+	auto gameConfig = GameConfig::parse(path, &parseDiagnostics);
+	for (const auto& [line, column, message, file] : parseDiagnostics) {
+		out.push_back({file.isEmpty() ? path : file, line, column, !gameConfig, message});
+	}
+	if (!gameConfig) {
+		if (out.isEmpty()) {
+			out.push_back({path, 0, 0, true, QObject::tr("Invalid game configuration")});
+		}
+		return out;
+	}
+
+	// The same variables the launcher substitutes, icons are only checked for unknown variables
+	gameConfig->setVariable("SOURCEMODS", ::getSourceModsDir());
+	gameConfig->setVariable("ROOT", rootPath.isEmpty() ? ::getRootPath(gameConfig->getUsesLegacyBinDir()) : rootPath);
+#if defined(_WIN32)
+	gameConfig->setVariable("PLATFORM", "win64");
+#elif defined(__APPLE__)
+	gameConfig->setVariable("PLATFORM", "osx64");
+#elif defined(__linux__)
+	gameConfig->setVariable("PLATFORM", "linux64");
+#endif
+	gameConfig->setVariable("STRATA_ICON", ":/icons/strata_light.png");
+	gameConfig->setVariable("SDKLAUNCHER_ICON", ":/icons/strata_light.png");
+	gameConfig->setVariable("GAME", gameConfig->getGameDefault());
+	gameConfig->setVariable("GAME_ICON", gameConfig->getGameIcon());
+
+	for (const auto& section : gameConfig->getSections()) {
+		const auto& sectionName = gameConfig->getString(section.name);
+		for (const auto& entry : gameConfig->getEntries(section)) {
+			const auto& entryName = gameConfig->getString(entry.name);
+			const auto report = [&](const QString& message) {
+				out.push_back({path, 0, 0, true, QObject::tr("Entry \"%1\" in section \"%2\": %3").arg(entryName, sectionName, message)});
+			};
+
+			const auto command = gameConfig->getCommand(entry);
+			QStringList unresolved = ::getUnresolvedVariables(command.action);
+			const auto actionResolved = unresolved.isEmpty();
+			for (const auto& argument : command.arguments) {
+				unresolved += ::getUnresolvedVariables(argument);
+			}
+			for (const auto& value : command.environment) {
+				unresolved += ::getUnresolvedVariables(value);
+			}
+			unresolved += ::getUnresolvedVariables(gameConfig->getString(entry.iconOverride));
+			unresolved.removeDuplicates();
+			for (const auto& variable : unresolved) {
+				report(QObject::tr("unknown variable ${%1}").arg(variable));
+			}
+
+			if (entry.type == GameConfig::ActionType::COMMAND && actionResolved) {
+				if (const auto result = CommandPreflight::check(command.action); result.status != CommandPreflight::Status::OK) {
+					report(result.reason);
+				}
+			}
+		}
+	}
+	return out;
+}
+
+int ConfigLint::run(const QStringList& arguments) {
+	QCommandLineParser parser;
+	parser.setApplicationDescription(QObject::tr("Checks game configs for problems without opening the launcher."));
+	parser.addHelpOption();
+	parser.addOption({"lint", QObject::tr("Lint the given configs, and directories of configs.")});
+	parser.addOption({"root", QObject::tr("The path substituted for ${ROOT}, defaults to the launcher's root."), QObject::tr("dir")});
+	parser.addPositionalArgument("paths", QObject::tr("Config files, or directories to search for .json files."), QObject::tr("<dir|files...>"));
+
+	QTextStream err{stderr};
+	if (!parser.parse(arguments)) {
+		err << parser.errorText() << '\n';
+		return 2;
+	}
+	if (parser.isSet("help")) {
+		err << parser.helpText();
+		return 0;
+	}
+	if (parser.positionalArguments().isEmpty()) {
+		err << QObject::tr("No configs given to lint.") << '\n';
+		return 2;
+	}
+
+	QList<Diagnostic> missing;
+	const auto configs = ::findConfigs(parser.positionalArguments(), missing);
+	const auto rootPath = parser.value("root");
+	const auto results = QtConcurrent::blockingMapped(configs, [&rootPath](const QString& path) {
+		return ConfigLint::lint(path, rootPath);
+	});
+
+	// Printed in the order the configs were found, so the output is the same every run
+	QTextStream out{stdout};
+	for (const auto& diagnostic : missing) {
+		::print(out, diagnostic);
+	}
+	qsizetype failed = 0;
+	for (const auto& diagnostics : results) {
+		for (const auto& diagnostic : diagnostics) {
+			::print(out, diagnostic);
+		}
+		failed += !diagnostics.isEmpty();
+	}
+	out.flush();
+
+	err << QObject::tr("Linted %1 config(s), %2 with problems.").arg(configs.size()).arg(failed) << '\n';
+	return failed > 0 || !missing.isEmpty() ? 1 : 0;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+
+namespace ConfigLint {
+
+struct Diagnostic {
+	QString file;
+	/// 0 if the problem isn't tied to a location in the file
+	int line;
+	int column;
+	/// The config couldn't be loaded at all, or something in it can't work (a missing executable, an unknown variable)
+	bool error;
+	QString message;
+};
+
+/// Finds every problem with a config that the launcher would otherwise skip over silently: schema errors, unknown
+/// types and OS names, variables left unresolved after substitution and missing executables. Only entries for the
+/// OS the launcher is running on are checked past parsing. ${ROOT} is the given root, or the launcher's own root.
+[[nodiscard]] QList<Diagnostic> lint(const QString& path, const QString& rootPath = {});
+
+/// Headless entry point for "--lint <dir|files...>", with the arguments including the program name.
+/// Directories are searched recursively for .json files, and every config is linted concurrently on the global
+/// thread pool. Diagnostics are printed to stdout one per line as "file:line:column: error|warning: message".
+/// Returns the process exit code: 0 if every config is clean, 1 if any had problems, 2 for a usage error.
+[[nodiscard]] int run(const QStringList& arguments);
+
+} // namespace ConfigLint
@@ -0,0 +1,371 @@
+#include "CrashCollector.h"
+
+#include <algorithm>
+#include <utility>
+
+#include <miniz.h>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QSysInfo>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include "Config.h"
+
+namespace {
+
+constexpr auto INDEX_FILE = "index.json";
+
+QMutex g_indexMutex;
+
+[[nodiscard]] QThreadPool& getCollectorPool() {
+	// One thread, so a crash loop can't have several multi-gigabyte dumps compressing at once
+	static auto* pool = [] {
+		auto* p = new QThreadPool;
+		p->setMaxThreadCount(1);
+		return p;
+	}();
+	return *pool;
+}
+
+struct Artifact {
+	QString path;
+	/// Name inside the archive
+	QString name;
+	/// Raw dumps next to the game are only taking up space once they're archived
+	bool removeAfter = false;
+};
+
+[[nodiscard]] bool isFromLaunch(const QFileInfo& info, qint64 startedAt) {
+	// Some filesystems only store timestamps with a 2 second resolution
+	return info.isFile() && info.isReadable() && info.lastModified().toMSecsSinceEpoch() >= startedAt - 2000;
+}
+
+#ifndef _WIN32
+[[nodiscard]] bool isCoreFile(const QString& name) {
+	// "core" or "core.<pid>", other core.* files in the game directory are game content
+	if (name == "core") {
+		return true;
+	}
+	if (!name.startsWith("core.") || name.size() == 5) {
+		return false;
+	}
+	return std::all_of(name.begin() + 5, name.end(), [](QChar c) { return c.isDigit(); });
+}
+#endif
+
+void addArtifacts(QList<Artifact>& artifacts, const QString& dir, const QStringList& nameFilters, qint64 startedAt, bool removeAfter, bool(*filter)(const QString&) = nullptr) {
+	for (const auto& info : QDir{dir}.entryInfoList(nameFilters, QDir::Files)) {
+		if (!::isFromLaunch(info, startedAt) || (filter && !filter(info.fileName()))) {
+			continue;
+		}
+		const auto path = info.absoluteFilePath();
+		if (std::any_of(artifacts.begin(), artifacts.end(), [&path](const Artifact& artifact) { return artifact.path == path; })) {
+			continue;
+		}
+		artifacts.push_back({path, "dumps/" + info.fileName(), removeAfter});
+	}
+}
+
+[[nodiscard]] QList<Artifact> findArtifacts(const CrashCollector::Request& request) {
+	QStringList dirs;
+	for (const auto& dir : {request.workingDirectory, QFileInfo{request.program}.absolutePath(), request.gameDir}) {
+		if (const auto cleanDir = QDir::cleanPath(dir); !dir.isEmpty() && !dirs.contains(cleanDir)) {
+			dirs.push_back(cleanDir);
+		}
+	}
+	const auto exeName = QFileInfo{request.program}.completeBaseName();
+
+	QList<Artifact> artifacts;
+#if defined(_WIN32)
+	for (const auto& dir : dirs) {
+		::addArtifacts(artifacts, dir, {"*.mdmp", "*.dmp"}, request.startedAt, true);
+	}
+	// Windows Error Reporting writes here when LocalDumps is turned on
+	if (const auto localAppData = qEnvironmentVariable("LOCALAPPDATA"); !localAppData.isEmpty()) {
+		::addArtifacts(artifacts, localAppData + "/CrashDumps", {exeName + "*.dmp"}, request.startedAt, false);
+	}
+#else
+	for (const auto& dir : dirs) {
+		::addArtifacts(artifacts, dir, {"core", "core.*"}, request.startedAt, true, &::isCoreFile);
+	}
+#if defined(__APPLE__)
+	::addArtifacts(artifacts, QDir::homePath() + "/Library/Logs/DiagnosticReports", {exeName + "*.ips", exeName + "*.crash"}, request.startedAt, false);
+#else
+	// Cores piped to systemd-coredump are already compressed, and only readable if the user is allowed to
+	::addArtifacts(artifacts, "/var/lib/systemd/coredump", {"core." + exeName + ".*"}, request.startedAt, false);
+#endif
+#endif
+
+	for (const auto& dir : {request.gameDir, request.workingDirectory}) {
+		if (const QFileInfo consoleLog{dir + "/console.log"}; !dir.isEmpty() && ::isFromLaunch(consoleLog, request.startedAt)) {
+			artifacts.push_back({consoleLog.absoluteFilePath(), "console.log", false});
+			break;
+		}
+	}
+	return artifacts;
+}
+
+[[nodiscard]] QByteArray describeRequest(const CrashCollector::Request& request) {
+	QStringList arguments;
+	for (const auto& argument : request.arguments) {
+		arguments.push_back(argument.contains(' ') ? '"' + argument + '"' : argument);
+	}
+	QString out;
+	out += "Program: " + request.program + '\n';
+	out += "Arguments: " + arguments.join(' ') + '\n';
+	out += "Working directory: " + request.workingDirectory + '\n';
+	out += "Game directory: " + request.gameDir + '\n';
+	out += "Exit code: " + QString::number(request.exitCode) + '\n';
+	out += "Started: " + QDateTime::fromMSecsSinceEpoch(request.startedAt).toString(Qt::ISODate) + '\n';
+	out += "System: " + QSysInfo::prettyProductName() + " (" + QSysInfo::kernelVersion() + ")\n";
+	out += QString{"Launcher: %1\n"}.arg(PROJECT_TITLE.data());
+	if (!request.environment.isEmpty()) {
+		out += "Environment:\n";
+		for (const auto& [key, value] : request.environment.asKeyValueRange()) {
+			out += "  " + key + '=' + value + '\n';
+		}
+	}
+	return out.toUtf8();
+}
+
+// miniz is built without stdio, so the archive is written through QFile
+size_t writeToFile(void* opaque, mz_uint64 offset, const void* data, size_t size) {
+	auto* file = static_cast<QFile*>(opaque);
+	if (file->pos() != static_cast<qint64>(offset) && !file->seek(static_cast<qint64>(offset))) {
+		return 0;
+	}
+	return static_cast<size_t>(std::max<qint64>(file->write(static_cast<const char*>(data), static_cast<qint64>(size)), 0));
+}
+
+enum class AddResult : unsigned char {
+	ADDED,
+	/// The artifact couldn't be read, the rest of the report is still worth having
+	SKIPPED,
+	/// The archive itself is broken
+	FAILED,
+};
+
+[[nodiscard]] AddResult addArtifact(mz_zip_archive& zip, const Artifact& artifact, CrashCollector::Report& report) {
+	QFile file{artifact.path};
+	if (!file.open(QIODevice::ReadOnly)) {
+		return AddResult::SKIPPED;
+	}
+	// Mapped instead of read, so multi-gigabyte cores are paged in as they're compressed
+	const auto size = file.size();
+	const auto* data = size > 0 ? file.map(0, size) : nullptr;
+	if (size > 0 && !data) {
+		return AddResult::SKIPPED;
+	}
+	// Dumps are mostly empty pages, the fastest level already shrinks them by an order of magnitude
+	const auto level = artifact.name.startsWith("dumps/") ? MZ_BEST_SPEED : MZ_DEFAULT_COMPRESSION;
+	if (!mz_zip_writer_add_mem(&zip, artifact.name.toUtf8().constData(), data, static_cast<size_t>(size), level)) {
+		return AddResult::FAILED;
+	}
+	report.files.push_back(artifact.name);
+	report.uncompressedSize += size;
+	return AddResult::ADDED;
+}
+
+[[nodiscard]] bool writeArchive(const QString& path, const QByteArray& description, const QList<Artifact>& artifacts, CrashCollector::Report& report) {
+	QFile file{path};
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		return false;
+	}
+	mz_zip_archive zip{};
+	zip.m_pWrite = &::writeToFile;
+	zip.m_pIO_opaque = &file;
+	// Cores can go past 4 GiB
+	if (!mz_zip_writer_init_v2(&zip, 0, MZ_ZIP_FLAG_WRITE_ZIP64)) {
+		return false;
+	}
+	bool ok = mz_zip_writer_add_mem(&zip, "command.txt", description.constData(), description.size(), MZ_DEFAULT_COMPRESSION);
+	if (ok) {
+		report.files.push_back("command.txt");
+		report.uncompressedSize += description.size();
+	}
+	QString skipped;
+	for (const auto& artifact : artifacts) {
+		if (!ok) {
+			break;
+		}
+		switch (::addArtifact(zip, artifact, report)) {
+			case AddResult::ADDED:
+				break;
+			case AddResult::SKIPPED:
+				skipped += artifact.path + '\n';
+				break;
+			case AddResult::FAILED:
+				ok = false;
+				break;
+		}
+	}
+	// Whoever opens the report should know something is missing from it, and where to look for it
+	if (ok && !skipped.isEmpty()) {
+		const auto note = ("These files were found but couldn't be read:\n" + skipped).toUtf8();
+		ok = mz_zip_writer_add_mem(&zip, "skipped.txt", note.constData(), note.size(), MZ_DEFAULT_COMPRESSION);
+		if (ok) {
+			report.files.push_back("skipped.txt");
+			report.uncompressedSize += note.size();
+		}
+	}
+	ok = ok && mz_zip_writer_finalize_archive(&zip);
+	mz_zip_writer_end(&zip);
+	return ok;
+}
+
+[[nodiscard]] QJsonObject toJSON(const CrashCollector::Report& report) {
+	return {
+		{"archive", report.archive},
+		{"time", static_cast<double>(report.time)},
+		{"program", report.program},
+		{"arguments", QJsonArray::fromStringList(report.arguments)},
+		{"exit_code", report.exitCode},
+		{"files", QJsonArray::fromStringList(report.files)},
+		{"size", static_cast<double>(report.size)},
+		{"uncompressed_size", static_cast<double>(report.uncompressedSize)},
+	};
+}
+
+[[nodiscard]] CrashCollector::Report fromJSON(const QJsonObject& object) {
+	CrashCollector::Report report;
+	report.archive = object["archive"].toString();
+	report.time = static_cast<qint64>(object["time"].toDouble());
+	report.program = object["program"].toString();
+	for (const auto& argument : object["arguments"].toArray()) {
+		report.arguments.push_back(argument.toString());
+	}
+	report.exitCode = object["exit_code"].toInt();
+	for (const auto& file : object["files"].toArray()) {
+		report.files.push_back(file.toString());
+	}
+	report.size = static_cast<qint64>(object["size"].toDouble());
+	report.uncompressedSize = static_cast<qint64>(object["uncompressed_size"].toDouble());
+	return report;
+}
+
+/// Must be called with the index mutex held. Archives that were deleted by hand are left out.
+[[nodiscard]] QList<CrashCollector::Report> readIndex(const QDir& crashDir) {
+	QFile file{crashDir.filePath(INDEX_FILE)};
+	if (!file.open(QIODevice::ReadOnly)) {
+		return {};
+	}
+	QList<CrashCollector::Report> reports;
+	for (const auto& entry : QJsonDocument::fromJson(file.readAll()).array()) {
+		if (auto report = ::fromJSON(entry.toObject()); !report.archive.isEmpty() && crashDir.exists(report.archive)) {
+			reports.push_back(std::move(report));
+		}
+	}
+	std::sort(reports.begin(), reports.end(), [](const CrashCollector::Report& lhs, const CrashCollector::Report& rhs) {
+		return lhs.time > rhs.time;
+	});
+	return reports;
+}
+
+/// Must be called with the index mutex held
+void writeIndex(const QDir& crashDir, const QList<CrashCollector::Report>& reports) {
+	QJsonArray entries;
+	for (const auto& report : reports) {
+		entries.push_back(::toJSON(report));
+	}
+	QSaveFile file{crashDir.filePath(INDEX_FILE)};
+	if (!file.open(QIODevice::WriteOnly)) {
+		return;
+	}
+	file.write(QJsonDocument{entries}.toJson());
+	(void) file.commit();
+}
+
+/// Removes the oldest archives until the rest fit in the budget. The newest crash is kept even if it's over on its own.
+void enforceBudget(const QDir& crashDir, QList<CrashCollector::Report>& reports, qint64 budget) {
+	qint64 total = 0;
+	for (qsizetype i = 0; i < reports.size(); i++) {
+		total += reports[i].size;
+		if (i == 0 || total <= budget) {
+			continue;
+		}
+		for (qsizetype j = i; j < reports.size(); j++) {
+			(void) QFile::remove(crashDir.filePath(reports[j].archive));
+		}
+		reports.resize(i);
+		break;
+	}
+}
+
+} // namespace
+
+QString CrashCollector::getCrashDir() {
+	return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + QDir::separator() + "crashes";
+}
+
+QList<CrashCollector::Report> CrashCollector::getReports() {
+	const QMutexLocker lock{&g_indexMutex};
+	return ::readIndex(QDir{getCrashDir()});
+}
+
+QFuture<std::optional<CrashCollector::Report>> CrashCollector::collect(Request request, int budgetMB) {
+	return QtConcurrent::run(&::getCollectorPool(), [request = std::move(request), budgetMB]() -> std::optional<Report> {
+		const QDir crashDir{getCrashDir()};
+		if (!crashDir.mkpath(".")) {
+			return std::nullopt;
+		}
+
+		const auto now = QDateTime::currentDateTime();
+		Report report;
+		report.time = now.toMSecsSinceEpoch();
+		report.program = request.program;
+		report.arguments = request.arguments;
+		report.exitCode = request.exitCode;
+		const auto baseName = QString{"crash_%1_%2"}.arg(now.toString("yyyyMMdd-HHmmss"), QFileInfo{request.program}.completeBaseName());
+		report.archive = baseName + ".zip";
+		for (int i = 2; crashDir.exists(report.archive); i++) {
+			report.archive = QString{"%1_%2.zip"}.arg(baseName).arg(i);
+		}
+
+		// Written under a temporary name so a half-written archive never shows up in the index
+		const auto artifacts = ::findArtifacts(request);
+		const auto partialPath = crashDir.filePath(report.archive + ".part");
+		if (!::writeArchive(partialPath, ::describeRequest(request), artifacts, report) || !QFile::rename(partialPath, crashDir.filePath(report.archive))) {
+			(void) QFile::remove(partialPath);
+			return std::nullopt;
+		}
+		report.size = QFileInfo{crashDir.filePath(report.archive)}.size();
+
+		// Skipped artifacts are left where they are, they're the only copy
+		for (const auto& artifact : artifacts) {
+			if (artifact.removeAfter && report.files.contains(artifact.name)) {
+				(void) QFile::remove(artifact.path);
+			}
+		}
+
+		const QMutexLocker lock{&g_indexMutex};
+		auto reports = ::readIndex(crashDir);
+		reports.push_front(report);
+		::enforceBudget(crashDir, reports, static_cast<qint64>(budgetMB) * 1024 * 1024);
+		::writeIndex(crashDir, reports);
+		return report;
+	});
+}
+
+bool CrashCollector::remove(const QString& archive) {
+	// Only ever delete files inside the crash directory
+	if (archive.isEmpty() || QFileInfo{archive}.fileName() != archive) {
+		return false;
+	}
+	const QDir crashDir{getCrashDir()};
+	const QMutexLocker lock{&g_indexMutex};
+	auto reports = ::readIndex(crashDir);
+	reports.removeIf([&archive](const Report& report) {
+		return report.archive == archive;
+	});
+	::writeIndex(crashDir, reports);
+	return !crashDir.exists(archive) || QFile::remove(crashDir.filePath(archive));
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <optional>
+
+#include <QFuture>
+#include <QMap>
+#include <QStringList>
+
+/// Keeps the evidence from crashed launches. Core dumps or minidumps, console.log and the command line
+/// are compressed into one archive per crash, and the oldest archives are removed to stay under a size budget.
+namespace CrashCollector {
+
+struct Request {
+	QString program;
+	QStringList arguments;
+	QString workingDirectory;
+	QMap<QString, QString> environment;
+	/// Game directory the engine was pointed at, where it writes console.log
+	QString gameDir;
+	/// Milliseconds since epoch, anything older than this wasn't written by the crashed process
+	qint64 startedAt = 0;
+	int exitCode = 0;
+};
+
+struct Report {
+	/// File name of the archive in the crash directory
+	QString archive;
+	qint64 time = 0;
+	QString program;
+	QStringList arguments;
+	int exitCode = 0;
+	/// Names of the files in the archive
+	QStringList files;
+	qint64 size = 0;
+	qint64 uncompressedSize = 0;
+};
+
+[[nodiscard]] QString getCrashDir();
+
+/// Reads the crash index, newest crash first
+[[nodiscard]] QList<Report> getReports();
+
+/// Gathers and compresses the artifacts on a background thread. Raw dumps next to the game are removed once they
+/// are safely in the archive, dumps in system locations are only copied.
+QFuture<std::optional<Report>> collect(Request request, int budgetMB);
+
+[[nodiscard]] bool remove(const QString& archive);
+
+} // namespace CrashCollector
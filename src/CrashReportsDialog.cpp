@@ -0,0 +1,104 @@
+#include "CrashReportsDialog.h"
+
+#include <QDateTime>
+#include <QDesktopServices>
+#include <QDialogButtonBox>
+#include <QDir>
+#include <QFileInfo>
+#include <QHeaderView>
+#include <QLocale>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QTreeWidget>
+#include <QUrl>
+#include <QVBoxLayout>
+
+#include "CrashCollector.h"
+
+namespace {
+
+enum Column {
+	COLUMN_TIME,
+	COLUMN_PROGRAM,
+	COLUMN_EXIT_CODE,
+	COLUMN_SIZE,
+	COLUMN_FILES,
+};
+
+} // namespace
+
+CrashReportsDialog::CrashReportsDialog(QWidget* parent)
+		: QDialog(parent) {
+	// Window setup
+	this->setModal(true);
+	this->setWindowTitle(tr("Crash Reports"));
+	this->setMinimumSize(640, 360);
+
+	// Create UI elements
+	auto* layout = new QVBoxLayout{this};
+
+	this->reports = new QTreeWidget{this};
+	this->reports->setHeaderLabels({tr("Time"), tr("Program"), tr("Exit Code"), tr("Size"), tr("Files")});
+	this->reports->setRootIsDecorated(false);
+	this->reports->header()->setSectionResizeMode(COLUMN_FILES, QHeaderView::Stretch);
+	layout->addWidget(this->reports);
+
+	auto* buttonBox = new QDialogButtonBox{QDialogButtonBox::Close, Qt::Horizontal, this};
+	auto* openFolder = buttonBox->addButton(tr("Open Folder"), QDialogButtonBox::ActionRole);
+	auto* remove = buttonBox->addButton(tr("Delete"), QDialogButtonBox::DestructiveRole);
+	layout->addWidget(buttonBox);
+
+	QObject::connect(openFolder, &QPushButton::clicked, this, [] {
+		if (const QDir crashDir{CrashCollector::getCrashDir()}; crashDir.exists()) {
+			QDesktopServices::openUrl(QUrl::fromLocalFile(crashDir.absolutePath()));
+		}
+	});
+	QObject::connect(remove, &QPushButton::clicked, this, [this] {
+		const auto* item = this->reports->currentItem();
+		if (!item) {
+			return;
+		}
+		const auto archive = item->data(COLUMN_TIME, Qt::UserRole).toString();
+		if (QMessageBox::question(this, tr("Delete Crash Report"), tr("Delete %1?").arg(archive)) != QMessageBox::Yes) {
+			return;
+		}
+		if (!CrashCollector::remove(archive)) {
+			QMessageBox::critical(this, tr("Error"), tr("Failed to delete %1.").arg(archive));
+		}
+		this->populate();
+	});
+	QObject::connect(this->reports, &QTreeWidget::itemDoubleClicked, this, [](const QTreeWidgetItem* item) {
+		QDesktopServices::openUrl(QUrl::fromLocalFile(QDir{CrashCollector::getCrashDir()}.filePath(item->data(COLUMN_TIME, Qt::UserRole).toString())));
+	});
+	QObject::connect(buttonBox, &QDialogButtonBox::rejected, this, &CrashReportsDialog::reject);
+
+	this->populate();
+}
+
+void CrashReportsDialog::populate() {
+	this->reports->clear();
+
+	// Only the index is read, the archives are never opened here
+	const QLocale locale;
+	for (const auto& report : CrashCollector::getReports()) {
+		auto* item = new QTreeWidgetItem{this->reports};
+		item->setText(COLUMN_TIME, locale.toString(QDateTime::fromMSecsSinceEpoch(report.time), QLocale::ShortFormat));
+		item->setData(COLUMN_TIME, Qt::UserRole, report.archive);
+		item->setToolTip(COLUMN_TIME, report.archive);
+		item->setText(COLUMN_PROGRAM, QFileInfo{report.program}.fileName());
+		item->setToolTip(COLUMN_PROGRAM, report.program + ' ' + report.arguments.join(' '));
+		item->setText(COLUMN_EXIT_CODE, QString::number(report.exitCode));
+		item->setText(COLUMN_SIZE, locale.formattedDataSize(report.size));
+		item->setToolTip(COLUMN_SIZE, tr("%1 before compression").arg(locale.formattedDataSize(report.uncompressedSize)));
+		item->setText(COLUMN_FILES, report.files.join(", "));
+	}
+	if (this->reports->topLevelItemCount() > 0) {
+		this->reports->setCurrentItem(this->reports->topLevelItem(0));
+	}
+}
+
+void CrashReportsDialog::open(QWidget* parent) {
+	auto* dialog = new CrashReportsDialog{parent};
+	dialog->exec();
+	dialog->deleteLater();
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <QDialog>
+
+class QTreeWidget;
+
+class CrashReportsDialog : public QDialog {
+	Q_OBJECT;
+
+public:
+	explicit CrashReportsDialog(QWidget* parent = nullptr);
+
+	static void open(QWidget* parent = nullptr);
+
+private:
+	QTreeWidget* reports;
+
+	void populate();
+};
@@ -0,0 +1,112 @@
+#include "DirectoryWalker.h"
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include <QMutex>
+#include <QThread>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+namespace {
+
+struct WorkQueue {
+	QMutex mutex;
+	std::deque<QString> dirs;
+};
+
+/// The owner takes from the back, which keeps its walk depth first and its directories close together on disk
+[[nodiscard]] std::optional<QString> popBack(WorkQueue& queue) {
+	QMutexLocker lock{&queue.mutex};
+	if (queue.dirs.empty()) {
+		return std::nullopt;
+	}
+	auto dir = std::move(queue.dirs.back());
+	queue.dirs.pop_back();
+	return dir;
+}
+
+/// Thieves take from the front, the directories closest to the root are the ones most likely to have a lot under them
+[[nodiscard]] std::optional<QString> popFront(WorkQueue& queue) {
+	QMutexLocker lock{&queue.mutex};
+	if (queue.dirs.empty()) {
+		return std::nullopt;
+	}
+	auto dir = std::move(queue.dirs.front());
+	queue.dirs.pop_front();
+	return dir;
+}
+
+} // namespace
+
+void DirectoryWalker::walk(const QStringList& roots, const Visitor& visitor, int threads) {
+	if (roots.isEmpty()) {
+		return;
+	}
+	if (threads <= 0) {
+		threads = std::max(QThread::idealThreadCount(), 1) * 2;
+	}
+
+	std::vector<std::unique_ptr<WorkQueue>> queues;
+	for (int i = 0; i < threads; i++) {
+		queues.push_back(std::make_unique<WorkQueue>());
+	}
+	for (qsizetype i = 0; i < roots.size(); i++) {
+		queues[i % threads]->dirs.push_back(roots[i]);
+	}
+
+	// Directories queued or being visited, the walk is over once nothing is left anywhere
+	std::atomic<qsizetype> pending = roots.size();
+	// Directories sitting in a queue. Threads that find nothing to steal sleep until this goes up or the walk is over.
+	std::atomic<qsizetype> queued = roots.size();
+	QMutex idleMutex;
+	QWaitCondition workChanged;
+
+	QThreadPool pool;
+	pool.setMaxThreadCount(threads);
+	for (int i = 0; i < threads; i++) {
+		pool.start([&queues, &pending, &queued, &idleMutex, &workChanged, &visitor, threads, i] {
+			auto& own = *queues[i];
+			while (true) {
+				auto dir = ::popBack(own);
+				for (int victim = 1; !dir && victim < threads; victim++) {
+					dir = ::popFront(*queues[(i + victim) % threads]);
+				}
+				if (!dir) {
+					// Someone else is still listing a directory that may have more work in it
+					QMutexLocker lock{&idleMutex};
+					while (queued.load(std::memory_order_acquire) == 0 && pending.load(std::memory_order_acquire) > 0) {
+						workChanged.wait(&idleMutex);
+					}
+					if (pending.load(std::memory_order_acquire) == 0) {
+						return;
+					}
+					continue;
+				}
+				queued.fetch_sub(1, std::memory_order_acq_rel);
+
+				const auto subdirs = visitor(*dir);
+				if (!subdirs.isEmpty()) {
+					// Counted before this directory is finished, so pending can't reach zero while there's work left
+					pending.fetch_add(subdirs.size(), std::memory_order_acq_rel);
+					{
+						QMutexLocker lock{&own.mutex};
+						own.dirs.insert(own.dirs.end(), subdirs.begin(), subdirs.end());
+					}
+					QMutexLocker lock{&idleMutex};
+					queued.fetch_add(subdirs.size(), std::memory_order_acq_rel);
+					workChanged.wakeAll();
+				}
+				if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+					QMutexLocker lock{&idleMutex};
+					workChanged.wakeAll();
+				}
+			}
+		});
+	}
+	pool.waitForDone();
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <functional>
+
+#include <QString>
+#include <QStringList>
+
+/// Walks directory trees on several threads at once. Each thread works depth first through its own queue of
+/// directories, and steals the shallowest directories queued by other threads once it runs out, so one huge folder
+/// doesn't leave the other threads idle.
+namespace DirectoryWalker {
+
+/// Called for every directory on one of the walker's threads, returns the subdirectories to walk into.
+/// Visitors run concurrently, so anything they share has to be synchronized.
+using Visitor = std::function<QStringList(const QString& dir)>;
+
+/// Blocks until every directory under the roots has been visited. Uses twice the ideal thread count if threads is 0,
+/// since the threads mostly wait on the filesystem.
+void walk(const QStringList& roots, const Visitor& visitor, int threads = 0);
+
+} // namespace DirectoryWalker
@@ -0,0 +1,249 @@
+#include "DiskUsage.h"
+
+#include <algorithm>
+#include <atomic>
+#include <utility>
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include "AddonIndex.h"
+#include "DirectoryWalker.h"
+
+namespace {
+
+constexpr quint32 CACHE_MAGIC = 0x44534b55; // DSKU
+constexpr quint32 CACHE_VERSION = 1;
+
+/// What a directory holds directly, its subdirectories have their own records
+struct DirRecord {
+	qint64 modified = 0;
+	qint64 fileBytes = 0;
+	qint64 fileCount = 0;
+	QStringList subdirs;
+};
+
+using DirRecords = QHash<QString, DirRecord>;
+
+struct Totals {
+	qint64 bytes = 0;
+	qint64 files = 0;
+};
+
+[[nodiscard]] DirRecords readCache(const QString& cachePath) {
+	QFile file{cachePath};
+	if (!file.open(QIODevice::ReadOnly)) {
+		return {};
+	}
+	QDataStream in{&file};
+	quint32 magic, version;
+	qint64 count;
+	in >> magic >> version >> count;
+	if (in.status() != QDataStream::Ok || magic != CACHE_MAGIC || version != CACHE_VERSION || count < 0) {
+		return {};
+	}
+
+	DirRecords records;
+	records.reserve(std::min<qint64>(count, 1 << 20));
+	for (qint64 i = 0; i < count && in.status() == QDataStream::Ok; i++) {
+		QString path;
+		DirRecord record;
+		in >> path >> record.modified >> record.fileBytes >> record.fileCount >> record.subdirs;
+		records.insert(std::move(path), std::move(record));
+	}
+	if (in.status() != QDataStream::Ok) {
+		return {};
+	}
+	return records;
+}
+
+void writeCache(const QString& cachePath, const DirRecords& records) {
+	(void) QDir{}.mkpath(QFileInfo{cachePath}.absolutePath());
+	QSaveFile file{cachePath};
+	if (!file.open(QIODevice::WriteOnly)) {
+		return;
+	}
+	QDataStream out{&file};
+	out << CACHE_MAGIC << CACHE_VERSION << static_cast<qint64>(records.size());
+	for (const auto& [path, record] : records.asKeyValueRange()) {
+		out << path << record.modified << record.fileBytes << record.fileCount << record.subdirs;
+	}
+	(void) file.commit();
+}
+
+[[nodiscard]] bool isInside(const QString& path, const QString& dir) {
+	return path == dir || (path.startsWith(dir) && path.size() > dir.size() && path[dir.size()] == '/');
+}
+
+/// Lists a directory, symlinks are never followed so nothing is counted twice and loops are impossible
+[[nodiscard]] DirRecord listDirectory(const QString& dir, qint64 modified) {
+	DirRecord record;
+	record.modified = modified;
+	QDirIterator it{dir, QDir::AllEntries | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot};
+	while (it.hasNext()) {
+		const auto entry = it.nextFileInfo();
+		if (entry.isSymLink()) {
+			continue;
+		}
+		if (entry.isDir()) {
+			record.subdirs.push_back(entry.fileName());
+		} else {
+			record.fileBytes += entry.size();
+			record.fileCount++;
+		}
+	}
+	return record;
+}
+
+[[nodiscard]] Totals getTotals(const DirRecords& records, QHash<QString, Totals>& memo, const QString& path) {
+	if (const auto it = memo.constFind(path); it != memo.constEnd()) {
+		return *it;
+	}
+	const auto it = records.constFind(path);
+	if (it == records.constEnd()) {
+		return {};
+	}
+	Totals totals{it->fileBytes, it->fileCount};
+	for (const auto& subdir : it->subdirs) {
+		const auto subdirTotals = ::getTotals(records, memo, path + '/' + subdir);
+		totals.bytes += subdirTotals.bytes;
+		totals.files += subdirTotals.files;
+	}
+	memo.insert(path, totals);
+	return totals;
+}
+
+[[nodiscard]] DiskUsage::Folder makeFolder(const DirRecords& records, QHash<QString, Totals>& memo, const QString& name, const QString& path) {
+	const auto totals = ::getTotals(records, memo, path);
+	return {name, path, totals.bytes, totals.files, {}};
+}
+
+void sortChildren(DiskUsage::Folder& folder) {
+	std::sort(folder.children.begin(), folder.children.end(), [](const DiskUsage::Folder& lhs, const DiskUsage::Folder& rhs) {
+		return lhs.bytes > rhs.bytes;
+	});
+}
+
+/// The folder with one child per subdirectory
+[[nodiscard]] DiskUsage::Folder makeFolderWithChildren(const DirRecords& records, QHash<QString, Totals>& memo, const QString& name, const QString& path) {
+	auto folder = ::makeFolder(records, memo, name, path);
+	if (const auto it = records.constFind(path); it != records.constEnd()) {
+		for (const auto& subdir : it->subdirs) {
+			folder.children.push_back(::makeFolder(records, memo, subdir, path + '/' + subdir));
+		}
+	}
+	::sortChildren(folder);
+	return folder;
+}
+
+[[nodiscard]] QString normalizePath(const QString& path) {
+	return path.isEmpty() ? QString{} : QDir::cleanPath(QFileInfo{path}.absoluteFilePath());
+}
+
+} // namespace
+
+QString DiskUsage::getDefaultCachePath() {
+	return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QDir::separator() + "disk_usage.bin";
+}
+
+DiskUsage::Report DiskUsage::scan(const QString& rootPath_, const QString& gameRoot_, const QString& sourceModsDir_, const QString& cachePath) {
+	const auto rootPath = ::normalizePath(rootPath_);
+	const auto gameRoot = ::normalizePath(gameRoot_);
+	const auto sourceModsDir = ::normalizePath(sourceModsDir_);
+	const QStringList addonDirs = gameRoot.isEmpty() ? QStringList{} : QStringList{gameRoot + '/' + AddonIndex::ENABLED_ADDONS_DIR, gameRoot + '/' + AddonIndex::DISABLED_ADDONS_DIR};
+
+	// Addons are usually inside the install, and only need walking on their own if the game lives elsewhere
+	QStringList roots;
+	const auto hasInstall = !rootPath.isEmpty() && QFileInfo{rootPath}.isDir();
+	if (hasInstall) {
+		roots.push_back(rootPath);
+	}
+	for (const auto& addonDir : addonDirs) {
+		if (QFileInfo{addonDir}.isDir() && (!hasInstall || !::isInside(addonDir, rootPath))) {
+			roots.push_back(addonDir);
+		}
+	}
+	if (!sourceModsDir.isEmpty() && QFileInfo{sourceModsDir}.isDir()) {
+		roots.push_back(sourceModsDir);
+	}
+
+	const auto previous = ::readCache(cachePath);
+	QMutex visitedMutex;
+	DirRecords visited;
+	std::atomic<qint64> listed = 0;
+	std::atomic<qint64> reused = 0;
+	DirectoryWalker::walk(roots, [&](const QString& dir) -> QStringList {
+		// Roots can overlap, e.g. sourcemods inside the install, so each directory is claimed before it's listed
+		{
+			QMutexLocker lock{&visitedMutex};
+			if (visited.contains(dir)) {
+				return {};
+			}
+			visited.insert(dir, {});
+		}
+
+		const auto modified = QFileInfo{dir}.lastModified().toMSecsSinceEpoch();
+		DirRecord record;
+		if (const auto it = previous.constFind(dir); it != previous.constEnd() && it->modified == modified) {
+			record = *it;
+			reused++;
+		} else {
+			record = ::listDirectory(dir, modified);
+			listed++;
+		}
+
+		QStringList subdirs;
+		subdirs.reserve(record.subdirs.size());
+		for (const auto& subdir : record.subdirs) {
+			subdirs.push_back(dir + '/' + subdir);
+		}
+		QMutexLocker lock{&visitedMutex};
+		visited[dir] = std::move(record);
+		return subdirs;
+	});
+
+	Report report;
+	report.directoriesListed = listed;
+	report.directoriesReused = reused;
+
+	QHash<QString, Totals> memo;
+	if (hasInstall) {
+		report.install = ::makeFolderWithChildren(visited, memo, QDir{rootPath}.dirName(), rootPath);
+	}
+	report.addons.name = QObject::tr("Addons");
+	report.addons.path = addonDirs.isEmpty() ? QString{} : addonDirs.first();
+	for (const auto& addonDir : addonDirs) {
+		const auto disabled = addonDir.endsWith(AddonIndex::DISABLED_ADDONS_DIR);
+		const auto it = visited.constFind(addonDir);
+		if (it == visited.constEnd()) {
+			continue;
+		}
+		for (const auto& addon : it->subdirs) {
+			auto folder = ::makeFolder(visited, memo, disabled ? QObject::tr("%1 (disabled)").arg(addon) : addon, addonDir + '/' + addon);
+			report.addons.bytes += folder.bytes;
+			report.addons.files += folder.files;
+			report.addons.children.push_back(std::move(folder));
+		}
+	}
+	::sortChildren(report.addons);
+	if (!sourceModsDir.isEmpty()) {
+		report.sourceMods = ::makeFolderWithChildren(visited, memo, QObject::tr("SourceMods"), sourceModsDir);
+	}
+
+	// Directories that were scanned before but weren't found this time are gone, everything else is kept for other games
+	for (const auto& [path, record] : previous.asKeyValueRange()) {
+		if (!visited.contains(path) && std::none_of(roots.begin(), roots.end(), [&path](const QString& root) { return ::isInside(path, root); })) {
+			visited.insert(path, record);
+		}
+	}
+	::writeCache(cachePath, visited);
+	return report;
+}
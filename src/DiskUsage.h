@@ -0,0 +1,37 @@
+#pragma once
+
+#include <QList>
+#include <QString>
+
+/// How much space the game install, its addons and sourcemods take up. Directories are walked in parallel, and each
+/// directory's listing is cached by its modification time, so a refresh only lists the directories that had files
+/// added, removed or replaced since the last scan.
+namespace DiskUsage {
+
+struct Folder {
+	QString name;
+	QString path;
+	qint64 bytes = 0;
+	qint64 files = 0;
+	/// Largest first
+	QList<Folder> children;
+};
+
+struct Report {
+	/// The install's top level folders
+	Folder install;
+	/// Enabled and disabled addons of the current game, which are also counted in the install if they're inside it
+	Folder addons;
+	/// Each mod in Steam's sourcemods folder
+	Folder sourceMods;
+	qint64 directoriesListed = 0;
+	qint64 directoriesReused = 0;
+};
+
+[[nodiscard]] QString getDefaultCachePath();
+
+/// Scans everything under the root path, the game root's addons and the sourcemods folder, any of which may be empty.
+/// A file modified in place isn't noticed until its directory changes, which is rare for game content.
+[[nodiscard]] Report scan(const QString& rootPath, const QString& gameRoot, const QString& sourceModsDir, const QString& cachePath = getDefaultCachePath());
+
+} // namespace DiskUsage
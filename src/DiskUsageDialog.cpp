@@ -0,0 +1,138 @@
+#include "DiskUsageDialog.h"
+
+#include <utility>
+
+#include <QDesktopServices>
+#include <QDialogButtonBox>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLocale>
+#include <QPushButton>
+#include <QTreeWidget>
+#include <QUrl>
+#include <QVBoxLayout>
+#include <QtConcurrent>
+
+#include "Steam.h"
+
+namespace {
+
+enum Column {
+	COLUMN_NAME,
+	COLUMN_SIZE,
+	COLUMN_SHARE,
+	COLUMN_FILES,
+};
+
+} // namespace
+
+DiskUsageDialog::DiskUsageDialog(QString rootPath_, QString gameRoot_, QWidget* parent)
+		: QDialog(parent)
+		, rootPath(std::move(rootPath_))
+		, gameRoot(std::move(gameRoot_))
+		, scan(new QFutureWatcher<DiskUsage::Report>{this}) {
+	// Window setup
+	this->setModal(true);
+	this->setWindowTitle(tr("Disk Usage"));
+	this->setMinimumSize(560, 400);
+
+	// Create UI elements
+	auto* layout = new QVBoxLayout{this};
+
+	this->folders = new QTreeWidget{this};
+	this->folders->setHeaderLabels({tr("Folder"), tr("Size"), tr("Share"), tr("Files")});
+	this->folders->header()->setSectionResizeMode(COLUMN_NAME, QHeaderView::Stretch);
+	this->folders->header()->setStretchLastSection(false);
+	layout->addWidget(this->folders);
+
+	this->status = new QLabel{this};
+	layout->addWidget(this->status);
+
+	auto* buttonBox = new QDialogButtonBox{QDialogButtonBox::Close, Qt::Horizontal, this};
+	this->refreshButton = buttonBox->addButton(tr("Refresh"), QDialogButtonBox::ActionRole);
+	auto* openFolder = buttonBox->addButton(tr("Open Folder"), QDialogButtonBox::ActionRole);
+	layout->addWidget(buttonBox);
+
+	QObject::connect(this->refreshButton, &QPushButton::clicked, this, &DiskUsageDialog::refresh);
+	QObject::connect(openFolder, &QPushButton::clicked, this, [this] {
+		if (const auto* item = this->folders->currentItem(); item && !item->data(COLUMN_NAME, Qt::UserRole).toString().isEmpty()) {
+			QDesktopServices::openUrl(QUrl::fromLocalFile(item->data(COLUMN_NAME, Qt::UserRole).toString()));
+		}
+	});
+	QObject::connect(this->folders, &QTreeWidget::itemDoubleClicked, this, [](const QTreeWidgetItem* item) {
+		if (const auto path = item->data(COLUMN_NAME, Qt::UserRole).toString(); !path.isEmpty()) {
+			QDesktopServices::openUrl(QUrl::fromLocalFile(path));
+		}
+	});
+	QObject::connect(buttonBox, &QDialogButtonBox::rejected, this, &DiskUsageDialog::reject);
+
+	QObject::connect(this->scan, &QFutureWatcher<DiskUsage::Report>::finished, this, [this] {
+		this->refreshButton->setEnabled(true);
+		if (this->scan->future().resultCount() > 0) {
+			this->populate(this->scan->result());
+		}
+	});
+
+	this->refresh();
+}
+
+void DiskUsageDialog::refresh() {
+	if (this->scan->isRunning()) {
+		return;
+	}
+	this->refreshButton->setEnabled(false);
+	this->status->setText(tr("Scanning..."));
+	this->scanTimer.start();
+	// Only directories that changed since the last scan are listed again, so refreshing is cheap
+	this->scan->setFuture(QtConcurrent::run([rootPath = this->rootPath, gameRoot = this->gameRoot, sourceModsDir = ::getSourceModsDir()] {
+		return DiskUsage::scan(rootPath, gameRoot, sourceModsDir);
+	}));
+}
+
+void DiskUsageDialog::populate(const DiskUsage::Report& report) {
+	this->folders->clear();
+
+	for (const auto* folder : {&report.install, &report.addons, &report.sourceMods}) {
+		if (folder->path.isEmpty()) {
+			continue;
+		}
+		auto* item = this->addFolder(nullptr, *folder, 0);
+		for (const auto& child : folder->children) {
+			this->addFolder(item, child, folder->bytes);
+		}
+	}
+	if (auto* install = this->folders->topLevelItem(0)) {
+		install->setExpanded(true);
+	}
+	for (int column = COLUMN_SIZE; column <= COLUMN_FILES; column++) {
+		this->folders->resizeColumnToContents(column);
+	}
+
+	this->status->setText(tr("Listed %1 folders in %2s, %3 were unchanged since the last scan.")
+		.arg(report.directoriesListed)
+		.arg(static_cast<double>(this->scanTimer.elapsed()) / 1000.0, 0, 'f', 1)
+		.arg(report.directoriesReused));
+}
+
+QTreeWidgetItem* DiskUsageDialog::addFolder(QTreeWidgetItem* parent, const DiskUsage::Folder& folder, qint64 parentBytes) {
+	const QLocale locale;
+	auto* item = parent ? new QTreeWidgetItem{parent} : new QTreeWidgetItem{this->folders};
+	item->setText(COLUMN_NAME, folder.name);
+	item->setData(COLUMN_NAME, Qt::UserRole, folder.path);
+	item->setToolTip(COLUMN_NAME, folder.path);
+	item->setText(COLUMN_SIZE, locale.formattedDataSize(folder.bytes));
+	item->setTextAlignment(COLUMN_SIZE, Qt::AlignRight | Qt::AlignVCenter);
+	if (parentBytes > 0) {
+		item->setText(COLUMN_SHARE, QString("%1%").arg(static_cast<double>(folder.bytes) * 100.0 / static_cast<double>(parentBytes), 0, 'f', 1));
+		item->setTextAlignment(COLUMN_SHARE, Qt::AlignRight | Qt::AlignVCenter);
+	}
+	item->setText(COLUMN_FILES, locale.toString(folder.files));
+	item->setTextAlignment(COLUMN_FILES, Qt::AlignRight | Qt::AlignVCenter);
+	return item;
+}
+
+void DiskUsageDialog::open(const QString& rootPath, const QString& gameRoot, QWidget* parent) {
+	auto* dialog = new DiskUsageDialog{rootPath, gameRoot, parent};
+	dialog->exec();
+	dialog->deleteLater();
+}
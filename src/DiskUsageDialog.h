@@ -0,0 +1,36 @@
+#pragma once
+
+#include <QDialog>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+
+#include "DiskUsage.h"
+
+class QLabel;
+class QPushButton;
+class QTreeWidget;
+class QTreeWidgetItem;
+
+class DiskUsageDialog : public QDialog {
+	Q_OBJECT;
+
+public:
+	DiskUsageDialog(QString rootPath_, QString gameRoot_, QWidget* parent = nullptr);
+
+	static void open(const QString& rootPath, const QString& gameRoot, QWidget* parent = nullptr);
+
+private:
+	QString rootPath;
+	QString gameRoot;
+	QTreeWidget* folders;
+	QLabel* status;
+	QPushButton* refreshButton;
+	QFutureWatcher<DiskUsage::Report>* scan;
+	QElapsedTimer scanTimer;
+
+	void refresh();
+
+	void populate(const DiskUsage::Report& report);
+
+	QTreeWidgetItem* addFolder(QTreeWidgetItem* parent, const DiskUsage::Folder& folder, qint64 parentBytes);
+};
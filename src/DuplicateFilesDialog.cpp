@@ -0,0 +1,189 @@
+#include "DuplicateFilesDialog.h"
+
+#include <algorithm>
+#include <utility>
+
+#include <QDialogButtonBox>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLocale>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+#include <QtConcurrent>
+
+namespace {
+
+enum Column {
+	COLUMN_PATH,
+	COLUMN_SIZE,
+	COLUMN_COPIES,
+	COLUMN_RECLAIMABLE,
+};
+
+/// More failures than this are summarized, the rest are rarely different
+constexpr qsizetype MAX_FAILURES_SHOWN = 20;
+
+} // namespace
+
+DuplicateFilesDialog::DuplicateFilesDialog(QStringList roots_, QWidget* parent)
+		: QDialog(parent)
+		, roots(std::move(roots_))
+		, scan(new QFutureWatcher<DuplicateFinder::Result>{this})
+		, linking(new QFutureWatcher<DuplicateFinder::LinkResult>{this}) {
+	// Window setup
+	this->setModal(true);
+	this->setWindowTitle(tr("Duplicate Files"));
+	this->setMinimumSize(640, 420);
+
+	// Create UI elements
+	auto* layout = new QVBoxLayout{this};
+
+	this->groups = new QTreeWidget{this};
+	this->groups->setHeaderLabels({tr("File"), tr("Size"), tr("Copies"), tr("Reclaimable")});
+	this->groups->header()->setSectionResizeMode(COLUMN_PATH, QHeaderView::Stretch);
+	this->groups->header()->setStretchLastSection(false);
+	layout->addWidget(this->groups);
+
+	this->status = new QLabel{this};
+	this->status->setWordWrap(true);
+	layout->addWidget(this->status);
+
+	auto* buttonBox = new QDialogButtonBox{QDialogButtonBox::Close, Qt::Horizontal, this};
+	this->rescanButton = buttonBox->addButton(tr("Rescan"), QDialogButtonBox::ActionRole);
+	this->hardlinkButton = buttonBox->addButton(tr("Replace with Hardlinks"), QDialogButtonBox::ActionRole);
+	this->reflinkButton = buttonBox->addButton(tr("Replace with Reflinks"), QDialogButtonBox::ActionRole);
+	this->reflinkButton->setVisible(DuplicateFinder::supportsReflinks());
+	layout->addWidget(buttonBox);
+
+	QObject::connect(this->rescanButton, &QPushButton::clicked, this, &DuplicateFilesDialog::rescan);
+	QObject::connect(this->hardlinkButton, &QPushButton::clicked, this, [this] {
+		this->replaceChecked(DuplicateFinder::LinkMode::HARDLINK);
+	});
+	QObject::connect(this->reflinkButton, &QPushButton::clicked, this, [this] {
+		this->replaceChecked(DuplicateFinder::LinkMode::REFLINK);
+	});
+	QObject::connect(buttonBox, &QDialogButtonBox::rejected, this, &DuplicateFilesDialog::reject);
+
+	QObject::connect(this->scan, &QFutureWatcher<DuplicateFinder::Result>::finished, this, [this] {
+		this->setBusy(false);
+		if (this->scan->future().resultCount() > 0) {
+			this->result = this->scan->result();
+			this->populate();
+		}
+	});
+	QObject::connect(this->linking, &QFutureWatcher<DuplicateFinder::LinkResult>::finished, this, [this] {
+		this->setBusy(false);
+		if (this->linking->future().resultCount() == 0) {
+			return;
+		}
+		const auto linkResult = this->linking->result();
+		const auto summary = tr("Replaced %1 files, freeing %2.").arg(linkResult.filesReplaced).arg(QLocale{}.formattedDataSize(linkResult.bytesReclaimed));
+		if (linkResult.failed.isEmpty()) {
+			QMessageBox::information(this, tr("Duplicate Files"), summary);
+		} else {
+			auto failed = linkResult.failed.first(std::min(linkResult.failed.size(), MAX_FAILURES_SHOWN));
+			if (linkResult.failed.size() > MAX_FAILURES_SHOWN) {
+				failed.push_back(tr("...and %1 more.").arg(linkResult.failed.size() - MAX_FAILURES_SHOWN));
+			}
+			QMessageBox::warning(this, tr("Duplicate Files"), summary + "\n\n" + tr("These files were left as they were:") + "\n" + failed.join('\n'));
+		}
+		this->rescan();
+	});
+
+	this->rescan();
+}
+
+void DuplicateFilesDialog::rescan() {
+	if (this->scan->isRunning() || this->linking->isRunning()) {
+		return;
+	}
+	this->setBusy(true);
+	this->status->setText(tr("Scanning..."));
+	this->scan->setFuture(QtConcurrent::run([roots = this->roots] {
+		return DuplicateFinder::scan(roots);
+	}));
+}
+
+void DuplicateFilesDialog::populate() {
+	this->groups->clear();
+
+	const QLocale locale;
+	for (qsizetype i = 0; i < this->result.groups.size(); i++) {
+		const auto& group = this->result.groups[i];
+		auto* groupItem = new QTreeWidgetItem{this->groups};
+		groupItem->setText(COLUMN_PATH, group.copies.first().first());
+		groupItem->setData(COLUMN_PATH, Qt::UserRole, i);
+		groupItem->setCheckState(COLUMN_PATH, Qt::Unchecked);
+		groupItem->setText(COLUMN_SIZE, locale.formattedDataSize(group.size));
+		groupItem->setTextAlignment(COLUMN_SIZE, Qt::AlignRight | Qt::AlignVCenter);
+		groupItem->setText(COLUMN_COPIES, locale.toString(group.copies.size()));
+		groupItem->setTextAlignment(COLUMN_COPIES, Qt::AlignRight | Qt::AlignVCenter);
+		groupItem->setText(COLUMN_RECLAIMABLE, locale.formattedDataSize(group.getReclaimableBytes()));
+		groupItem->setTextAlignment(COLUMN_RECLAIMABLE, Qt::AlignRight | Qt::AlignVCenter);
+
+		for (qsizetype j = 0; j < group.copies.size(); j++) {
+			auto* copyItem = new QTreeWidgetItem{groupItem};
+			copyItem->setText(COLUMN_PATH, j == 0 ? tr("%1 (kept)").arg(group.copies[j].first()) : group.copies[j].first());
+			// Paths that are already links to this copy
+			copyItem->setToolTip(COLUMN_PATH, group.copies[j].join('\n'));
+		}
+	}
+	for (int column = COLUMN_SIZE; column <= COLUMN_RECLAIMABLE; column++) {
+		this->groups->resizeColumnToContents(column);
+	}
+
+	if (this->result.groups.isEmpty()) {
+		this->status->setText(tr("No duplicates found in %1 files.").arg(this->result.filesScanned));
+	} else {
+		this->status->setText(tr("%1 files have copies, %2 can be reclaimed. Hashed %3 files, %4 were unchanged since the last scan.")
+			.arg(this->result.groups.size())
+			.arg(locale.formattedDataSize(this->result.reclaimableBytes))
+			.arg(this->result.filesHashed)
+			.arg(this->result.filesReused));
+	}
+}
+
+void DuplicateFilesDialog::replaceChecked(DuplicateFinder::LinkMode mode) {
+	if (this->scan->isRunning() || this->linking->isRunning()) {
+		return;
+	}
+
+	QList<DuplicateFinder::Group> checked;
+	for (int i = 0; i < this->groups->topLevelItemCount(); i++) {
+		const auto* item = this->groups->topLevelItem(i);
+		if (item->checkState(COLUMN_PATH) == Qt::Checked) {
+			checked.push_back(this->result.groups[item->data(COLUMN_PATH, Qt::UserRole).value<qsizetype>()]);
+		}
+	}
+	if (checked.isEmpty()) {
+		QMessageBox::information(this, tr("Duplicate Files"), tr("Check the files to replace first."));
+		return;
+	}
+
+	const auto warning = mode == DuplicateFinder::LinkMode::HARDLINK
+		? tr("Hardlinked copies are the same file, so editing any one of them changes all of them. Replace the copies of %1 files?")
+		: tr("Reflinked copies share storage until one of them is edited. Replace the copies of %1 files?");
+	if (QMessageBox::question(this, tr("Duplicate Files"), warning.arg(checked.size())) != QMessageBox::Yes) {
+		return;
+	}
+
+	this->setBusy(true);
+	this->status->setText(tr("Replacing copies..."));
+	this->linking->setFuture(QtConcurrent::run([checked = std::move(checked), mode] {
+		return DuplicateFinder::link(checked, mode);
+	}));
+}
+
+void DuplicateFilesDialog::setBusy(bool busy) {
+	this->rescanButton->setEnabled(!busy);
+	this->hardlinkButton->setEnabled(!busy);
+	this->reflinkButton->setEnabled(!busy);
+}
+
+void DuplicateFilesDialog::open(const QStringList& roots, QWidget* parent) {
+	auto* dialog = new DuplicateFilesDialog{roots, parent};
+	dialog->exec();
+	dialog->deleteLater();
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <QDialog>
+#include <QFutureWatcher>
+
+#include "DuplicateFinder.h"
+
+class QLabel;
+class QPushButton;
+class QTreeWidget;
+
+class DuplicateFilesDialog : public QDialog {
+	Q_OBJECT;
+
+public:
+	explicit DuplicateFilesDialog(QStringList roots_, QWidget* parent = nullptr);
+
+	static void open(const QStringList& roots, QWidget* parent = nullptr);
+
+private:
+	QStringList roots;
+	DuplicateFinder::Result result;
+	QTreeWidget* groups;
+	QLabel* status;
+	QPushButton* rescanButton;
+	QPushButton* hardlinkButton;
+	QPushButton* reflinkButton;
+	QFutureWatcher<DuplicateFinder::Result>* scan;
+	QFutureWatcher<DuplicateFinder::LinkResult>* linking;
+
+	void rescan();
+
+	void populate();
+
+	void replaceChecked(DuplicateFinder::LinkMode mode);
+
+	void setBusy(bool busy);
+};
@@ -0,0 +1,485 @@
+#include "DuplicateFinder.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <system_error>
+#include <utility>
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QSaveFile>
+#include <QSet>
+#include <QStandardPaths>
+#include <QtConcurrent>
+
+#include "DirectoryWalker.h"
+
+#if defined(_WIN32)
+	#include <Windows.h>
+#else
+	#include <sys/stat.h>
+	#if defined(__linux__)
+		#include <fcntl.h>
+		#include <linux/fs.h>
+		#include <sys/ioctl.h>
+		#include <unistd.h>
+	#elif defined(__APPLE__)
+		#include <sys/clonefile.h>
+	#endif
+#endif
+
+namespace {
+
+constexpr quint32 CACHE_MAGIC = 0x44555048; // DUPH
+constexpr quint32 CACHE_VERSION = 1;
+
+/// Hashes of files that weren't seen in any scan for this long are dropped from the cache
+constexpr qint64 CACHE_MAX_AGE_MS = 90ll * 24 * 60 * 60 * 1000;
+
+/// Suffix of the link made next to a copy before it's renamed over the copy
+constexpr auto LINK_TEMP_SUFFIX = ".sdklauncher-dedupe";
+
+/// Device and inode (volume serial and file index on Windows), which every hardlink to a file shares
+using FileKey = std::pair<quint64, quint64>;
+
+struct CacheEntry {
+	qint64 size = 0;
+	qint64 modified = 0;
+	quint64 hash = 0;
+	qint64 lastSeen = 0;
+};
+
+struct Candidate {
+	QString path;
+	qint64 size = 0;
+	qint64 modified = 0;
+	std::optional<FileKey> key;
+	std::optional<quint64> hash;
+};
+
+// XXH64 with a seed of 0, fast enough that hashing is bound by the disk.
+// Inputs are read as little endian words, the cache is never shared between machines so the byte order doesn't matter.
+
+constexpr quint64 XXH_PRIME64_1 = 0x9E3779B185EBCA87ull;
+constexpr quint64 XXH_PRIME64_2 = 0xC2B2AE3D27D4EB4Full;
+constexpr quint64 XXH_PRIME64_3 = 0x165667B19E3779F9ull;
+constexpr quint64 XXH_PRIME64_4 = 0x85EBCA77C2B2AE63ull;
+constexpr quint64 XXH_PRIME64_5 = 0x27D4EB2F165667C5ull;
+
+[[nodiscard]] constexpr quint64 rotl(quint64 x, int r) {
+	return (x << r) | (x >> (64 - r));
+}
+
+template<typename T>
+[[nodiscard]] T readWord(const uchar* data) {
+	T out;
+	std::memcpy(&out, data, sizeof(T));
+	return out;
+}
+
+[[nodiscard]] constexpr quint64 xxhRound(quint64 acc, quint64 input) {
+	return ::rotl(acc + input * XXH_PRIME64_2, 31) * XXH_PRIME64_1;
+}
+
+[[nodiscard]] constexpr quint64 xxhMerge(quint64 acc, quint64 lane) {
+	return (acc ^ ::xxhRound(0, lane)) * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+
+[[nodiscard]] quint64 xxh64(const uchar* data, qint64 size) {
+	const uchar* p = data;
+	const uchar* const end = data + size;
+
+	quint64 hash;
+	if (size >= 32) {
+		quint64 lanes[4]{XXH_PRIME64_1 + XXH_PRIME64_2, XXH_PRIME64_2, 0, 0 - XXH_PRIME64_1};
+		for (; end - p >= 32; p += 32) {
+			for (int i = 0; i < 4; i++) {
+				lanes[i] = ::xxhRound(lanes[i], ::readWord<quint64>(p + i * 8));
+			}
+		}
+		hash = ::rotl(lanes[0], 1) + ::rotl(lanes[1], 7) + ::rotl(lanes[2], 12) + ::rotl(lanes[3], 18);
+		for (const auto lane : lanes) {
+			hash = ::xxhMerge(hash, lane);
+		}
+	} else {
+		hash = XXH_PRIME64_5;
+	}
+	hash += static_cast<quint64>(size);
+
+	for (; end - p >= 8; p += 8) {
+		hash = ::rotl(hash ^ ::xxhRound(0, ::readWord<quint64>(p)), 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+	}
+	if (end - p >= 4) {
+		hash = ::rotl(hash ^ (static_cast<quint64>(::readWord<quint32>(p)) * XXH_PRIME64_1), 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+		p += 4;
+	}
+	for (; p < end; p++) {
+		hash = ::rotl(hash ^ (*p * XXH_PRIME64_5), 11) * XXH_PRIME64_1;
+	}
+
+	hash ^= hash >> 33;
+	hash *= XXH_PRIME64_2;
+	hash ^= hash >> 29;
+	hash *= XXH_PRIME64_3;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+[[nodiscard]] std::optional<FileKey> getFileKey(const QString& path) {
+#if defined(_WIN32)
+	const auto handle = CreateFileW(reinterpret_cast<const wchar_t*>(QDir::toNativeSeparators(path).utf16()), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (handle == INVALID_HANDLE_VALUE) {
+		return std::nullopt;
+	}
+	BY_HANDLE_FILE_INFORMATION info;
+	const auto ok = GetFileInformationByHandle(handle, &info);
+	CloseHandle(handle);
+	if (!ok) {
+		return std::nullopt;
+	}
+	return FileKey{info.dwVolumeSerialNumber, (static_cast<quint64>(info.nFileIndexHigh) << 32) | info.nFileIndexLow};
+#else
+	struct stat info{};
+	if (::stat(QFile::encodeName(path).constData(), &info) != 0) {
+		return std::nullopt;
+	}
+	return FileKey{static_cast<quint64>(info.st_dev), static_cast<quint64>(info.st_ino)};
+#endif
+}
+
+[[nodiscard]] std::optional<quint64> hashFile(const QString& path, qint64 size) {
+	QFile file{path};
+	if (!file.open(QIODevice::ReadOnly) || file.size() != size) {
+		return std::nullopt;
+	}
+	// Mapped rather than read, so the contents are hashed straight out of the page cache
+	auto* data = file.map(0, size);
+	if (!data) {
+		return std::nullopt;
+	}
+	const auto hash = ::xxh64(data, size);
+	file.unmap(data);
+	return hash;
+}
+
+[[nodiscard]] bool haveSameContents(const QString& lhsPath, const QString& rhsPath, qint64 size) {
+	QFile lhs{lhsPath};
+	QFile rhs{rhsPath};
+	if (!lhs.open(QIODevice::ReadOnly) || !rhs.open(QIODevice::ReadOnly) || lhs.size() != size || rhs.size() != size) {
+		return false;
+	}
+	auto* lhsData = lhs.map(0, size);
+	auto* rhsData = rhs.map(0, size);
+	const auto same = lhsData && rhsData && std::memcmp(lhsData, rhsData, size) == 0;
+	if (lhsData) {
+		lhs.unmap(lhsData);
+	}
+	if (rhsData) {
+		rhs.unmap(rhsData);
+	}
+	return same;
+}
+
+[[nodiscard]] QHash<FileKey, CacheEntry> readCache(const QString& cachePath) {
+	QFile file{cachePath};
+	if (!file.open(QIODevice::ReadOnly)) {
+		return {};
+	}
+	QDataStream in{&file};
+	quint32 magic, version;
+	qint64 count;
+	in >> magic >> version >> count;
+	if (in.status() != QDataStream::Ok || magic != CACHE_MAGIC || version != CACHE_VERSION || count < 0) {
+		return {};
+	}
+
+	QHash<FileKey, CacheEntry> entries;
+	entries.reserve(std::min<qint64>(count, 1 << 20));
+	for (qint64 i = 0; i < count && in.status() == QDataStream::Ok; i++) {
+		FileKey key;
+		CacheEntry entry;
+		in >> key.first >> key.second >> entry.size >> entry.modified >> entry.hash >> entry.lastSeen;
+		entries.insert(key, entry);
+	}
+	if (in.status() != QDataStream::Ok) {
+		return {};
+	}
+	return entries;
+}
+
+void writeCache(const QString& cachePath, const QHash<FileKey, CacheEntry>& entries) {
+	(void) QDir{}.mkpath(QFileInfo{cachePath}.absolutePath());
+	QSaveFile file{cachePath};
+	if (!file.open(QIODevice::WriteOnly)) {
+		return;
+	}
+	QDataStream out{&file};
+	out << CACHE_MAGIC << CACHE_VERSION << static_cast<qint64>(entries.size());
+	for (const auto& [key, entry] : entries.asKeyValueRange()) {
+		out << key.first << key.second << entry.size << entry.modified << entry.hash << entry.lastSeen;
+	}
+	(void) file.commit();
+}
+
+[[nodiscard]] QString getErrorString(int error) {
+	return QString::fromStdString(std::generic_category().message(error));
+}
+
+/// Makes a copy-on-write clone of the source at the destination, which must not exist yet
+[[nodiscard]] QString cloneFile(const QString& source, const QString& destination) {
+#if defined(__linux__)
+	const int sourceFD = ::open(QFile::encodeName(source).constData(), O_RDONLY | O_CLOEXEC);
+	if (sourceFD < 0) {
+		return ::getErrorString(errno);
+	}
+	const int destinationFD = ::open(QFile::encodeName(destination).constData(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+	if (destinationFD < 0) {
+		const auto error = errno;
+		::close(sourceFD);
+		return ::getErrorString(error);
+	}
+	const auto result = ::ioctl(destinationFD, FICLONE, sourceFD);
+	const auto error = errno;
+	::close(sourceFD);
+	::close(destinationFD);
+	if (result != 0) {
+		(void) QFile::remove(destination);
+		return ::getErrorString(error);
+	}
+	return {};
+#elif defined(__APPLE__)
+	if (::clonefile(QFile::encodeName(source).constData(), QFile::encodeName(destination).constData(), 0) != 0) {
+		return ::getErrorString(errno);
+	}
+	return {};
+#else
+	Q_UNUSED(source);
+	Q_UNUSED(destination);
+	return QObject::tr("Reflinks are not supported on this platform.");
+#endif
+}
+
+/// Links the target to the source's contents. The link is made next to the target and renamed over it, so the target
+/// is never missing or half written if this fails.
+[[nodiscard]] QString replaceWithLink(const QString& source, const QString& target, DuplicateFinder::LinkMode mode) {
+	const auto temp = target + LINK_TEMP_SUFFIX;
+	const std::filesystem::path tempPath{temp.toStdU16String()};
+	std::error_code error;
+	if (mode == DuplicateFinder::LinkMode::HARDLINK) {
+		std::filesystem::create_hard_link(std::filesystem::path{source.toStdU16String()}, tempPath, error);
+		if (error) {
+			return QString::fromLocal8Bit(error.message());
+		}
+	} else {
+		if (auto cloneError = ::cloneFile(source, temp); !cloneError.isEmpty()) {
+			return cloneError;
+		}
+		// A clone is a new file, it should look like the one it replaces
+		const QFileInfo targetInfo{target};
+		(void) QFile::setPermissions(temp, targetInfo.permissions());
+		if (QFile file{temp}; file.open(QIODevice::Append)) {
+			(void) file.setFileTime(targetInfo.lastModified(), QFileDevice::FileModificationTime);
+		}
+	}
+
+	std::filesystem::rename(tempPath, std::filesystem::path{target.toStdU16String()}, error);
+	if (error) {
+		std::error_code ignored;
+		std::filesystem::remove(tempPath, ignored);
+		return QString::fromLocal8Bit(error.message());
+	}
+	return {};
+}
+
+[[nodiscard]] bool isInside(const QString& path, const QString& dir) {
+	return path == dir || (path.startsWith(dir) && path.size() > dir.size() && path[dir.size()] == '/');
+}
+
+} // namespace
+
+QString DuplicateFinder::getDefaultCachePath() {
+	return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QDir::separator() + "file_hashes.bin";
+}
+
+DuplicateFinder::Result DuplicateFinder::scan(const QStringList& roots_, const QString& cachePath) {
+	// Nested roots would list the same files twice
+	QStringList existing;
+	for (const auto& root : roots_) {
+		if (!root.isEmpty() && QFileInfo{root}.isDir()) {
+			existing.push_back(QDir::cleanPath(QFileInfo{root}.absoluteFilePath()));
+		}
+	}
+	existing.removeDuplicates();
+	QStringList roots;
+	for (const auto& root : existing) {
+		if (std::none_of(existing.begin(), existing.end(), [&root](const QString& other) { return other != root && ::isInside(root, other); })) {
+			roots.push_back(root);
+		}
+	}
+
+	QMutex candidatesMutex;
+	QList<Candidate> candidates;
+	std::atomic<qint64> filesScanned = 0;
+	DirectoryWalker::walk(roots, [&](const QString& dir) {
+		QStringList subdirs;
+		QList<Candidate> found;
+		QDirIterator it{dir, QDir::AllEntries | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot};
+		while (it.hasNext()) {
+			const auto entry = it.nextFileInfo();
+			if (entry.isSymLink()) {
+				continue;
+			}
+			if (entry.isDir()) {
+				subdirs.push_back(entry.absoluteFilePath());
+				continue;
+			}
+			filesScanned++;
+			if (entry.size() >= MIN_FILE_SIZE && !entry.fileName().endsWith(LINK_TEMP_SUFFIX)) {
+				found.push_back({entry.absoluteFilePath(), entry.size(), entry.lastModified().toMSecsSinceEpoch(), std::nullopt, std::nullopt});
+			}
+		}
+		if (!found.isEmpty()) {
+			QMutexLocker lock{&candidatesMutex};
+			candidates += std::move(found);
+		}
+		return subdirs;
+	});
+
+	Result result;
+	result.filesScanned = filesScanned;
+
+	// Only a file with the same size as another can be a duplicate, everything else is never opened
+	const auto keepSharedSizes = [&candidates](const auto& sameFile) {
+		QHash<qint64, qsizetype> sizes;
+		for (const auto& candidate : candidates) {
+			sizes[candidate.size]++;
+		}
+		QList<Candidate> kept;
+		for (auto& candidate : candidates) {
+			if (sizes[candidate.size] > 1 && !sameFile(candidate)) {
+				kept.push_back(std::move(candidate));
+			}
+		}
+		candidates = std::move(kept);
+	};
+	keepSharedSizes([](const Candidate&) { return false; });
+
+	// Paths that are already links to the same file don't need hashing twice
+	QtConcurrent::blockingMap(candidates, [](Candidate& candidate) {
+		candidate.key = ::getFileKey(candidate.path);
+	});
+	QHash<qint64, QSet<FileKey>> keysBySize;
+	for (const auto& candidate : candidates) {
+		if (candidate.key) {
+			keysBySize[candidate.size].insert(*candidate.key);
+		}
+	}
+	keepSharedSizes([&keysBySize](const Candidate& candidate) {
+		return !candidate.key || keysBySize[candidate.size].size() < 2;
+	});
+
+	const auto now = QDateTime::currentMSecsSinceEpoch();
+	const auto previous = ::readCache(cachePath);
+	std::atomic<qint64> filesHashed = 0;
+	std::atomic<qint64> filesReused = 0;
+	QtConcurrent::blockingMap(candidates, [&](Candidate& candidate) {
+		if (const auto it = previous.constFind(*candidate.key); it != previous.constEnd() && it->size == candidate.size && it->modified == candidate.modified) {
+			candidate.hash = it->hash;
+			filesReused++;
+			return;
+		}
+		candidate.hash = ::hashFile(candidate.path, candidate.size);
+		filesHashed++;
+	});
+	result.filesHashed = filesHashed;
+	result.filesReused = filesReused;
+
+	// Grouped by contents, then by the file on disk each path is a link to
+	QHash<std::pair<qint64, quint64>, QHash<FileKey, QStringList>> byContents;
+	QHash<FileKey, CacheEntry> cache;
+	for (const auto& candidate : candidates) {
+		if (!candidate.hash) {
+			continue;
+		}
+		byContents[{candidate.size, *candidate.hash}][*candidate.key].push_back(candidate.path);
+		cache.insert(*candidate.key, {candidate.size, candidate.modified, *candidate.hash, now});
+	}
+	for (const auto& [contents, files] : byContents.asKeyValueRange()) {
+		if (files.size() < 2) {
+			continue;
+		}
+		auto& group = result.groups.emplace_back();
+		group.size = contents.first;
+		group.hash = contents.second;
+		for (auto paths : files) {
+			paths.sort();
+			group.copies.push_back(std::move(paths));
+		}
+		std::sort(group.copies.begin(), group.copies.end());
+		result.reclaimableBytes += group.getReclaimableBytes();
+	}
+	std::sort(result.groups.begin(), result.groups.end(), [](const Group& lhs, const Group& rhs) {
+		return lhs.getReclaimableBytes() > rhs.getReclaimableBytes();
+	});
+
+	for (const auto& [key, entry] : previous.asKeyValueRange()) {
+		if (!cache.contains(key) && now - entry.lastSeen < CACHE_MAX_AGE_MS) {
+			cache.insert(key, entry);
+		}
+	}
+	::writeCache(cachePath, cache);
+	return result;
+}
+
+bool DuplicateFinder::supportsReflinks() {
+#if defined(__linux__) || defined(__APPLE__)
+	return true;
+#else
+	return false;
+#endif
+}
+
+DuplicateFinder::LinkResult DuplicateFinder::link(const QList<Group>& groups, LinkMode mode) {
+	const auto results = QtConcurrent::blockingMapped(groups, [mode](const Group& group) {
+		LinkResult result;
+		const auto& source = group.copies.first().first();
+		for (qsizetype i = 1; i < group.copies.size(); i++) {
+			// The hash isn't cryptographic and the files may have changed since the scan
+			if (!::haveSameContents(source, group.copies[i].first(), group.size)) {
+				result.failed.push_back(QObject::tr("%1: The contents differ from %2.").arg(group.copies[i].first(), source));
+				continue;
+			}
+			// The space only comes back once nothing links to the old file
+			bool replacedAll = true;
+			for (const auto& path : group.copies[i]) {
+				if (const auto error = ::replaceWithLink(source, path, mode); !error.isEmpty()) {
+					result.failed.push_back(QString("%1: %2").arg(path, error));
+					replacedAll = false;
+				} else {
+					result.filesReplaced++;
+				}
+			}
+			if (replacedAll) {
+				result.bytesReclaimed += group.size;
+			}
+		}
+		return result;
+	});
+
+	LinkResult out;
+	for (const auto& result : results) {
+		out.filesReplaced += result.filesReplaced;
+		out.bytesReclaimed += result.bytesReclaimed;
+		out.failed += result.failed;
+	}
+	return out;
+}
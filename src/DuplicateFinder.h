@@ -0,0 +1,60 @@
+#pragma once
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+/// Finds files with identical contents across the game, its addons and sourcemods, and replaces the copies with links
+/// to one of them. Only files sharing a size are hashed, in parallel, with the hashes cached on disk by inode and
+/// modification time so a rescan only reads files that changed.
+namespace DuplicateFinder {
+
+/// Smaller files don't take up enough space to be worth linking
+constexpr qint64 MIN_FILE_SIZE = 4 * 1024;
+
+struct Group {
+	qint64 size = 0;
+	quint64 hash = 0;
+	/// One entry per distinct file on disk, holding every path already linked to it
+	QList<QStringList> copies;
+
+	/// Bytes freed by linking every copy to the first one
+	[[nodiscard]] qint64 getReclaimableBytes() const { return this->size * (this->copies.size() - 1); }
+};
+
+struct Result {
+	/// Most reclaimable first
+	QList<Group> groups;
+	qint64 filesScanned = 0;
+	qint64 filesHashed = 0;
+	qint64 filesReused = 0;
+	qint64 reclaimableBytes = 0;
+};
+
+enum class LinkMode : unsigned char {
+	/// Every path shares one file, so editing one copy edits all of them
+	HARDLINK,
+	/// Copies share storage until one of them is written to (Btrfs, XFS, APFS)
+	REFLINK,
+};
+
+struct LinkResult {
+	qint64 filesReplaced = 0;
+	qint64 bytesReclaimed = 0;
+	/// Paths that weren't replaced, with the reason
+	QStringList failed;
+};
+
+[[nodiscard]] QString getDefaultCachePath();
+
+/// Scans every file under the roots, which may overlap
+[[nodiscard]] Result scan(const QStringList& roots, const QString& cachePath = getDefaultCachePath());
+
+/// False if this platform has no way to make reflinks, a filesystem without them still fails per file
+[[nodiscard]] bool supportsReflinks();
+
+/// Replaces every copy after the first in each group. Copies are compared byte for byte before they're replaced,
+/// the hash only narrows down what to compare.
+[[nodiscard]] LinkResult link(const QList<Group>& groups, LinkMode mode);
+
+} // namespace DuplicateFinder
@@ -0,0 +1,211 @@
+#include "Extract.h"
+
+#include <optional>
+#include <utility>
+
+#include <miniz.h>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+
+#include "ArchiveReader.h"
+#include "ExtractionSink.h"
+
+namespace {
+
+[[nodiscard]] std::optional<TemplateFile> getFileOnDisk(const QString& path) {
+	QFile file{path};
+	if (!file.open(QIODevice::ReadOnly)) {
+		return std::nullopt;
+	}
+	TemplateFile out{MZ_CRC32_INIT, static_cast<quint64>(file.size())};
+	static constexpr qint64 CHUNK_SIZE = 1024 * 1024;
+	QByteArray buffer(CHUNK_SIZE, Qt::Uninitialized);
+	qint64 read;
+	while ((read = file.read(buffer.data(), CHUNK_SIZE)) > 0) {
+		out.crc32 = static_cast<quint32>(mz_crc32(out.crc32, reinterpret_cast<const mz_uint8*>(buffer.constData()), static_cast<size_t>(read)));
+	}
+	return out;
+}
+
+/// Only hashes the file on disk if its size matches one of the candidates, otherwise it can't match either
+[[nodiscard]] bool fileOnDiskMatches(const QString& path, const TemplateFile& candidate, std::optional<TemplateFile>& cached) {
+	if (static_cast<quint64>(QFileInfo{path}.size()) != candidate.size) {
+		return false;
+	}
+	if (!cached) {
+		cached = ::getFileOnDisk(path);
+	}
+	return cached && *cached == candidate;
+}
+
+} // namespace
+
+bool extractZIP(const QByteArray& zip, const QString& outputDir, ExtractionSink& sink, TemplateManifest* manifest, const ExtractProgressCallback& progress, QStringList* skippedLinks) {
+	const auto reader = ArchiveReader::open(zip, outputDir, sink, progress);
+	if (!reader) {
+		return false;
+	}
+	if (skippedLinks) {
+		*skippedLinks = reader->getSkippedLinks();
+	}
+	const auto& files = reader->getFiles();
+
+	qsizetype written = 0;
+	for (qsizetype i = 0; i < files.size(); i++) {
+		if (progress && !progress(written, files.size())) {
+			return false;
+		}
+
+		const auto& file = files[i];
+		if (!reader->extract(i, outputDir + '/' + file.path, sink)) {
+			return false;
+		}
+		if (manifest) {
+			(*manifest)[file.path] = file.info;
+		}
+		written++;
+	}
+	if (!sink.finish()) {
+		return false;
+	}
+	if (progress) {
+		progress(written, files.size());
+	}
+	return true;
+}
+
+bool updateFromZIP(const QByteArray& zip, const QString& modDir, ExtractionSink& sink, TemplateManifest& manifest, TemplateUpdateReport& report, const ExtractProgressCallback& progress) {
+	const auto reader = ArchiveReader::open(zip, modDir, sink, progress);
+	if (!reader) {
+		return false;
+	}
+	report.skippedLinks = reader->getSkippedLinks();
+	const auto& files = reader->getFiles();
+
+	TemplateManifest newManifest;
+	qsizetype processed = 0;
+	for (qsizetype i = 0; i < files.size(); i++) {
+		if (progress && !progress(processed, files.size())) {
+			return false;
+		}
+		processed++;
+
+		const auto& file = files[i];
+
+		const auto installed = manifest.constFind(file.path);
+		const bool wasInstalled = installed != manifest.constEnd();
+
+		// Unchanged in the template, whatever is on disk is left alone
+		if (wasInstalled && *installed == file.info) {
+			newManifest[file.path] = file.info;
+			continue;
+		}
+
+		const auto diskPath = modDir + '/' + file.path;
+		std::optional<TemplateFile> onDisk;
+		if (!QFileInfo::exists(diskPath)) {
+			if (wasInstalled) {
+				// The user deleted a file the template changed
+				report.conflicts.push_back(file.path);
+				newManifest[file.path] = *installed;
+				continue;
+			}
+			report.added.push_back(file.path);
+		} else if (::fileOnDiskMatches(diskPath, file.info, onDisk)) {
+			// Already up to date
+			newManifest[file.path] = file.info;
+			continue;
+		} else if (wasInstalled && ::fileOnDiskMatches(diskPath, *installed, onDisk)) {
+			report.updated.push_back(file.path);
+		} else {
+			// Modified by the user, or not created by the template
+			report.conflicts.push_back(file.path);
+			if (wasInstalled) {
+				newManifest[file.path] = *installed;
+			}
+			continue;
+		}
+
+		if (!reader->extract(i, diskPath, sink)) {
+			return false;
+		}
+		newManifest[file.path] = file.info;
+	}
+	if (!sink.finish()) {
+		return false;
+	}
+
+	// Remove files the template no longer has, unless the user modified them
+	for (const auto& [path, installed] : manifest.asKeyValueRange()) {
+		if (newManifest.contains(path)) {
+			continue;
+		}
+		const auto diskPath = modDir + '/' + path;
+		if (!QFileInfo::exists(diskPath)) {
+			continue;
+		}
+		if (std::optional<TemplateFile> onDisk; ::fileOnDiskMatches(diskPath, installed, onDisk) && QFile::remove(diskPath)) {
+			report.removed.push_back(path);
+		} else {
+			report.conflicts.push_back(path);
+			newManifest[path] = installed;
+		}
+	}
+
+	manifest = std::move(newManifest);
+	if (progress) {
+		progress(processed, files.size());
+	}
+	return true;
+}
+
+TemplateManifest readTemplateManifest(const QString& modDir) {
+	QFile file{modDir + '/' + TEMPLATE_MANIFEST_FILENAME};
+	if (!file.open(QIODevice::ReadOnly)) {
+		return {};
+	}
+	const auto manifestJson = QJsonDocument::fromJson(file.readAll());
+	if (!manifestJson.isObject() || !manifestJson.object()["files"].isObject()) {
+		return {};
+	}
+
+	TemplateManifest manifest;
+	const auto filesObject = manifestJson.object()["files"].toObject();
+	for (auto it = filesObject.constBegin(); it != filesObject.constEnd(); ++it) {
+		if (!it.value().isObject()) {
+			continue;
+		}
+		const auto fileObject = it.value().toObject();
+		manifest[it.key()] = {
+			static_cast<quint32>(fileObject["crc32"].toInteger()),
+			static_cast<quint64>(fileObject["size"].toInteger()),
+		};
+	}
+	return manifest;
+}
+
+bool writeTemplateManifest(const QString& modDir, const TemplateManifest& manifest) {
+	QJsonObject filesObject;
+	for (const auto& [path, info] : manifest.asKeyValueRange()) {
+		filesObject[path] = QJsonObject{
+			{"crc32", static_cast<qint64>(info.crc32)},
+			{"size", static_cast<qint64>(info.size)},
+		};
+	}
+
+	// Written to the side and swapped in, a truncated manifest would make every later update report conflicts
+	QSaveFile file{modDir + '/' + TEMPLATE_MANIFEST_FILENAME};
+	if (!file.open(QIODevice::WriteOnly)) {
+		return false;
+	}
+	const auto json = QJsonDocument{QJsonObject{{"files", filesObject}}}.toJson();
+	if (file.write(json) != json.size()) {
+		file.cancelWriting();
+		return false;
+	}
+	return file.commit();
+}
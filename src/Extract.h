@@ -0,0 +1,52 @@
+#pragma once
+
+#include <functional>
+
+#include <QByteArray>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+class ExtractionSink;
+
+/// Name of the file recording which template files were installed into a mod
+constexpr auto TEMPLATE_MANIFEST_FILENAME = ".sdk_launcher_template.json";
+
+struct TemplateFile {
+	quint32 crc32;
+	quint64 size;
+
+	[[nodiscard]] bool operator==(const TemplateFile& other) const = default;
+};
+
+/// Maps paths relative to the mod folder to the template files installed there
+using TemplateManifest = QMap<QString, TemplateFile>;
+
+struct TemplateUpdateReport {
+	QStringList added;
+	QStringList updated;
+	QStringList removed;
+	QStringList conflicts;
+	/// Links in the template, which are never extracted
+	QStringList skippedLinks;
+};
+
+/// Called with the progress so far and the total, in files, or in KiB of the archive while one that can only be read
+/// front to back is decompressed. Returning false cancels extraction. May be called from a worker thread.
+using ExtractProgressCallback = std::function<bool(qsizetype, qsizetype)>;
+
+/// Extracts a template archive held in memory to the output directory, stripping any root directories shared by every file.
+/// The archive may be a zip or a zstd compressed tar, see ArchiveReader::open.
+/// If a manifest is given, it is filled with every file that was written. Links in the archive are never extracted,
+/// they're listed in skippedLinks if it's given.
+[[nodiscard]] bool extractZIP(const QByteArray& zip, const QString& outputDir, ExtractionSink& sink, TemplateManifest* manifest = nullptr, const ExtractProgressCallback& progress = {}, QStringList* skippedLinks = nullptr);
+
+/// Updates a mod created from an older revision of the template. Only files that changed in the template are written,
+/// and files the user modified since they were installed are left alone and reported as conflicts.
+/// The manifest is updated to match the files on disk.
+[[nodiscard]] bool updateFromZIP(const QByteArray& zip, const QString& modDir, ExtractionSink& sink, TemplateManifest& manifest, TemplateUpdateReport& report, const ExtractProgressCallback& progress = {});
+
+/// Returns an empty manifest if the mod doesn't have one
+[[nodiscard]] TemplateManifest readTemplateManifest(const QString& modDir);
+
+[[nodiscard]] bool writeTemplateManifest(const QString& modDir, const TemplateManifest& manifest);
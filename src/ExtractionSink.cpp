@@ -0,0 +1,286 @@
+#include "ExtractionSink.h"
+
+#include <climits>
+#include <filesystem>
+#include <utility>
+#include <vector>
+
+#include <QFile>
+#include <QFileInfo>
+
+#ifdef SDK_LAUNCHER_USE_IO_URING
+	#include <cerrno>
+	#include <fcntl.h>
+	#include <liburing.h>
+#endif
+
+bool QFileExtractionSink::write(const QString& path, QByteArray data) {
+	std::error_code ec;
+	std::filesystem::create_directories(std::filesystem::path{path.toLocal8Bit().constData()}.parent_path(), ec);
+
+	QFile file{path};
+	if (!file.open(QIODevice::WriteOnly)) {
+		return false;
+	}
+	if (file.write(data) != data.size()) {
+		return false;
+	}
+	// Buffered data is only flushed on close, so a full disk may not show up until then
+	file.close();
+	return file.error() == QFileDevice::NoError;
+}
+
+bool QFileExtractionSink::finish() {
+	return true;
+}
+
+#ifdef SDK_LAUNCHER_USE_IO_URING
+
+namespace {
+
+/// Batches directory creation, file creation, preallocation, writes and closes into io_uring submissions.
+/// Files are opened into a fixed file table, so a file's open, write and close can be linked into one chain.
+class IOUringExtractionSink : public ExtractionSink {
+public:
+	[[nodiscard]] static std::unique_ptr<IOUringExtractionSink> create() {
+		std::unique_ptr<IOUringExtractionSink> sink{new IOUringExtractionSink};
+		if (io_uring_queue_init(BATCH_SIZE * OPS_PER_FILE, &sink->ring, 0) < 0) {
+			return nullptr;
+		}
+		sink->ringInitialized = true;
+
+		auto* probe = io_uring_get_probe_ring(&sink->ring);
+		if (!probe) {
+			return nullptr;
+		}
+		const bool supported =
+			io_uring_opcode_supported(probe, IORING_OP_MKDIRAT) &&
+			io_uring_opcode_supported(probe, IORING_OP_OPENAT) &&
+			io_uring_opcode_supported(probe, IORING_OP_FALLOCATE) &&
+			io_uring_opcode_supported(probe, IORING_OP_WRITE) &&
+			io_uring_opcode_supported(probe, IORING_OP_CLOSE);
+		io_uring_free_probe(probe);
+		if (!supported || io_uring_register_files_sparse(&sink->ring, BATCH_SIZE) < 0) {
+			return nullptr;
+		}
+		return sink;
+	}
+
+	~IOUringExtractionSink() override {
+		if (this->ringInitialized) {
+			io_uring_queue_exit(&this->ring);
+		}
+	}
+
+	[[nodiscard]] bool write(const QString& path, QByteArray data) override {
+		// io_uring writes are limited to 32-bit lengths, let QFile handle anything larger
+		if (data.size() > INT_MAX) {
+			return this->fallback.write(path, std::move(data));
+		}
+		this->batch.push_back({QFile::encodeName(path), std::move(data)});
+		if (this->batch.size() >= BATCH_SIZE) {
+			return this->submitBatch();
+		}
+		return !this->failed;
+	}
+
+	[[nodiscard]] bool finish() override {
+		if (!this->batch.empty()) {
+			(void) this->submitBatch();
+		}
+		return !this->failed;
+	}
+
+private:
+	static constexpr unsigned BATCH_SIZE = 64;
+	static constexpr unsigned OPS_PER_FILE = 4;
+
+	struct PendingFile {
+		QByteArray path;
+		QByteArray data;
+	};
+
+	io_uring ring{};
+	bool ringInitialized = false;
+	bool failed = false;
+	unsigned inFlight = 0;
+	std::vector<PendingFile> batch;
+	/// Batch slots whose write completed with fewer bytes than queued, and how many bytes made it
+	std::vector<std::pair<unsigned, qint64>> shortWrites;
+	QSet<QByteArray> createdDirectories;
+	QFileExtractionSink fallback;
+
+	IOUringExtractionSink() {
+		this->batch.reserve(BATCH_SIZE);
+	}
+
+	[[nodiscard]] io_uring_sqe* getSQE() {
+		auto* sqe = io_uring_get_sqe(&this->ring);
+		if (!sqe) {
+			// Submission queue is full, flush it and try again
+			(void) this->submitAndReap();
+			sqe = io_uring_get_sqe(&this->ring);
+		}
+		if (sqe) {
+			this->inFlight++;
+		}
+		return sqe;
+	}
+
+	/// Submits everything queued and waits for all of it to complete
+	[[nodiscard]] bool submitAndReap() {
+		const auto count = this->inFlight;
+		this->inFlight = 0;
+		if (count == 0) {
+			return !this->failed;
+		}
+		if (io_uring_submit_and_wait(&this->ring, count) < 0) {
+			this->failed = true;
+			return false;
+		}
+		for (unsigned reaped = 0; reaped < count; reaped++) {
+			io_uring_cqe* cqe;
+			if (io_uring_wait_cqe(&this->ring, &cqe) < 0) {
+				this->failed = true;
+				return false;
+			}
+			// Not every filesystem supports preallocation, and directories may already exist
+			const auto data = io_uring_cqe_get_data64(cqe);
+			if (const auto kind = static_cast<OpKind>(data & 0xff); cqe->res < 0 && kind != OpKind::FALLOCATE && !(kind == OpKind::MKDIR && cqe->res == -EEXIST)) {
+				this->failed = true;
+			} else if (kind == OpKind::WRITE && static_cast<qint64>(cqe->res) < this->batch[data >> 8].data.size()) {
+				// The file is closed by the time this is known, the rest is written once the batch is done
+				this->shortWrites.emplace_back(static_cast<unsigned>(data >> 8), cqe->res);
+			}
+			io_uring_cqe_seen(&this->ring, cqe);
+		}
+		return !this->failed;
+	}
+
+	enum class OpKind : unsigned char {
+		MKDIR,
+		OPEN,
+		FALLOCATE,
+		WRITE,
+		CLOSE,
+	};
+
+	/// The kind goes in the low byte, and writes carry their batch slot above it
+	[[nodiscard]] __u64 getOpData(OpKind kind, unsigned slot) const {
+		return static_cast<__u64>(kind) | (static_cast<__u64>(slot) << 8);
+	}
+
+	/// Finishes a file that io_uring only partly wrote, picking up where the write stopped
+	[[nodiscard]] bool writeRemainder(const PendingFile& file, qint64 written) const {
+		QFile out{QFile::decodeName(file.path)};
+		if (!out.open(QIODevice::ReadWrite) || !out.seek(written)) {
+			return false;
+		}
+		const auto remainder = QByteArrayView{file.data}.sliced(written);
+		return out.write(remainder.data(), remainder.size()) == remainder.size();
+	}
+
+	[[nodiscard]] bool createDirectories() {
+		// Collect missing directories, parents first
+		std::vector<QByteArray> directories;
+		for (const auto& file : this->batch) {
+			std::vector<QByteArray> chain;
+			for (auto dir = QFileInfo{QFile::decodeName(file.path)}.absolutePath(); !dir.isEmpty(); dir = QFileInfo{dir}.absolutePath()) {
+				auto encoded = QFile::encodeName(dir);
+				if (this->createdDirectories.contains(encoded) || QFileInfo{dir}.isRoot()) {
+					break;
+				}
+				this->createdDirectories.insert(encoded);
+				chain.push_back(std::move(encoded));
+			}
+			directories.insert(directories.end(), std::make_move_iterator(chain.rbegin()), std::make_move_iterator(chain.rend()));
+		}
+		if (directories.empty()) {
+			return true;
+		}
+
+		// Hard links keep the chain going if a directory already exists, while still creating parents first
+		for (const auto& directory : directories) {
+			auto* sqe = this->getSQE();
+			if (!sqe) {
+				this->failed = true;
+				return false;
+			}
+			io_uring_prep_mkdirat(sqe, AT_FDCWD, directory.constData(), 0755);
+			io_uring_sqe_set_data64(sqe, static_cast<__u64>(OpKind::MKDIR));
+			if (&directory != &directories.back()) {
+				sqe->flags |= IOSQE_IO_HARDLINK;
+			}
+		}
+		return this->submitAndReap();
+	}
+
+	[[nodiscard]] bool submitBatch() {
+		if (!this->createDirectories()) {
+			this->batch.clear();
+			return false;
+		}
+
+		for (unsigned slot = 0; slot < this->batch.size(); slot++) {
+			const auto& [path, data] = this->batch[slot];
+			// A file's ops are linked, so the whole chain has to fit in the ring before any of it is queued.
+			// With room for the chain, getSQE() can't come back empty below.
+			if (io_uring_sq_space_left(&this->ring) < OPS_PER_FILE) {
+				(void) this->submitAndReap();
+				if (io_uring_sq_space_left(&this->ring) < OPS_PER_FILE) {
+					this->failed = true;
+					break;
+				}
+			}
+
+			auto* sqe = this->getSQE();
+			io_uring_prep_openat_direct(sqe, AT_FDCWD, path.constData(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644, slot);
+			io_uring_sqe_set_data64(sqe, static_cast<__u64>(OpKind::OPEN));
+			sqe->flags |= IOSQE_IO_HARDLINK;
+
+			if (!data.isEmpty()) {
+				sqe = this->getSQE();
+				io_uring_prep_fallocate(sqe, static_cast<int>(slot), 0, 0, data.size());
+				io_uring_sqe_set_data64(sqe, static_cast<__u64>(OpKind::FALLOCATE));
+				sqe->flags |= IOSQE_FIXED_FILE | IOSQE_IO_HARDLINK;
+
+				sqe = this->getSQE();
+				io_uring_prep_write(sqe, static_cast<int>(slot), data.constData(), static_cast<unsigned>(data.size()), 0);
+				io_uring_sqe_set_data64(sqe, this->getOpData(OpKind::WRITE, slot));
+				sqe->flags |= IOSQE_FIXED_FILE | IOSQE_IO_HARDLINK;
+			}
+
+			// Always runs, even if something earlier in the chain failed, so the slot is released
+			sqe = this->getSQE();
+			io_uring_prep_close_direct(sqe, slot);
+			io_uring_sqe_set_data64(sqe, static_cast<__u64>(OpKind::CLOSE));
+		}
+		bool ok = this->submitAndReap();
+		for (const auto& [slot, written] : this->shortWrites) {
+			if (!this->writeRemainder(this->batch[slot], written)) {
+				this->failed = true;
+				ok = false;
+			}
+		}
+		this->shortWrites.clear();
+
+		// Buffers must stay alive until their writes complete
+		this->batch.clear();
+		return ok;
+	}
+};
+
+} // namespace
+
+#endif
+
+std::unique_ptr<ExtractionSink> ExtractionSink::create(Backend backend) {
+#ifdef SDK_LAUNCHER_USE_IO_URING
+	if (backend == Backend::DEFAULT || backend == Backend::IO_URING) {
+		if (auto sink = IOUringExtractionSink::create()) {
+			return sink;
+		}
+	}
+#endif
+	return std::make_unique<QFileExtractionSink>();
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <memory>
+
+#include <QByteArray>
+#include <QSet>
+#include <QString>
+
+/// Receives files extracted from a mod template and writes them to disk.
+/// Writes may be queued, so the results are only known after finish() is called.
+class ExtractionSink {
+public:
+	enum class Backend : unsigned char {
+		DEFAULT,
+		QFILE,
+		IO_URING,
+	};
+
+	virtual ~ExtractionSink() = default;
+
+	/// Queues a file to be written, creating any missing parent directories. The path must be absolute.
+	[[nodiscard]] virtual bool write(const QString& path, QByteArray data) = 0;
+
+	/// Waits for every queued write, and returns false if any of them failed.
+	[[nodiscard]] virtual bool finish() = 0;
+
+	/// Creates a sink using the given backend, falling back to QFile if the backend isn't supported.
+	[[nodiscard]] static std::unique_ptr<ExtractionSink> create(Backend backend = Backend::DEFAULT);
+};
+
+/// Writes every file synchronously through QFile.
+class QFileExtractionSink : public ExtractionSink {
+public:
+	[[nodiscard]] bool write(const QString& path, QByteArray data) override;
+
+	[[nodiscard]] bool finish() override;
+};
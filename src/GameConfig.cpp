@@ -1,10 +1,679 @@
 #include "GameConfig.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+
+#include <QDateTime>
 #include <QDir>
 #include <QFile>
-#include <QJsonArray>
-#include <QJsonDocument>
-#include <QJsonObject>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QRegularExpression>
+#include <QThread>
+
+#include "BuiltinGameConfig.h"
+#include "JSONReader.h"
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace {
+
+/// Wraps the string without copying it, the data lives in the executable
+[[nodiscard]] QString fromBuiltinString(std::u16string_view str) {
+	return QString::fromRawData(reinterpret_cast<const QChar*>(str.data()), static_cast<qsizetype>(str.size()));
+}
+
+/// The cores this process is allowed to run on, which children inherit unless they're given their own affinity
+[[nodiscard]] QList<int> getAllowedCPUs() {
+	QList<int> cpus;
+#ifdef __linux__
+	if (cpu_set_t allowed; ::sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+		for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+			if (CPU_ISSET(cpu, &allowed)) {
+				cpus.push_back(cpu);
+			}
+		}
+	}
+#endif
+	if (cpus.isEmpty()) {
+		for (int cpu = 0; cpu < QThread::idealThreadCount(); cpu++) {
+			cpus.push_back(cpu);
+		}
+	}
+	return cpus;
+}
+
+void report(QList<GameConfig::Diagnostic>* diagnostics, JSONReader::Location location, const QString& message, const QString& file = {}) {
+	if (diagnostics) {
+		diagnostics->push_back({location.line, location.column, message, file});
+	}
+}
+
+/// Skips a value that has the wrong type, the config is still usable without it
+void skipWrongType(JSONReader& reader, QList<GameConfig::Diagnostic>* diagnostics, const QString& key, const char* expected) {
+	const auto location = reader.getLocation();
+	if (reader.skipValue()) {
+		::report(diagnostics, location, QString("\"%1\" should be %2, ignoring it").arg(key, expected));
+	}
+}
+
+[[nodiscard]] std::optional<QString> readString(JSONReader& reader, QList<GameConfig::Diagnostic>* diagnostics, const QString& key) {
+	if (reader.peek() != JSONReader::Type::STRING) {
+		::skipWrongType(reader, diagnostics, key, "a string");
+		return std::nullopt;
+	}
+	if (QString out; reader.readString(out)) {
+		return out;
+	}
+	return std::nullopt;
+}
+
+[[nodiscard]] std::optional<bool> readBool(JSONReader& reader, QList<GameConfig::Diagnostic>* diagnostics, const QString& key) {
+	if (reader.peek() != JSONReader::Type::BOOL) {
+		::skipWrongType(reader, diagnostics, key, "a boolean");
+		return std::nullopt;
+	}
+	if (bool out; reader.readBool(out)) {
+		return out;
+	}
+	return std::nullopt;
+}
+
+[[nodiscard]] std::optional<int> readInt(JSONReader& reader, QList<GameConfig::Diagnostic>* diagnostics, const QString& key) {
+	if (reader.peek() != JSONReader::Type::NUMBER) {
+		::skipWrongType(reader, diagnostics, key, "an integer");
+		return std::nullopt;
+	}
+	const auto location = reader.getLocation();
+	double out = 0.0;
+	if (!reader.readNumber(out)) {
+		return std::nullopt;
+	}
+	if (out != std::trunc(out) || out < std::numeric_limits<int>::min() || out > std::numeric_limits<int>::max()) {
+		::report(diagnostics, location, QString("\"%1\" should be an integer, ignoring it").arg(key));
+		return std::nullopt;
+	}
+	return static_cast<int>(out);
+}
+
+[[nodiscard]] QStringList readStringList(JSONReader& reader, QList<GameConfig::Diagnostic>* diagnostics, const QString& key) {
+	QStringList out;
+	if (reader.peek() != JSONReader::Type::ARRAY) {
+		::skipWrongType(reader, diagnostics, key, "an array of strings");
+		return out;
+	}
+	if (!reader.beginArray()) {
+		return out;
+	}
+	while (reader.nextElement()) {
+		if (auto str = ::readString(reader, diagnostics, key)) {
+			out.push_back(std::move(*str));
+		}
+	}
+	return out;
+}
+
+[[nodiscard]] QList<int> readIntList(JSONReader& reader, QList<GameConfig::Diagnostic>* diagnostics, const QString& key) {
+	QList<int> out;
+	if (reader.peek() != JSONReader::Type::ARRAY) {
+		::skipWrongType(reader, diagnostics, key, "an array of integers");
+		return out;
+	}
+	if (!reader.beginArray()) {
+		return out;
+	}
+	while (reader.nextElement()) {
+		if (const auto value = ::readInt(reader, diagnostics, key)) {
+			out.push_back(*value);
+		}
+	}
+	return out;
+}
+
+void readModTemplates(JSONReader& reader, QList<GameConfig::Diagnostic>* diagnostics, QMap<QString, GameConfig::ModTemplate>& modTemplates) {
+	if (reader.peek() == JSONReader::Type::STRING) {
+		if (auto url = ::readString(reader, diagnostics, "mod_template_url")) {
+			modTemplates["Mod Template"].url = *url;
+		}
+		return;
+	}
+	if (reader.peek() != JSONReader::Type::OBJECT) {
+		::skipWrongType(reader, diagnostics, "mod_template_url", "a string or an object");
+		return;
+	}
+
+	if (!reader.beginObject()) {
+		return;
+	}
+	QString name;
+	while (reader.nextKey(name)) {
+		if (reader.peek() == JSONReader::Type::STRING) {
+			if (auto url = ::readString(reader, diagnostics, name)) {
+				modTemplates[name].url = *url;
+			}
+			continue;
+		}
+		if (reader.peek() != JSONReader::Type::OBJECT) {
+			::skipWrongType(reader, diagnostics, name, "a string or an object");
+			continue;
+		}
+
+		// Templates can optionally be pinned to a checksum
+		const auto location = reader.getLocation();
+		if (!reader.beginObject()) {
+			break;
+		}
+		GameConfig::ModTemplate modTemplate;
+		QString key;
+		while (reader.nextKey(key)) {
+			if (key == "url") {
+				modTemplate.url = ::readString(reader, diagnostics, key).value_or(QString{});
+			} else if (key == "sha256") {
+				modTemplate.sha256 = ::readString(reader, diagnostics, key).value_or(QString{}).toLower();
+			} else if (!reader.skipValue()) {
+				break;
+			}
+		}
+		if (modTemplate.url.isEmpty()) {
+			::report(diagnostics, location, QString("Skipping mod template \"%1\", it is missing \"url\"").arg(name));
+			continue;
+		}
+		modTemplates[name] = std::move(modTemplate);
+	}
+}
+
+/// An entry as written in the config, before its strings are interned
+struct EntryFields {
+	QString file;
+	JSONReader::Location location;
+	std::optional<QString> name;
+	std::optional<QString> type;
+	std::optional<QString> action;
+	QStringList arguments;
+	QString iconOverride;
+	int priority = 0;
+	QList<int> cpuAffinity;
+	QList<std::pair<QString, QString>> environment;
+	int memoryLimitMB = 0;
+	int instances = 1;
+	int instanceStaggerMs = DEFAULT_INSTANCE_STAGGER_MS;
+	bool instanceSpreadCPUs = false;
+	QString progressPattern;
+	int progressMax = DEFAULT_PROGRESS_MAX;
+	QString progressPhasePattern;
+	unsigned char os = static_cast<unsigned char>(GameConfig::OS::ALL);
+	/// Removes the entry with the same name from the section being extended
+	bool remove = false;
+};
+
+struct SectionFields {
+	QString file;
+	JSONReader::Location location;
+	std::optional<QString> name;
+	bool hasEntries = false;
+	QList<EntryFields> entries;
+	/// Stands in for the sections of another config, resolved relative to this one
+	std::optional<QString> include;
+	/// Removes the section with the same name from the config being extended
+	bool remove = false;
+	/// Replaces the entries of the section with the same name instead of adding to them
+	bool replace = false;
+};
+
+void readEntry(JSONReader& reader, QList<GameConfig::Diagnostic>* diagnostics, EntryFields& entry) {
+	QString key;
+	while (reader.nextKey(key)) {
+		if (key == "name") {
+			entry.name = ::readString(reader, diagnostics, key);
+		} else if (key == "type") {
+			entry.type = ::readString(reader, diagnostics, key);
+		} else if (key == "action") {
+			entry.action = ::readString(reader, diagnostics, key);
+		} else if (key == "arguments") {
+			entry.arguments = ::readStringList(reader, diagnostics, key);
+		} else if (key == "icon_override") {
+			entry.iconOverride = ::readString(reader, diagnostics, key).value_or(QString{});
+		} else if (key == "priority") {
+			entry.priority = ::readInt(reader, diagnostics, key).value_or(0);
+		} else if (key == "cpu_affinity") {
+			entry.cpuAffinity = ::readIntList(reader, diagnostics, key);
+		} else if (key == "environment") {
+			if (reader.peek() != JSONReader::Type::OBJECT) {
+				::skipWrongType(reader, diagnostics, key, "an object");
+				continue;
+			}
+			if (!reader.beginObject()) {
+				break;
+			}
+			QString variable;
+			while (reader.nextKey(variable)) {
+				if (auto value = ::readString(reader, diagnostics, variable)) {
+					entry.environment.emplace_back(variable, std::move(*value));
+				}
+			}
+		} else if (key == "memory_limit_mb") {
+			entry.memoryLimitMB = ::readInt(reader, diagnostics, key).value_or(0);
+		} else if (key == "instances") {
+			const auto location = reader.getLocation();
+			if (const auto instances = ::readInt(reader, diagnostics, key)) {
+				if (*instances < 1 || *instances > MAX_INSTANCES) {
+					::report(diagnostics, location, QString("\"%1\" should be between 1 and %2, clamping it").arg(key).arg(MAX_INSTANCES));
+				}
+				entry.instances = std::clamp(*instances, 1, MAX_INSTANCES);
+			}
+		} else if (key == "instance_stagger_ms") {
+			entry.instanceStaggerMs = std::max(::readInt(reader, diagnostics, key).value_or(DEFAULT_INSTANCE_STAGGER_MS), 0);
+		} else if (key == "instance_spread_cpus") {
+			entry.instanceSpreadCPUs = ::readBool(reader, diagnostics, key).value_or(false);
+		} else if (key == "progress_pattern") {
+			const auto location = reader.getLocation();
+			if (auto pattern = ::readString(reader, diagnostics, key)) {
+				if (const QRegularExpression regex{*pattern}; !regex.isValid()) {
+					::report(diagnostics, location, QString("\"%1\" is not a valid regex: %2").arg(key, regex.errorString()));
+				} else {
+					entry.progressPattern = std::move(*pattern);
+				}
+			}
+		} else if (key == "progress_max") {
+			entry.progressMax = std::max(::readInt(reader, diagnostics, key).value_or(DEFAULT_PROGRESS_MAX), 1);
+		} else if (key == "progress_phase_pattern") {
+			const auto location = reader.getLocation();
+			if (auto pattern = ::readString(reader, diagnostics, key)) {
+				if (const QRegularExpression regex{*pattern}; !regex.isValid()) {
+					::report(diagnostics, location, QString("\"%1\" is not a valid regex: %2").arg(key, regex.errorString()));
+				} else {
+					entry.progressPhasePattern = std::move(*pattern);
+				}
+			}
+		} else if (key == "os") {
+			const auto location = reader.getLocation();
+			if (const auto os = ::readString(reader, diagnostics, key)) {
+				// Anything unrecognized would otherwise quietly show the entry on every OS
+				for (const auto& name : os->split(',', Qt::SkipEmptyParts)) {
+					if (const auto trimmed = name.trimmed(); trimmed != "windows" && trimmed != "linux" && trimmed != "macos") {
+						::report(diagnostics, location, QString("Unknown OS \"%1\" in \"%2\"").arg(trimmed, key));
+					}
+				}
+				entry.os = static_cast<unsigned char>(GameConfig::osFromString(*os));
+			}
+		} else if (key == "remove") {
+			entry.remove = ::readBool(reader, diagnostics, key).value_or(false);
+		} else if (!reader.skipValue()) {
+			break;
+		}
+	}
+}
+
+void readSections(JSONReader& reader, QList<GameConfig::Diagnostic>* diagnostics, QList<SectionFields>& sections) {
+	if (!reader.beginArray()) {
+		return;
+	}
+	while (reader.nextElement()) {
+		if (reader.peek() != JSONReader::Type::OBJECT) {
+			::skipWrongType(reader, diagnostics, "sections", "an array of objects");
+			continue;
+		}
+
+		auto& section = sections.emplace_back();
+		section.location = reader.getLocation();
+		if (!reader.beginObject()) {
+			return;
+		}
+		QString key;
+		while (reader.nextKey(key)) {
+			if (key == "name") {
+				section.name = ::readString(reader, diagnostics, key);
+			} else if (key == "include") {
+				section.include = ::readString(reader, diagnostics, key);
+			} else if (key == "remove") {
+				section.remove = ::readBool(reader, diagnostics, key).value_or(false);
+			} else if (key == "replace") {
+				section.replace = ::readBool(reader, diagnostics, key).value_or(false);
+			} else if (key == "entries") {
+				if (reader.peek() != JSONReader::Type::ARRAY) {
+					::skipWrongType(reader, diagnostics, key, "an array");
+					continue;
+				}
+				section.hasEntries = true;
+				if (!reader.beginArray()) {
+					return;
+				}
+				while (reader.nextElement()) {
+					if (reader.peek() != JSONReader::Type::OBJECT) {
+						::skipWrongType(reader, diagnostics, key, "an array of objects");
+						continue;
+					}
+					auto& entry = section.entries.emplace_back();
+					entry.location = reader.getLocation();
+					if (!reader.beginObject()) {
+						return;
+					}
+					::readEntry(reader, diagnostics, entry);
+				}
+			} else if (!reader.skipValue()) {
+				return;
+			}
+		}
+	}
+}
+
+/// A config file as written, before the configs it extends are applied
+struct Fragment {
+	/// Syntax errors in any file a config is built from fail the whole config
+	bool failed = false;
+	QStringList extends;
+	std::optional<QString> gameDefault;
+	std::optional<QString> gameIcon;
+	std::optional<bool> usesLegacyBinDir;
+	std::optional<int> windowWidth;
+	std::optional<int> windowHeight;
+	QMap<QString, GameConfig::ModTemplate> modTemplates;
+	std::optional<bool> p2ceAddonsSupported;
+	QStringList prewarmFiles;
+	std::optional<int> prewarmBudgetMB;
+	bool hasSections = false;
+	QList<SectionFields> sections;
+	QList<GameConfig::Diagnostic> diagnostics;
+};
+
+/// Cache key for a config, resources are left alone since they can't be made absolute
+[[nodiscard]] QString getConfigKey(const QString& path) {
+	return path.startsWith(':') ? QDir::cleanPath(path) : QFileInfo{path}.absoluteFilePath();
+}
+
+/// Configs referenced from another config are relative to it
+[[nodiscard]] QString resolveConfigReference(const QString& from, const QString& reference) {
+	return ::getConfigKey(QFileInfo{from}.dir().filePath(reference));
+}
+
+/// Milliseconds since epoch, 0 for resources since they can't change, and -1 if the file doesn't exist
+[[nodiscard]] qint64 getConfigModified(const QString& path) {
+	if (path.startsWith(':')) {
+		return 0;
+	}
+	const QFileInfo info{path};
+	return info.exists() ? info.lastModified().toMSecsSinceEpoch() : -1;
+}
+
+[[nodiscard]] Fragment parseFragment(const QString& path) {
+	Fragment fragment;
+	auto* diagnostics = &fragment.diagnostics;
+
+	QFile file(path);
+	if (!file.open(QIODevice::ReadOnly)) {
+		::report(diagnostics, {0, 0}, QString("Could not open %1").arg(path), path);
+		fragment.failed = true;
+		return fragment;
+	}
+	// Parse straight out of the page cache when the file can be mapped
+	QByteArray contents;
+	QByteArrayView data;
+	if (const auto* mapped = file.size() > 0 ? file.map(0, file.size()) : nullptr) {
+		data = {mapped, file.size()};
+	} else {
+		contents = file.readAll();
+		data = contents;
+	}
+
+	JSONReader reader{data};
+	if (reader.beginObject()) {
+		QString key;
+		while (reader.nextKey(key)) {
+			if (key == "extends") {
+				if (reader.peek() == JSONReader::Type::STRING) {
+					if (const auto base = ::readString(reader, diagnostics, key)) {
+						fragment.extends.push_back(::resolveConfigReference(path, *base));
+					}
+				} else {
+					for (const auto& base : ::readStringList(reader, diagnostics, key)) {
+						fragment.extends.push_back(::resolveConfigReference(path, base));
+					}
+				}
+			} else if (key == "game_default") {
+				fragment.gameDefault = ::readString(reader, diagnostics, key);
+			} else if (key == "game_icon") {
+				fragment.gameIcon = ::readString(reader, diagnostics, key);
+			} else if (key == "uses_legacy_bin_dir") {
+				fragment.usesLegacyBinDir = ::readBool(reader, diagnostics, key);
+			} else if (key == "window_width") {
+				fragment.windowWidth = ::readInt(reader, diagnostics, key).value_or(DEFAULT_WINDOW_WIDTH);
+			} else if (key == "window_height") {
+				fragment.windowHeight = ::readInt(reader, diagnostics, key).value_or(DEFAULT_WINDOW_HEIGHT);
+			} else if (key == "mod_template_url") {
+				::readModTemplates(reader, diagnostics, fragment.modTemplates);
+			} else if (key == "supports_p2ce_addons") {
+				fragment.p2ceAddonsSupported = ::readBool(reader, diagnostics, key);
+			} else if (key == "prewarm_files") {
+				fragment.prewarmFiles += ::readStringList(reader, diagnostics, key);
+			} else if (key == "prewarm_budget_mb") {
+				fragment.prewarmBudgetMB = ::readInt(reader, diagnostics, key).value_or(DEFAULT_PREWARM_BUDGET_MB);
+			} else if (key == "sections") {
+				if (reader.peek() == JSONReader::Type::ARRAY) {
+					fragment.hasSections = true;
+					::readSections(reader, diagnostics, fragment.sections);
+				} else {
+					::skipWrongType(reader, diagnostics, key, "an array");
+				}
+			} else if (!reader.skipValue()) {
+				break;
+			}
+		}
+	}
+	if (reader.hasError() || !reader.finish()) {
+		::report(diagnostics, reader.getErrorLocation(), reader.getError());
+		fragment.failed = true;
+	}
+
+	// Sections and entries can end up in another config, so they remember where they came from
+	for (auto& diagnostic : fragment.diagnostics) {
+		diagnostic.file = path;
+	}
+	for (auto& section : fragment.sections) {
+		section.file = path;
+		if (section.include) {
+			section.include = ::resolveConfigReference(path, *section.include);
+		}
+		for (auto& entry : section.entries) {
+			entry.file = path;
+		}
+	}
+	return fragment;
+}
+
+/// Applies a config over the configs it extends. Sections are matched to the ones they extend by name, and add their
+/// entries to them. Entries with the same name as one in the section they extend replace it where it was.
+void mergeFragment(Fragment& target, const Fragment& layer) {
+	target.failed = target.failed || layer.failed;
+	target.diagnostics += layer.diagnostics;
+	if (layer.gameDefault) {
+		target.gameDefault = layer.gameDefault;
+	}
+	if (layer.gameIcon) {
+		target.gameIcon = layer.gameIcon;
+	}
+	if (layer.usesLegacyBinDir) {
+		target.usesLegacyBinDir = layer.usesLegacyBinDir;
+	}
+	if (layer.windowWidth) {
+		target.windowWidth = layer.windowWidth;
+	}
+	if (layer.windowHeight) {
+		target.windowHeight = layer.windowHeight;
+	}
+	for (const auto& [name, modTemplate] : layer.modTemplates.asKeyValueRange()) {
+		target.modTemplates[name] = modTemplate;
+	}
+	if (layer.p2ceAddonsSupported) {
+		target.p2ceAddonsSupported = layer.p2ceAddonsSupported;
+	}
+	for (const auto& prewarmFile : layer.prewarmFiles) {
+		if (!target.prewarmFiles.contains(prewarmFile)) {
+			target.prewarmFiles.push_back(prewarmFile);
+		}
+	}
+	if (layer.prewarmBudgetMB) {
+		target.prewarmBudgetMB = layer.prewarmBudgetMB;
+	}
+	target.hasSections = target.hasSections || layer.hasSections;
+
+	// Only sections and entries from the bases are matched, duplicates within one config are kept as they are
+	qsizetype baseSectionCount = target.sections.size();
+	for (const auto& section : layer.sections) {
+		qsizetype baseSection = -1;
+		for (qsizetype i = 0; section.name && i < baseSectionCount; i++) {
+			if (target.sections[i].name == section.name) {
+				baseSection = i;
+				break;
+			}
+		}
+		if (section.remove) {
+			if (baseSection >= 0) {
+				target.sections.removeAt(baseSection);
+				baseSectionCount--;
+			}
+			continue;
+		}
+		if (baseSection < 0) {
+			target.sections.push_back(section);
+			continue;
+		}
+
+		auto& base = target.sections[baseSection];
+		if (section.replace) {
+			base.entries = section.entries;
+			continue;
+		}
+		qsizetype baseEntryCount = base.entries.size();
+		for (const auto& entry : section.entries) {
+			qsizetype baseEntry = -1;
+			for (qsizetype i = 0; entry.name && i < baseEntryCount; i++) {
+				if (base.entries[i].name == entry.name) {
+					baseEntry = i;
+					break;
+				}
+			}
+			if (entry.remove) {
+				if (baseEntry >= 0) {
+					base.entries.removeAt(baseEntry);
+					baseEntryCount--;
+				}
+			} else if (baseEntry >= 0) {
+				base.entries[baseEntry] = entry;
+			} else {
+				base.entries.push_back(entry);
+			}
+		}
+	}
+}
+
+struct CachedFragment {
+	qint64 modified = -1;
+	std::shared_ptr<const Fragment> parsed;
+	/// The fragment with everything it extends and includes applied, valid while none of its dependencies changed
+	std::shared_ptr<const Fragment> resolved;
+	QList<std::pair<QString, qint64>> dependencies;
+};
+
+QMutex g_fragmentCacheMutex;
+QHash<QString, CachedFragment> g_fragmentCache;
+
+/// Parses a config and everything it extends or includes, reusing whatever didn't change since it was last parsed.
+/// Every file the result was built from is added to the dependencies, along with its modification time.
+// NOLINTNEXTLINE(*-no-recursion)
+[[nodiscard]] std::shared_ptr<const Fragment> resolveFragment(const QString& path, QStringList& stack, QList<std::pair<QString, qint64>>& dependencies) {
+	const auto modified = ::getConfigModified(path);
+	CachedFragment cached;
+	{
+		QMutexLocker lock{&g_fragmentCacheMutex};
+		cached = g_fragmentCache.value(path);
+	}
+	if (!cached.parsed || cached.modified != modified) {
+		cached = {modified, std::make_shared<const Fragment>(::parseFragment(path)), nullptr, {}};
+	} else if (cached.resolved && std::all_of(cached.dependencies.begin(), cached.dependencies.end(), [](const auto& dependency) { return ::getConfigModified(dependency.first) == dependency.second; })) {
+		dependencies += cached.dependencies;
+		return cached.resolved;
+	}
+
+	auto resolved = std::make_shared<Fragment>();
+	QList<std::pair<QString, qint64>> ownDependencies{{path, modified}};
+	bool cyclic = false;
+	stack.push_back(path);
+	const auto resolveReference = [&](const QString& reference, JSONReader::Location location) -> std::shared_ptr<const Fragment> {
+		if (stack.contains(reference)) {
+			::report(&resolved->diagnostics, location, QString("%1 extends or includes itself through %2").arg(QFileInfo{path}.fileName(), QFileInfo{reference}.fileName()), path);
+			resolved->failed = true;
+			cyclic = true;
+			return nullptr;
+		}
+		return ::resolveFragment(reference, stack, ownDependencies);
+	};
+
+	for (const auto& base : cached.parsed->extends) {
+		if (const auto baseFragment = resolveReference(base, {0, 0})) {
+			::mergeFragment(*resolved, *baseFragment);
+		}
+	}
+
+	// Included sections are spliced in where the include was, then the config is applied over its bases
+	Fragment layer = *cached.parsed;
+	layer.sections.clear();
+	for (const auto& section : cached.parsed->sections) {
+		if (!section.include) {
+			layer.sections.push_back(section);
+			continue;
+		}
+		if (const auto included = resolveReference(*section.include, section.location)) {
+			layer.failed = layer.failed || included->failed;
+			layer.diagnostics += included->diagnostics;
+			layer.sections += included->sections;
+		}
+	}
+	::mergeFragment(*resolved, layer);
+	stack.pop_back();
+
+	// A cycle is reported from wherever it was entered, so that result is not worth keeping
+	if (!cyclic) {
+		cached.resolved = resolved;
+		cached.dependencies = ownDependencies;
+	}
+	{
+		QMutexLocker lock{&g_fragmentCacheMutex};
+		g_fragmentCache[path] = cached;
+	}
+	dependencies += ownDependencies;
+	return resolved;
+}
+
+} // namespace
+
+/// Interns strings into a config's pool while it is being built
+class GameConfig::Builder {
+public:
+	explicit Builder(GameConfig& config_)
+			: config(config_) {}
+
+	[[nodiscard]] StringID intern(const QString& str) {
+		if (str.isEmpty()) {
+			return 0;
+		}
+		if (const auto it = this->ids.constFind(str); it != this->ids.constEnd()) {
+			return *it;
+		}
+		const auto id = static_cast<StringID>(this->config.strings.size());
+		this->config.strings.push_back(str);
+		this->ids.insert(str, id);
+		return id;
+	}
+
+private:
+	GameConfig& config;
+	QHash<QString, StringID> ids;
+};
 
 GameConfig::ActionType GameConfig::actionTypeFromString(const QString& string) {
 	using enum ActionType;
@@ -38,143 +707,269 @@ GameConfig::OS GameConfig::osFromString(const QString& string) {
 	return static_cast<OS>(out);
 }
 
-std::optional<GameConfig> GameConfig::parse(const QString& path) {
-	QString config;
-	if (QFile file(path); file.open(QIODevice::ReadOnly)) {
-		QTextStream in(&file);
-		config += in.readAll();
-		file.close();
-	} else {
-		return std::nullopt;
+std::optional<GameConfig> GameConfig::parse(const QString& path, QList<Diagnostic>* diagnostics) {
+	// The default config is compiled into the executable
+	if (path == QStringView{BuiltinGameConfig::PATH}) {
+		return fromBuiltin();
 	}
 
-	const QJsonDocument configJson = QJsonDocument::fromJson(config.toUtf8());
-	if (!configJson.isObject()) {
-		return std::nullopt;
+	const auto configKey = ::getConfigKey(path);
+	QStringList stack;
+	QList<std::pair<QString, qint64>> dependencies;
+	const auto fragment = ::resolveFragment(configKey, stack, dependencies);
+	if (diagnostics) {
+		*diagnostics += fragment->diagnostics;
 	}
-	QJsonObject configObject = configJson.object();
-
-	GameConfig gameConfig;
-
-	if (!configObject.contains("game_default") || !configObject["game_default"].isString()) {
+	if (fragment->failed) {
 		return std::nullopt;
 	}
-	gameConfig.gameDefault = configObject["game_default"].toString();
-
-	if (configObject.contains("game_icon") && configObject["game_icon"].isString()) {
-		gameConfig.gameIcon = configObject["game_icon"].toString();
-	} else {
-		gameConfig.gameIcon = "${ROOT}/${GAME}/resource/game.ico";
-	}
-
-	if (configObject.contains("uses_legacy_bin_dir") && configObject["uses_legacy_bin_dir"].isBool()) {
-		gameConfig.usesLegacyBinDir = configObject["uses_legacy_bin_dir"].toBool();
-	}
 
-	if (configObject.contains("window_width")) {
-		gameConfig.windowWidth = configObject["window_width"].toInt(DEFAULT_WINDOW_WIDTH);
+	if (!fragment->gameDefault) {
+		::report(diagnostics, {1, 1}, "The config is missing \"game_default\"", configKey);
+		return std::nullopt;
 	}
-
-	if (configObject.contains("window_height")) {
-		gameConfig.windowHeight = configObject["window_height"].toInt(DEFAULT_WINDOW_HEIGHT);
+	if (!fragment->hasSections) {
+		::report(diagnostics, {1, 1}, "The config is missing \"sections\"", configKey);
+		return std::nullopt;
 	}
 
-	if (configObject.contains("mod_template_url")) {
-		if (configObject["mod_template_url"].isString()) {
-			gameConfig.modTemplateURL["Mod Template"] = configObject["mod_template_url"].toString();
-		} else if (configObject["mod_template_url"].isObject()) {
-			for (
-				const auto& modTemplateObject = configObject["mod_template_url"].toObject().toVariantMap();
-				const auto& [desc, url] : modTemplateObject.asKeyValueRange()
-			) {
-				gameConfig.modTemplateURL[desc] = url.toString();
-			}
+	GameConfig gameConfig;
+	gameConfig.gameDefault = *fragment->gameDefault;
+	gameConfig.gameIcon = fragment->gameIcon.value_or("${ROOT}/${GAME}/resource/game.ico");
+	gameConfig.usesLegacyBinDir = fragment->usesLegacyBinDir.value_or(false);
+	gameConfig.windowWidth = fragment->windowWidth.value_or(DEFAULT_WINDOW_WIDTH);
+	gameConfig.windowHeight = fragment->windowHeight.value_or(DEFAULT_WINDOW_HEIGHT);
+	gameConfig.modTemplates = fragment->modTemplates;
+	gameConfig.p2ceAddonsSupported = fragment->p2ceAddonsSupported.value_or(false);
+	gameConfig.prewarmFiles = fragment->prewarmFiles;
+	gameConfig.prewarmBudgetMB = fragment->prewarmBudgetMB.value_or(DEFAULT_PREWARM_BUDGET_MB);
+	// A config extended or included from several places is only listed once
+	for (const auto& dependency : dependencies) {
+		if (std::none_of(gameConfig.sourceFiles.begin(), gameConfig.sourceFiles.end(), [&dependency](const auto& file) { return file.first == dependency.first; })) {
+			gameConfig.sourceFiles.push_back(dependency);
 		}
 	}
+	const auto& sections = fragment->sections;
 
-	if (configObject.contains("supports_p2ce_addons") && configObject["supports_p2ce_addons"].isBool()) {
-		gameConfig.p2ceAddonsSupported = configObject["supports_p2ce_addons"].toBool();
-	}
-
-	if (!configObject.contains("sections") || !configObject["sections"].isArray()) {
-		return std::nullopt;
-	}
-
-	for (const auto& sectionValue : configObject["sections"].toArray()) {
-		if (!sectionValue.isObject()) {
+	Builder builder{gameConfig};
+	for (const auto& sectionFields : sections) {
+		if (sectionFields.remove) {
 			continue;
 		}
-
-		QJsonObject sectionObject = sectionValue.toObject();
-		if (!sectionObject.contains("name") || !sectionObject["name"].isString() || !sectionObject.contains("entries") || !sectionObject["entries"].isArray()) {
+		if (!sectionFields.name || !sectionFields.hasEntries) {
+			::report(diagnostics, sectionFields.location, QString("Skipping section, it is missing \"%1\"").arg(!sectionFields.name ? "name" : "entries"), sectionFields.file);
 			continue;
 		}
 
-		auto& gameConfigSection = gameConfig.sections.emplace_back();
-		gameConfigSection.name = sectionObject["name"].toString();
+		Section gameConfigSection;
+		gameConfigSection.name = builder.intern(*sectionFields.name);
+		gameConfigSection.entriesBegin = gameConfig.entries.size();
 
-		for (const auto& entryValue : sectionObject["entries"].toArray()) {
-			if (!entryValue.isObject()) {
+		for (const auto& entryFields : sectionFields.entries) {
+			if (entryFields.remove) {
 				continue;
 			}
-
-			QJsonObject entryObject = entryValue.toObject();
-			if (!entryObject.contains("name") || !entryObject["name"].isString() || !entryObject.contains("type") || !entryObject["type"].isString() || !entryObject.contains("action") || !entryObject["action"].isString()) {
+			if (!entryFields.name || !entryFields.type || !entryFields.action) {
+				::report(diagnostics, entryFields.location, QString("Skipping entry, it is missing \"%1\"").arg(!entryFields.name ? "name" : !entryFields.type ? "type" : "action"), entryFields.file);
 				continue;
 			}
 
-			auto& gameConfigSectionEntry = gameConfigSection.entries.emplace_back();
-			gameConfigSectionEntry.name = entryObject["name"].toString();
-			gameConfigSectionEntry.type = actionTypeFromString(entryObject["type"].toString());
-			gameConfigSectionEntry.action = entryObject["action"].toString();
-
-			if (entryObject.contains("arguments") && entryObject["arguments"].isArray()) {
-				for (const auto& argument : entryObject["arguments"].toArray()) {
-					if (!argument.isString()) {
-						continue;
-					}
-					gameConfigSectionEntry.arguments.push_back(argument.toString());
-				}
-			}
-
-			if (entryObject.contains("icon_override") && entryObject["icon_override"].isString()) {
-				gameConfigSectionEntry.iconOverride = entryObject["icon_override"].toString();
+			const auto type = actionTypeFromString(*entryFields.type);
+			if (type == ActionType::INVALID) {
+				::report(diagnostics, entryFields.location, QString("Unknown entry type \"%1\"").arg(*entryFields.type), entryFields.file);
 			}
 
-			const auto os = static_cast<unsigned char>((!entryObject.contains("os") || !entryObject["os"].isString()) ? OS::ALL : osFromString(entryObject["os"].toString()));
 #if defined(_WIN32)
-			if (!(os & static_cast<unsigned char>(OS::WINDOWS))) {
-				gameConfigSection.entries.pop_back();
+			if (!(entryFields.os & static_cast<unsigned char>(OS::WINDOWS))) {
+				continue;
 			}
 #elif defined(__linux__)
-			if (!(os & static_cast<unsigned char>(OS::LINUX))) {
-				gameConfigSection.entries.pop_back();
+			if (!(entryFields.os & static_cast<unsigned char>(OS::LINUX))) {
+				continue;
 			}
 #endif
+
+			Entry gameConfigSectionEntry;
+			gameConfigSectionEntry.name = builder.intern(*entryFields.name);
+			gameConfigSectionEntry.type = type;
+			gameConfigSectionEntry.action = builder.intern(*entryFields.action);
+
+			gameConfigSectionEntry.argumentsBegin = gameConfig.arguments.size();
+			for (const auto& argument : entryFields.arguments) {
+				gameConfig.arguments.push_back(builder.intern(argument));
+			}
+			gameConfigSectionEntry.argumentsCount = entryFields.arguments.size();
+
+			gameConfigSectionEntry.iconOverride = builder.intern(entryFields.iconOverride);
+			gameConfigSectionEntry.priority = entryFields.priority;
+
+			gameConfigSectionEntry.cpuAffinityBegin = gameConfig.cpuAffinities.size();
+			gameConfig.cpuAffinities += entryFields.cpuAffinity;
+			gameConfigSectionEntry.cpuAffinityCount = entryFields.cpuAffinity.size();
+
+			gameConfigSectionEntry.environmentBegin = gameConfig.environments.size();
+			for (const auto& [variable, value] : entryFields.environment) {
+				gameConfig.environments.emplace_back(builder.intern(variable), builder.intern(value));
+			}
+			gameConfigSectionEntry.environmentCount = entryFields.environment.size();
+
+			gameConfigSectionEntry.memoryLimitMB = entryFields.memoryLimitMB;
+			gameConfigSectionEntry.instances = entryFields.instances;
+			gameConfigSectionEntry.instanceStaggerMs = entryFields.instanceStaggerMs;
+			gameConfigSectionEntry.instanceSpreadCPUs = entryFields.instanceSpreadCPUs;
+			gameConfigSectionEntry.progressPattern = builder.intern(entryFields.progressPattern);
+			gameConfigSectionEntry.progressMax = entryFields.progressMax;
+			gameConfigSectionEntry.progressPhasePattern = builder.intern(entryFields.progressPhasePattern);
+
+			gameConfig.entries.push_back(gameConfigSectionEntry);
 		}
 
-		if (gameConfigSection.entries.empty()) {
-			gameConfig.sections.pop_back();
+		gameConfigSection.entriesCount = gameConfig.entries.size() - gameConfigSection.entriesBegin;
+		if (gameConfigSection.entriesCount > 0) {
+			gameConfig.sections.push_back(gameConfigSection);
 		}
 	}
 	return gameConfig;
 }
 
+GameConfig GameConfig::fromBuiltin() {
+	GameConfig gameConfig;
+	gameConfig.gameDefault = ::fromBuiltinString(BuiltinGameConfig::GAME_DEFAULT);
+	gameConfig.gameIcon = ::fromBuiltinString(BuiltinGameConfig::GAME_ICON);
+	gameConfig.usesLegacyBinDir = BuiltinGameConfig::USES_LEGACY_BIN_DIR;
+	gameConfig.windowWidth = BuiltinGameConfig::WINDOW_WIDTH;
+	gameConfig.windowHeight = BuiltinGameConfig::WINDOW_HEIGHT;
+	for (const auto& [desc, url, sha256] : BuiltinGameConfig::MOD_TEMPLATES) {
+		gameConfig.modTemplates[::fromBuiltinString(desc)] = {::fromBuiltinString(url), ::fromBuiltinString(sha256)};
+	}
+	gameConfig.p2ceAddonsSupported = BuiltinGameConfig::SUPPORTS_P2CE_ADDONS;
+	for (const auto prewarmFile : BuiltinGameConfig::PREWARM_FILES) {
+		gameConfig.prewarmFiles.push_back(::fromBuiltinString(prewarmFile));
+	}
+	gameConfig.prewarmBudgetMB = BuiltinGameConfig::PREWARM_BUDGET_MB;
+
+	// The generated tables already have the same layout as the pools, they only need their strings interned
+	Builder builder{gameConfig};
+	gameConfig.arguments.reserve(BuiltinGameConfig::ARGUMENTS.size());
+	for (const auto argument : BuiltinGameConfig::ARGUMENTS) {
+		gameConfig.arguments.push_back(builder.intern(::fromBuiltinString(argument)));
+	}
+	gameConfig.cpuAffinities.reserve(BuiltinGameConfig::CPU_AFFINITY.size());
+	for (const auto cpu : BuiltinGameConfig::CPU_AFFINITY) {
+		gameConfig.cpuAffinities.push_back(cpu);
+	}
+	gameConfig.environments.reserve(BuiltinGameConfig::ENVIRONMENT.size());
+	for (const auto& [key, value] : BuiltinGameConfig::ENVIRONMENT) {
+		gameConfig.environments.emplace_back(builder.intern(::fromBuiltinString(key)), builder.intern(::fromBuiltinString(value)));
+	}
+
+	gameConfig.entries.reserve(BuiltinGameConfig::ENTRIES.size());
+	for (const auto& builtinEntry : BuiltinGameConfig::ENTRIES) {
+		auto& gameConfigSectionEntry = gameConfig.entries.emplace_back();
+		gameConfigSectionEntry.name = builder.intern(::fromBuiltinString(builtinEntry.name));
+		gameConfigSectionEntry.type = builtinEntry.type;
+		gameConfigSectionEntry.action = builder.intern(::fromBuiltinString(builtinEntry.action));
+		gameConfigSectionEntry.argumentsBegin = builtinEntry.argumentsBegin;
+		gameConfigSectionEntry.argumentsCount = builtinEntry.argumentsCount;
+		gameConfigSectionEntry.iconOverride = builder.intern(::fromBuiltinString(builtinEntry.iconOverride));
+		gameConfigSectionEntry.priority = builtinEntry.priority;
+		gameConfigSectionEntry.cpuAffinityBegin = builtinEntry.cpuAffinityBegin;
+		gameConfigSectionEntry.cpuAffinityCount = builtinEntry.cpuAffinityCount;
+		gameConfigSectionEntry.environmentBegin = builtinEntry.environmentBegin;
+		gameConfigSectionEntry.environmentCount = builtinEntry.environmentCount;
+		gameConfigSectionEntry.memoryLimitMB = builtinEntry.memoryLimitMB;
+		gameConfigSectionEntry.instances = builtinEntry.instances;
+		gameConfigSectionEntry.instanceStaggerMs = builtinEntry.instanceStaggerMs;
+		gameConfigSectionEntry.instanceSpreadCPUs = builtinEntry.instanceSpreadCPUs;
+		gameConfigSectionEntry.progressPattern = builder.intern(::fromBuiltinString(builtinEntry.progressPattern));
+		gameConfigSectionEntry.progressMax = builtinEntry.progressMax;
+		gameConfigSectionEntry.progressPhasePattern = builder.intern(::fromBuiltinString(builtinEntry.progressPhasePattern));
+	}
+
+	gameConfig.sections.reserve(BuiltinGameConfig::SECTIONS.size());
+	for (const auto& builtinSection : BuiltinGameConfig::SECTIONS) {
+		gameConfig.sections.push_back({
+			.name = builder.intern(::fromBuiltinString(builtinSection.name)),
+			.entriesBegin = static_cast<quint32>(builtinSection.entriesBegin),
+			.entriesCount = static_cast<quint32>(builtinSection.entriesCount),
+		});
+	}
+	return gameConfig;
+}
+
+QStringList GameConfig::getArguments(const Entry& entry) const {
+	QStringList out;
+	out.reserve(entry.argumentsCount);
+	for (quint32 i = entry.argumentsBegin; i < entry.argumentsBegin + entry.argumentsCount; i++) {
+		out.push_back(this->strings[this->arguments[i]]);
+	}
+	return out;
+}
+
+GameConfig::Command GameConfig::getCommand(const Entry& entry) const {
+	Command command;
+	command.action = this->strings[entry.action];
+	command.arguments = this->getArguments(entry);
+	command.priority = entry.priority;
+	for (quint32 i = entry.cpuAffinityBegin; i < entry.cpuAffinityBegin + entry.cpuAffinityCount; i++) {
+		command.cpuAffinity.push_back(this->cpuAffinities[i]);
+	}
+	for (quint32 i = entry.environmentBegin; i < entry.environmentBegin + entry.environmentCount; i++) {
+		const auto& [key, value] = this->environments[i];
+		command.environment[this->strings[key]] = this->strings[value];
+	}
+	command.memoryLimitMB = entry.memoryLimitMB;
+	command.instances = entry.instances;
+	command.instanceStaggerMs = entry.instanceStaggerMs;
+	command.instanceSpreadCPUs = entry.instanceSpreadCPUs;
+	command.progressPattern = this->strings[entry.progressPattern];
+	command.progressMax = entry.progressMax;
+	command.progressPhasePattern = this->strings[entry.progressPhasePattern];
+	return command;
+}
+
+bool GameConfig::Command::usesPort() const {
+	return std::any_of(this->arguments.begin(), this->arguments.end(), [](const QString& argument) { return argument.contains("${PORT}"); })
+		|| std::any_of(this->environment.begin(), this->environment.end(), [](const QString& value) { return value.contains("${PORT}"); });
+}
+
+GameConfig::Command GameConfig::Command::forInstance(int instance, int port) const {
+	Command out = *this;
+	const auto setVars = [instanceStr = QString::number(instance), instanceCountStr = QString::number(this->instances), portStr = QString::number(port)](QString& str) {
+		str.replace("${INSTANCE}", instanceStr);
+		str.replace("${INSTANCE_COUNT}", instanceCountStr);
+		str.replace("${PORT}", portStr);
+	};
+	for (auto& argument : out.arguments) {
+		setVars(argument);
+	}
+	for (auto& value : out.environment) {
+		setVars(value);
+	}
+
+	// Each instance gets its own contiguous slice of the allowed cores, wrapping around if there are more instances
+	if (this->instanceSpreadCPUs) {
+		const QList<int> cpus = this->cpuAffinity.isEmpty() ? ::getAllowedCPUs() : this->cpuAffinity;
+		const qsizetype cpusPerInstance = std::max<qsizetype>(cpus.size() / this->instances, 1);
+		out.cpuAffinity.clear();
+		for (qsizetype i = 0; i < cpusPerInstance; i++) {
+			out.cpuAffinity.push_back(cpus[(instance * cpusPerInstance + i) % cpus.size()]);
+		}
+	}
+	return out;
+}
+
 void GameConfig::setVariable(const QString& variable, const QString& replacement) {
-	const auto setVar = [&variable, &replacement](QString& str) {
-		str.replace(QString("${%1}").arg(variable), replacement);
+	const auto setVar = [needle = QString("${%1}").arg(variable), &replacement](QString& str) {
+		str.replace(needle, replacement);
 	};
 	setVar(this->gameDefault);
 	setVar(this->gameIcon);
-	for (auto& [sectionName, entries] : this->sections) {
-		setVar(sectionName);
-		for (auto& entry : entries) {
-			setVar(entry.name);
-			setVar(entry.action);
-			for (auto& argument : entry.arguments) {
-				setVar(argument);
-			}
-			setVar(entry.iconOverride);
-		}
+	for (auto& prewarmFile : this->prewarmFiles) {
+		setVar(prewarmFile);
+	}
+	// Every unique string in the sections is only visited once
+	for (auto& str : this->strings) {
+		setVar(str);
 	}
 }
@@ -1,12 +1,19 @@
 #pragma once
 
 #include <optional>
+#include <span>
+#include <utility>
+
 #include <QList>
 #include <QMap>
 #include <QString>
 
 constexpr int DEFAULT_WINDOW_WIDTH = 256;
 constexpr int DEFAULT_WINDOW_HEIGHT = 300;
+constexpr int DEFAULT_PREWARM_BUDGET_MB = 1024;
+constexpr int MAX_INSTANCES = 64;
+constexpr int DEFAULT_INSTANCE_STAGGER_MS = 500;
+constexpr int DEFAULT_PROGRESS_MAX = 100;
 
 class GameConfig {
 public:
@@ -29,20 +36,80 @@ public:
 
 	[[nodiscard]] static OS osFromString(const QString& string);
 
+	/// Index into the config's string pool. Strings are deduplicated, and 0 is always the empty string.
+	using StringID = quint32;
+
+	/// Strings and lists are stored in pools owned by the config, entries only hold indices into them
 	struct Entry {
-		QString name;
-		ActionType type;
+		StringID name = 0;
+		ActionType type = ActionType::INVALID;
+		StringID action = 0;
+		quint32 argumentsBegin = 0;
+		quint32 argumentsCount = 0;
+		StringID iconOverride = 0;
+		int priority = 0;
+		quint32 cpuAffinityBegin = 0;
+		quint32 cpuAffinityCount = 0;
+		quint32 environmentBegin = 0;
+		quint32 environmentCount = 0;
+		int memoryLimitMB = 0;
+		int instances = 1;
+		int instanceStaggerMs = DEFAULT_INSTANCE_STAGGER_MS;
+		bool instanceSpreadCPUs = false;
+		StringID progressPattern = 0;
+		int progressMax = DEFAULT_PROGRESS_MAX;
+		StringID progressPhasePattern = 0;
+	};
+
+	/// Everything needed to start a command entry, resolved out of the config's pools
+	struct Command {
 		QString action;
 		QStringList arguments;
-		QString iconOverride;
+		int priority = 0;
+		QList<int> cpuAffinity;
+		QMap<QString, QString> environment;
+		int memoryLimitMB = 0;
+		int instances = 1;
+		int instanceStaggerMs = DEFAULT_INSTANCE_STAGGER_MS;
+		bool instanceSpreadCPUs = false;
+		/// Regex matched against the command's output to show its progress, see ProgressParser
+		QString progressPattern;
+		int progressMax = DEFAULT_PROGRESS_MAX;
+		QString progressPhasePattern;
+
+		/// True if the arguments or environment ask for ${PORT}, so a free port needs to be found for each instance
+		[[nodiscard]] bool usesPort() const;
+
+		/// Substitutes ${INSTANCE}, ${INSTANCE_COUNT} and ${PORT}, and picks this instance's share of the CPU cores
+		/// if instances are spread across them
+		[[nodiscard]] Command forInstance(int instance, int port) const;
 	};
 
+	struct ModTemplate {
+		QString url;
+		QString sha256;
+	};
+
+	/// Sections are contiguous ranges of entries
 	struct Section {
-		QString name;
-		QList<Entry> entries;
+		StringID name = 0;
+		quint32 entriesBegin = 0;
+		quint32 entriesCount = 0;
+	};
+
+	/// A problem found while parsing, line and column are 0 if it isn't tied to a location in the file
+	struct Diagnostic {
+		int line;
+		int column;
+		QString message;
+		/// Absolute path of the file the problem is in, which may be a config this one extends or includes
+		QString file;
 	};
 
-	[[nodiscard]] static std::optional<GameConfig> parse(const QString& path);
+	/// Invalid sections and entries are skipped with a diagnostic, syntax errors fail the whole config.
+	/// Configs can extend other configs and include their sections, every file involved is cached by path and
+	/// modification time so reloading a stack of configs only reparses the files that changed.
+	[[nodiscard]] static std::optional<GameConfig> parse(const QString& path, QList<Diagnostic>* diagnostics = nullptr);
 
 	[[nodiscard]] const QString& getGameDefault() const { return this->gameDefault; }
 
@@ -54,12 +121,27 @@ public:
 
 	[[nodiscard]] int getWindowHeight() const { return this->windowHeight; }
 
-	[[nodiscard]] const QMap<QString, QString>& getModTemplateURL() const { return this->modTemplateURL; }
+	[[nodiscard]] const QMap<QString, ModTemplate>& getModTemplates() const { return this->modTemplates; }
 
 	[[nodiscard]] bool supportsP2CEAddons() const { return this->p2ceAddonsSupported; }
 
+	[[nodiscard]] const QStringList& getPrewarmFiles() const { return this->prewarmFiles; }
+
+	[[nodiscard]] int getPrewarmBudgetMB() const { return this->prewarmBudgetMB; }
+
+	/// Every file the config was built from and its modification time when it was read, empty for the builtin config
+	[[nodiscard]] const QList<std::pair<QString, qint64>>& getSourceFiles() const { return this->sourceFiles; }
+
 	[[nodiscard]] const QList<Section>& getSections() const { return this->sections; }
 
+	[[nodiscard]] std::span<const Entry> getEntries(const Section& section) const { return {this->entries.constData() + section.entriesBegin, section.entriesCount}; }
+
+	[[nodiscard]] const QString& getString(StringID id) const { return this->strings[id]; }
+
+	[[nodiscard]] QStringList getArguments(const Entry& entry) const;
+
+	[[nodiscard]] Command getCommand(const Entry& entry) const;
+
 	void setVariable(const QString& variable, const QString& replacement);
 
 private:
@@ -68,9 +150,21 @@ private:
 	bool usesLegacyBinDir = false;
 	int windowWidth = DEFAULT_WINDOW_WIDTH;
 	int windowHeight = DEFAULT_WINDOW_HEIGHT;
-	QMap<QString, QString> modTemplateURL;
+	QMap<QString, ModTemplate> modTemplates;
 	bool p2ceAddonsSupported = false;
+	QStringList prewarmFiles;
+	int prewarmBudgetMB = DEFAULT_PREWARM_BUDGET_MB;
+	QList<std::pair<QString, qint64>> sourceFiles;
+	QStringList strings{QString{}};
+	QList<StringID> arguments;
+	QList<int> cpuAffinities;
+	QList<std::pair<StringID, StringID>> environments;
+	QList<Entry> entries;
 	QList<Section> sections;
 
+	class Builder;
+
 	GameConfig() = default;
+
+	[[nodiscard]] static GameConfig fromBuiltin();
 };
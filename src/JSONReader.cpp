@@ -0,0 +1,425 @@
+#include "JSONReader.h"
+
+#include <charconv>
+#include <system_error>
+
+namespace {
+
+[[nodiscard]] constexpr bool isDigit(char c) {
+	return c >= '0' && c <= '9';
+}
+
+void appendUTF8(QByteArray& out, char32_t codepoint) {
+	if (codepoint < 0x80) {
+		out.append(static_cast<char>(codepoint));
+	} else if (codepoint < 0x800) {
+		out.append(static_cast<char>(0xc0 | (codepoint >> 6)));
+		out.append(static_cast<char>(0x80 | (codepoint & 0x3f)));
+	} else if (codepoint < 0x10000) {
+		out.append(static_cast<char>(0xe0 | (codepoint >> 12)));
+		out.append(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3f)));
+		out.append(static_cast<char>(0x80 | (codepoint & 0x3f)));
+	} else {
+		out.append(static_cast<char>(0xf0 | (codepoint >> 18)));
+		out.append(static_cast<char>(0x80 | ((codepoint >> 12) & 0x3f)));
+		out.append(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3f)));
+		out.append(static_cast<char>(0x80 | (codepoint & 0x3f)));
+	}
+}
+
+} // namespace
+
+JSONReader::JSONReader(QByteArrayView data_)
+		: data(data_) {
+	// Skip the byte order mark if there is one
+	if (this->data.startsWith("\xef\xbb\xbf")) {
+		this->pos = 3;
+		this->lineStart = 3;
+	}
+}
+
+JSONReader::Type JSONReader::peek() {
+	if (this->hasError()) {
+		return Type::INVALID;
+	}
+	this->skipWhitespace();
+	if (this->pos >= this->data.size()) {
+		return Type::INVALID;
+	}
+	switch (this->data[this->pos]) {
+		case '{':
+			return Type::OBJECT;
+		case '[':
+			return Type::ARRAY;
+		case '"':
+			return Type::STRING;
+		case 't':
+		case 'f':
+			return Type::BOOL;
+		case 'n':
+			return Type::NUL;
+		case '-':
+			return Type::NUMBER;
+		default:
+			return ::isDigit(this->data[this->pos]) ? Type::NUMBER : Type::INVALID;
+	}
+}
+
+bool JSONReader::beginObject() {
+	if (this->hasError() || !this->expect('{', "'{'")) {
+		return false;
+	}
+	if (this->first.size() >= MAX_DEPTH) {
+		return this->fail("Nesting is too deep");
+	}
+	this->first.push_back(true);
+	return true;
+}
+
+bool JSONReader::nextKey(QString& key) {
+	if (!this->nextItem('}')) {
+		return false;
+	}
+	this->skipWhitespace();
+	if (this->pos >= this->data.size() || this->data[this->pos] != '"') {
+		return this->fail("Expected a key");
+	}
+	return this->parseString(&key) && this->expect(':', "':'");
+}
+
+bool JSONReader::beginArray() {
+	if (this->hasError() || !this->expect('[', "'['")) {
+		return false;
+	}
+	if (this->first.size() >= MAX_DEPTH) {
+		return this->fail("Nesting is too deep");
+	}
+	this->first.push_back(true);
+	return true;
+}
+
+bool JSONReader::nextElement() {
+	return this->nextItem(']');
+}
+
+bool JSONReader::readString(QString& out) {
+	if (this->peek() != Type::STRING) {
+		return this->fail("Expected a string");
+	}
+	return this->parseString(&out);
+}
+
+bool JSONReader::readNumber(double& out) {
+	if (this->peek() != Type::NUMBER) {
+		return this->fail("Expected a number");
+	}
+	return this->parseNumber(&out);
+}
+
+bool JSONReader::readBool(bool& out) {
+	if (this->peek() != Type::BOOL) {
+		return this->fail("Expected a boolean");
+	}
+	if (this->data[this->pos] == 't') {
+		out = true;
+		return this->parseLiteral("true");
+	}
+	out = false;
+	return this->parseLiteral("false");
+}
+
+bool JSONReader::skipValue() {
+	switch (this->peek()) {
+		case Type::OBJECT: {
+			if (!this->beginObject()) {
+				return false;
+			}
+			QString key;
+			while (this->nextKey(key)) {
+				if (!this->skipValue()) {
+					return false;
+				}
+			}
+			return !this->hasError();
+		}
+		case Type::ARRAY:
+			if (!this->beginArray()) {
+				return false;
+			}
+			while (this->nextElement()) {
+				if (!this->skipValue()) {
+					return false;
+				}
+			}
+			return !this->hasError();
+		case Type::STRING:
+			return this->parseString(nullptr);
+		case Type::NUMBER:
+			return this->parseNumber(nullptr);
+		case Type::BOOL:
+			return this->parseLiteral(this->data[this->pos] == 't' ? "true" : "false");
+		case Type::NUL:
+			return this->parseLiteral("null");
+		case Type::INVALID:
+			break;
+	}
+	return this->fail(this->pos >= this->data.size() ? "Unexpected end of file" : "Expected a value");
+}
+
+bool JSONReader::finish() {
+	if (this->hasError()) {
+		return false;
+	}
+	this->skipWhitespace();
+	if (this->pos < this->data.size()) {
+		return this->fail("Unexpected data after the end of the document");
+	}
+	return true;
+}
+
+JSONReader::Location JSONReader::getLocation() {
+	if (!this->hasError()) {
+		this->skipWhitespace();
+	}
+	int column = 1;
+	for (qsizetype i = this->lineStart; i < this->pos && i < this->data.size(); i++) {
+		// Don't count UTF-8 continuation bytes
+		if ((static_cast<unsigned char>(this->data[i]) & 0xc0) != 0x80) {
+			column++;
+		}
+	}
+	return {this->line, column};
+}
+
+void JSONReader::skipWhitespace() {
+	while (this->pos < this->data.size()) {
+		switch (this->data[this->pos]) {
+			case '\n':
+				this->line++;
+				this->lineStart = this->pos + 1;
+				[[fallthrough]];
+			case ' ':
+			case '\t':
+			case '\r':
+				this->pos++;
+				break;
+			default:
+				return;
+		}
+	}
+}
+
+bool JSONReader::fail(const QString& message) {
+	if (!this->hasError()) {
+		this->errorLocation = this->getLocation();
+		this->error = message;
+	}
+	return false;
+}
+
+bool JSONReader::expect(char c, const char* what) {
+	this->skipWhitespace();
+	if (this->pos >= this->data.size() || this->data[this->pos] != c) {
+		return this->fail(QString("Expected %1").arg(what));
+	}
+	this->pos++;
+	return true;
+}
+
+bool JSONReader::parseString(QString* out) {
+	// Opening quote
+	this->pos++;
+	const auto start = this->pos;
+
+	// Most strings have no escapes and can be decoded straight out of the input
+	while (this->pos < this->data.size()) {
+		const auto c = static_cast<unsigned char>(this->data[this->pos]);
+		if (c == '"') {
+			if (out) {
+				*out = QString::fromUtf8(this->data.sliced(start, this->pos - start));
+			}
+			this->pos++;
+			return true;
+		}
+		if (c == '\\') {
+			break;
+		}
+		if (c < 0x20) {
+			return this->fail("Control character in string");
+		}
+		this->pos++;
+	}
+
+	QByteArray buffer;
+	if (out) {
+		buffer.append(this->data.sliced(start, this->pos - start));
+	}
+	while (this->pos < this->data.size()) {
+		const auto c = static_cast<unsigned char>(this->data[this->pos]);
+		if (c == '"') {
+			if (out) {
+				*out = QString::fromUtf8(buffer);
+			}
+			this->pos++;
+			return true;
+		}
+		if (c < 0x20) {
+			return this->fail("Control character in string");
+		}
+		if (c != '\\') {
+			if (out) {
+				buffer.append(static_cast<char>(c));
+			}
+			this->pos++;
+			continue;
+		}
+
+		if (++this->pos >= this->data.size()) {
+			break;
+		}
+		char unescaped;
+		switch (this->data[this->pos++]) {
+			case '"':  unescaped = '"';  break;
+			case '\\': unescaped = '\\'; break;
+			case '/':  unescaped = '/';  break;
+			case 'b':  unescaped = '\b'; break;
+			case 'f':  unescaped = '\f'; break;
+			case 'n':  unescaped = '\n'; break;
+			case 'r':  unescaped = '\r'; break;
+			case 't':  unescaped = '\t'; break;
+			case 'u': {
+				char32_t codepoint;
+				if (!this->parseHex4(codepoint)) {
+					return false;
+				}
+				if (codepoint >= 0xd800 && codepoint <= 0xdbff) {
+					// High surrogate, has to be followed by an escaped low surrogate
+					char32_t low;
+					if (!this->data.sliced(this->pos).startsWith("\\u")) {
+						return this->fail("Unpaired surrogate in string");
+					}
+					this->pos += 2;
+					if (!this->parseHex4(low)) {
+						return false;
+					}
+					if (low < 0xdc00 || low > 0xdfff) {
+						return this->fail("Unpaired surrogate in string");
+					}
+					codepoint = 0x10000 + ((codepoint - 0xd800) << 10) + (low - 0xdc00);
+				} else if (codepoint >= 0xdc00 && codepoint <= 0xdfff) {
+					return this->fail("Unpaired surrogate in string");
+				}
+				if (out) {
+					::appendUTF8(buffer, codepoint);
+				}
+				continue;
+			}
+			default:
+				this->pos--;
+				return this->fail("Invalid escape sequence in string");
+		}
+		if (out) {
+			buffer.append(unescaped);
+		}
+	}
+	return this->fail("Unterminated string");
+}
+
+bool JSONReader::parseHex4(char32_t& out) {
+	if (this->pos + 4 > this->data.size()) {
+		return this->fail("Invalid unicode escape in string");
+	}
+	out = 0;
+	for (int i = 0; i < 4; i++) {
+		const char c = this->data[this->pos + i];
+		out <<= 4;
+		if (::isDigit(c)) {
+			out |= c - '0';
+		} else if (c >= 'a' && c <= 'f') {
+			out |= c - 'a' + 10;
+		} else if (c >= 'A' && c <= 'F') {
+			out |= c - 'A' + 10;
+		} else {
+			return this->fail("Invalid unicode escape in string");
+		}
+	}
+	this->pos += 4;
+	return true;
+}
+
+bool JSONReader::parseNumber(double* out) {
+	const auto start = this->pos;
+	const auto size = this->data.size();
+	const auto digits = [this, size] {
+		const auto digitsStart = this->pos;
+		while (this->pos < size && ::isDigit(this->data[this->pos])) {
+			this->pos++;
+		}
+		return this->pos > digitsStart;
+	};
+
+	if (this->data[this->pos] == '-') {
+		this->pos++;
+	}
+	if (this->pos < size && this->data[this->pos] == '0') {
+		this->pos++;
+	} else if (!digits()) {
+		return this->fail("Invalid number");
+	}
+	if (this->pos < size && this->data[this->pos] == '.') {
+		this->pos++;
+		if (!digits()) {
+			return this->fail("Invalid number");
+		}
+	}
+	if (this->pos < size && (this->data[this->pos] == 'e' || this->data[this->pos] == 'E')) {
+		this->pos++;
+		if (this->pos < size && (this->data[this->pos] == '+' || this->data[this->pos] == '-')) {
+			this->pos++;
+		}
+		if (!digits()) {
+			return this->fail("Invalid number");
+		}
+	}
+
+	if (out) {
+		const char* first = this->data.data() + start;
+		const char* last = this->data.data() + this->pos;
+		const auto result = std::from_chars(first, last, *out);
+		if (result.ec == std::errc::result_out_of_range) {
+			return this->fail("Number out of range");
+		}
+		if (result.ec != std::errc{} || result.ptr != last) {
+			return this->fail("Invalid number");
+		}
+	}
+	return true;
+}
+
+bool JSONReader::parseLiteral(QByteArrayView literal) {
+	if (!this->data.sliced(this->pos).startsWith(literal)) {
+		return this->fail("Expected a value");
+	}
+	this->pos += literal.size();
+	return true;
+}
+
+bool JSONReader::nextItem(char close) {
+	if (this->hasError() || this->first.isEmpty()) {
+		return false;
+	}
+	this->skipWhitespace();
+	if (this->pos >= this->data.size()) {
+		return this->fail("Unexpected end of file");
+	}
+	if (this->data[this->pos] == close) {
+		this->pos++;
+		this->first.pop_back();
+		return false;
+	}
+	if (this->first.back()) {
+		this->first.back() = false;
+		return true;
+	}
+	return this->expect(',', close == '}' ? "',' or '}'" : "',' or ']'");
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <QByteArrayView>
+#include <QString>
+#include <QVarLengthArray>
+
+/// A single-pass pull parser over UTF-8 JSON. Values are consumed in document order and never stored in a DOM.
+/// Once any method fails with a syntax error every later call fails too, check hasError() to tell a syntax
+/// error apart from nextKey() or nextElement() reaching the end of their container.
+class JSONReader {
+public:
+	enum class Type {
+		OBJECT,
+		ARRAY,
+		STRING,
+		NUMBER,
+		BOOL,
+		NUL,
+		INVALID,
+	};
+
+	struct Location {
+		int line = 1;
+		int column = 1;
+	};
+
+	explicit JSONReader(QByteArrayView data_);
+
+	/// Type of the next value, without consuming it
+	[[nodiscard]] Type peek();
+
+	[[nodiscard]] bool beginObject();
+
+	/// Reads the next key of the current object, returns false once the closing brace has been consumed
+	[[nodiscard]] bool nextKey(QString& key);
+
+	[[nodiscard]] bool beginArray();
+
+	/// Returns true if the current array has another element, false once the closing bracket has been consumed
+	[[nodiscard]] bool nextElement();
+
+	[[nodiscard]] bool readString(QString& out);
+
+	[[nodiscard]] bool readNumber(double& out);
+
+	[[nodiscard]] bool readBool(bool& out);
+
+	/// Consumes the next value whatever its type is
+	[[nodiscard]] bool skipValue();
+
+	/// Checks nothing but whitespace is left after the root value
+	[[nodiscard]] bool finish();
+
+	[[nodiscard]] bool hasError() const { return !this->error.isEmpty(); }
+
+	[[nodiscard]] const QString& getError() const { return this->error; }
+
+	[[nodiscard]] Location getErrorLocation() const { return this->errorLocation; }
+
+	/// Location of the next token, columns are counted in characters rather than bytes
+	[[nodiscard]] Location getLocation();
+
+private:
+	static constexpr int MAX_DEPTH = 256;
+
+	QByteArrayView data;
+	qsizetype pos = 0;
+	int line = 1;
+	qsizetype lineStart = 0;
+	// Whether the container at each nesting level has not read an item yet
+	QVarLengthArray<bool, 16> first;
+	QString error;
+	Location errorLocation;
+
+	void skipWhitespace();
+
+	[[nodiscard]] bool fail(const QString& message);
+
+	[[nodiscard]] bool expect(char c, const char* what);
+
+	[[nodiscard]] bool parseString(QString* out);
+
+	[[nodiscard]] bool parseHex4(char32_t& out);
+
+	[[nodiscard]] bool parseNumber(double* out);
+
+	[[nodiscard]] bool parseLiteral(QByteArrayView literal);
+
+	[[nodiscard]] bool nextItem(char close);
+};
@@ -0,0 +1,302 @@
+#include "KV3.h"
+
+#include <charconv>
+#include <cmath>
+#include <system_error>
+
+namespace {
+
+[[nodiscard]] constexpr bool isIdentifierChar(char c) {
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '.';
+}
+
+class Parser {
+public:
+	explicit Parser(QByteArrayView data_)
+			: data(data_) {}
+
+	[[nodiscard]] bool parseRoot(KV3::Value& out) {
+		if (this->data.startsWith("\xef\xbb\xbf")) {
+			this->pos = 3;
+		}
+		this->skipWhitespace();
+		if (this->data.sliced(this->pos).startsWith("<!--")) {
+			const auto end = this->data.indexOf("-->", this->pos);
+			if (end < 0) {
+				return this->fail("Unterminated header");
+			}
+			this->pos = end + 3;
+		}
+		if (!this->parseValue(out, 0)) {
+			return false;
+		}
+		this->skipWhitespace();
+		if (this->pos < this->data.size()) {
+			return this->fail("Unexpected data after the root value");
+		}
+		return true;
+	}
+
+	[[nodiscard]] QString getError() const {
+		int line = 1;
+		for (qsizetype i = 0; i < this->errorPos && i < this->data.size(); i++) {
+			if (this->data[i] == '\n') {
+				line++;
+			}
+		}
+		return QString("Line %1: %2").arg(line).arg(this->error);
+	}
+
+private:
+	static constexpr int MAX_DEPTH = 256;
+
+	QByteArrayView data;
+	qsizetype pos = 0;
+	QString error;
+	qsizetype errorPos = 0;
+
+	[[nodiscard]] bool fail(const QString& message) {
+		this->error = message;
+		this->errorPos = this->pos;
+		return false;
+	}
+
+	[[nodiscard]] bool atEnd() const {
+		return this->pos >= this->data.size();
+	}
+
+	void skipWhitespace() {
+		while (!this->atEnd()) {
+			const char c = this->data[this->pos];
+			if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+				this->pos++;
+			} else if (c == '/' && this->pos + 1 < this->data.size() && this->data[this->pos + 1] == '/') {
+				while (!this->atEnd() && this->data[this->pos] != '\n') {
+					this->pos++;
+				}
+			} else if (c == '/' && this->pos + 1 < this->data.size() && this->data[this->pos + 1] == '*') {
+				const auto end = this->data.indexOf("*/", this->pos + 2);
+				this->pos = end < 0 ? this->data.size() : end + 2;
+			} else {
+				return;
+			}
+		}
+	}
+
+	[[nodiscard]] QByteArrayView parseIdentifier() {
+		const auto start = this->pos;
+		while (!this->atEnd() && ::isIdentifierChar(this->data[this->pos])) {
+			this->pos++;
+		}
+		return this->data.sliced(start, this->pos - start);
+	}
+
+	[[nodiscard]] bool parseString(QString& out) {
+		// Multiline strings have no escapes, and drop the newlines right after and before the quotes
+		if (this->data.sliced(this->pos).startsWith(R"(""")")) {
+			this->pos += 3;
+			const auto end = this->data.indexOf(R"(""")", this->pos);
+			if (end < 0) {
+				return this->fail("Unterminated multiline string");
+			}
+			auto contents = this->data.sliced(this->pos, end - this->pos);
+			if (contents.startsWith("\r\n")) {
+				contents = contents.sliced(2);
+			} else if (contents.startsWith('\n')) {
+				contents = contents.sliced(1);
+			}
+			if (contents.endsWith("\r\n")) {
+				contents.chop(2);
+			} else if (contents.endsWith('\n')) {
+				contents.chop(1);
+			}
+			out = QString::fromUtf8(contents);
+			this->pos = end + 3;
+			return true;
+		}
+
+		this->pos++;
+		QByteArray buffer;
+		while (!this->atEnd()) {
+			const char c = this->data[this->pos++];
+			if (c == '"') {
+				out = QString::fromUtf8(buffer);
+				return true;
+			}
+			if (c != '\\' || this->atEnd()) {
+				buffer.append(c);
+				continue;
+			}
+			switch (const char escaped = this->data[this->pos++]) {
+				case 'n': buffer.append('\n'); break;
+				case 't': buffer.append('\t'); break;
+				case 'r': buffer.append('\r'); break;
+				default:  buffer.append(escaped); break;
+			}
+		}
+		return this->fail("Unterminated string");
+	}
+
+	[[nodiscard]] bool parseNumber(KV3::Value& out) {
+		const auto start = this->pos;
+		if (this->data[this->pos] == '-' || this->data[this->pos] == '+') {
+			this->pos++;
+		}
+		while (!this->atEnd() && (::isIdentifierChar(this->data[this->pos]) || this->data[this->pos] == '-' || this->data[this->pos] == '+')) {
+			this->pos++;
+		}
+		const char* first = this->data.data() + start + (this->data[start] == '+' ? 1 : 0);
+		const char* last = this->data.data() + this->pos;
+		if (const auto result = std::from_chars(first, last, out.number); result.ec != std::errc{} || result.ptr != last) {
+			this->pos = start;
+			return this->fail("Invalid number");
+		}
+		out.type = KV3::Value::Type::NUMBER;
+		return true;
+	}
+
+	[[nodiscard]] bool parseValue(KV3::Value& out, int depth) {
+		if (depth > MAX_DEPTH) {
+			return this->fail("Nesting is too deep");
+		}
+		this->skipWhitespace();
+		if (this->atEnd()) {
+			return this->fail("Expected a value");
+		}
+
+		const char c = this->data[this->pos];
+		if (c == '{') {
+			this->pos++;
+			out.type = KV3::Value::Type::OBJECT;
+			while (true) {
+				this->skipWhitespace();
+				if (this->atEnd()) {
+					return this->fail("Unterminated object");
+				}
+				if (this->data[this->pos] == '}') {
+					this->pos++;
+					return true;
+				}
+				// Commas between members are not required, but tolerate them
+				if (this->data[this->pos] == ',') {
+					this->pos++;
+					continue;
+				}
+				QString key;
+				if (this->data[this->pos] == '"') {
+					if (!this->parseString(key)) {
+						return false;
+					}
+				} else if (const auto identifier = this->parseIdentifier(); !identifier.isEmpty()) {
+					key = QString::fromUtf8(identifier);
+				} else {
+					return this->fail("Expected a key");
+				}
+				this->skipWhitespace();
+				if (this->atEnd() || this->data[this->pos] != '=') {
+					return this->fail("Expected '='");
+				}
+				this->pos++;
+				if (!this->parseValue(out.object.emplace_back(std::move(key), KV3::Value{}).second, depth + 1)) {
+					return false;
+				}
+			}
+		}
+		if (c == '[') {
+			this->pos++;
+			out.type = KV3::Value::Type::ARRAY;
+			while (true) {
+				this->skipWhitespace();
+				if (this->atEnd()) {
+					return this->fail("Unterminated array");
+				}
+				if (this->data[this->pos] == ']') {
+					this->pos++;
+					return true;
+				}
+				if (!this->parseValue(out.array.emplace_back(), depth + 1)) {
+					return false;
+				}
+				this->skipWhitespace();
+				if (!this->atEnd() && this->data[this->pos] == ',') {
+					this->pos++;
+				} else if (!this->atEnd() && this->data[this->pos] != ']') {
+					return this->fail("Expected ',' or ']'");
+				}
+			}
+		}
+		if (c == '"') {
+			out.type = KV3::Value::Type::STRING;
+			return this->parseString(out.string);
+		}
+		if (c == '#' && this->data.sliced(this->pos).startsWith("#[")) {
+			// Binary blob, nothing here needs the bytes
+			const auto end = this->data.indexOf(']', this->pos);
+			if (end < 0) {
+				return this->fail("Unterminated binary blob");
+			}
+			this->pos = end + 1;
+			out.type = KV3::Value::Type::NUL;
+			return true;
+		}
+		if (c == '-' || c == '+' || (c >= '0' && c <= '9')) {
+			return this->parseNumber(out);
+		}
+
+		const auto identifierStart = this->pos;
+		const auto identifier = this->parseIdentifier();
+		if (identifier == "true" || identifier == "false") {
+			out.type = KV3::Value::Type::BOOL;
+			out.boolean = identifier == "true";
+			return true;
+		}
+		if (identifier == "null") {
+			out.type = KV3::Value::Type::NUL;
+			return true;
+		}
+		if (!identifier.isEmpty() && !this->atEnd() && this->data[this->pos] == ':') {
+			// Flagged value, e.g. resource:"materials/foo.vmat"
+			this->pos++;
+			return this->parseValue(out, depth + 1);
+		}
+		this->pos = identifierStart;
+		return this->fail("Expected a value");
+	}
+};
+
+} // namespace
+
+const KV3::Value* KV3::Value::find(QStringView key) const {
+	for (const auto& [memberKey, value] : this->object) {
+		if (memberKey == key) {
+			return &value;
+		}
+	}
+	return nullptr;
+}
+
+QString KV3::Value::toString() const {
+	switch (this->type) {
+		case Type::STRING:
+			return this->string;
+		case Type::NUMBER:
+			if (std::trunc(this->number) == this->number && std::abs(this->number) < 9.0e15) {
+				return QString::number(static_cast<qint64>(this->number));
+			}
+			return QString::number(this->number);
+		default:
+			return {};
+	}
+}
+
+std::optional<KV3::Value> KV3::parse(QByteArrayView data, QString* error) {
+	Parser parser{data};
+	Value root;
+	if (!parser.parseRoot(root)) {
+		if (error) {
+			*error = parser.getError();
+		}
+		return std::nullopt;
+	}
+	return root;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include <QByteArrayView>
+#include <QString>
+
+namespace KV3 {
+
+/// A value from a text KeyValues3 file. Flags like resource:"..." are dropped, binary blobs are read as null.
+struct Value {
+	enum class Type {
+		NUL,
+		BOOL,
+		NUMBER,
+		STRING,
+		ARRAY,
+		OBJECT,
+	};
+
+	Type type = Type::NUL;
+	bool boolean = false;
+	double number = 0.0;
+	QString string;
+	std::vector<Value> array;
+	std::vector<std::pair<QString, Value>> object;
+
+	/// Returns the member with the given key, or nullptr if this isn't an object or has no such member
+	[[nodiscard]] const Value* find(QStringView key) const;
+
+	/// Strings are returned as-is and numbers are formatted, anything else is an empty string
+	[[nodiscard]] QString toString() const;
+};
+
+/// Parses text KV3, the <!-- kv3 ... --> header is optional
+[[nodiscard]] std::optional<Value> parse(QByteArrayView data, QString* error = nullptr);
+
+} // namespace KV3
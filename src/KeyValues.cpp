@@ -0,0 +1,194 @@
+#include "KeyValues.h"
+
+namespace {
+
+class Parser {
+public:
+	explicit Parser(QByteArrayView data_)
+			: data(data_) {}
+
+	[[nodiscard]] bool parseRoot(KeyValues::Element& root) {
+		if (this->data.startsWith("\xef\xbb\xbf")) {
+			this->pos = 3;
+		}
+		return this->parseChildren(root, 0);
+	}
+
+	[[nodiscard]] QString getError() const {
+		int line = 1;
+		for (qsizetype i = 0; i < this->pos && i < this->data.size(); i++) {
+			if (this->data[i] == '\n') {
+				line++;
+			}
+		}
+		return QString("Line %1: %2").arg(line).arg(this->error);
+	}
+
+private:
+	static constexpr int MAX_DEPTH = 256;
+
+	enum class Token {
+		STRING,
+		OPEN,
+		CLOSE,
+		CONDITIONAL,
+		END,
+	};
+
+	QByteArrayView data;
+	qsizetype pos = 0;
+	QString error;
+
+	[[nodiscard]] bool fail(const QString& message) {
+		this->error = message;
+		return false;
+	}
+
+	void skipWhitespace() {
+		while (this->pos < this->data.size()) {
+			const char c = this->data[this->pos];
+			if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+				this->pos++;
+			} else if (c == '/' && this->pos + 1 < this->data.size() && this->data[this->pos + 1] == '/') {
+				while (this->pos < this->data.size() && this->data[this->pos] != '\n') {
+					this->pos++;
+				}
+			} else {
+				return;
+			}
+		}
+	}
+
+	[[nodiscard]] Token peek() {
+		this->skipWhitespace();
+		if (this->pos >= this->data.size()) {
+			return Token::END;
+		}
+		switch (this->data[this->pos]) {
+			case '{':
+				return Token::OPEN;
+			case '}':
+				return Token::CLOSE;
+			case '[':
+				return Token::CONDITIONAL;
+			default:
+				return Token::STRING;
+		}
+	}
+
+	[[nodiscard]] QString readString() {
+		if (this->data[this->pos] != '"') {
+			const auto start = this->pos;
+			while (this->pos < this->data.size()) {
+				const char c = this->data[this->pos];
+				if (c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '{' || c == '}' || c == '"') {
+					break;
+				}
+				this->pos++;
+			}
+			return QString::fromUtf8(this->data.sliced(start, this->pos - start));
+		}
+
+		this->pos++;
+		QByteArray buffer;
+		while (this->pos < this->data.size()) {
+			const char c = this->data[this->pos++];
+			if (c == '"') {
+				break;
+			}
+			if (c != '\\' || this->pos >= this->data.size()) {
+				buffer.append(c);
+				continue;
+			}
+			switch (const char escaped = this->data[this->pos++]) {
+				case 'n': buffer.append('\n'); break;
+				case 't': buffer.append('\t'); break;
+				default:  buffer.append(escaped); break;
+			}
+		}
+		return QString::fromUtf8(buffer);
+	}
+
+	void skipConditional() {
+		while (this->pos < this->data.size() && this->data[this->pos] != ']' && this->data[this->pos] != '\n') {
+			this->pos++;
+		}
+		if (this->pos < this->data.size() && this->data[this->pos] == ']') {
+			this->pos++;
+		}
+	}
+
+	[[nodiscard]] bool parseChildren(KeyValues::Element& parent, int depth) {
+		if (depth > MAX_DEPTH) {
+			return this->fail("Nesting is too deep");
+		}
+		while (true) {
+			switch (this->peek()) {
+				case Token::END:
+					return depth == 0 || this->fail("Unexpected end of file");
+				case Token::CLOSE:
+					if (depth == 0) {
+						return this->fail("Unexpected '}'");
+					}
+					this->pos++;
+					return true;
+				case Token::OPEN:
+					return this->fail("Expected a key");
+				case Token::CONDITIONAL:
+					this->skipConditional();
+					continue;
+				case Token::STRING:
+					break;
+			}
+
+			auto& child = parent.children.emplace_back();
+			child.key = this->readString();
+
+			auto token = this->peek();
+			if (token == Token::CONDITIONAL) {
+				this->skipConditional();
+				token = this->peek();
+			}
+			if (token == Token::OPEN) {
+				this->pos++;
+				if (!this->parseChildren(child, depth + 1)) {
+					return false;
+				}
+			} else if (token == Token::STRING) {
+				child.value = this->readString();
+			} else {
+				return this->fail(QString("Expected a value for \"%1\"").arg(child.key));
+			}
+		}
+	}
+};
+
+} // namespace
+
+const KeyValues::Element* KeyValues::Element::find(QStringView childKey) const {
+	for (const auto& child : this->children) {
+		if (child.key.compare(childKey, Qt::CaseInsensitive) == 0) {
+			return &child;
+		}
+	}
+	return nullptr;
+}
+
+QString KeyValues::Element::get(QStringView childKey) const {
+	if (const auto* child = this->find(childKey)) {
+		return child->value;
+	}
+	return {};
+}
+
+std::optional<KeyValues::Element> KeyValues::parse(QByteArrayView data, QString* error) {
+	Parser parser{data};
+	Element root;
+	if (!parser.parseRoot(root)) {
+		if (error) {
+			*error = parser.getError();
+		}
+		return std::nullopt;
+	}
+	return root;
+}
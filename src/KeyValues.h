@@ -0,0 +1,28 @@
+#pragma once
+
+#include <optional>
+#include <vector>
+
+#include <QByteArrayView>
+#include <QString>
+
+namespace KeyValues {
+
+/// A key from a text KeyValues (VDF) file, holding either a string value or child keys.
+/// Conditionals like [$WIN32] are ignored, and #base/#include directives are kept as regular keys.
+struct Element {
+	QString key;
+	QString value;
+	std::vector<Element> children;
+
+	/// Returns the first child with the given key, compared case-insensitively like the engine does
+	[[nodiscard]] const Element* find(QStringView childKey) const;
+
+	/// Value of the given child, or an empty string if it doesn't exist
+	[[nodiscard]] QString get(QStringView childKey) const;
+};
+
+/// Returns an element with no key whose children are the top-level keys in the file
+[[nodiscard]] std::optional<Element> parse(QByteArrayView data, QString* error = nullptr);
+
+} // namespace KeyValues
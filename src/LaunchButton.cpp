@@ -11,6 +11,11 @@ LaunchButton::LaunchButton(QWidget* parent)
 	});
 }
 
+void LaunchButton::enterEvent(QEnterEvent* event) {
+	emit this->hovered();
+	QToolButton::enterEvent(event);
+}
+
 void LaunchButton::mouseDoubleClickEvent(QMouseEvent* event) {
 	if (!Options::get<bool>(BOOL_SINGLE_CLICK_TO_RUN, BOOL_SINGLE_CLICK_TO_RUN_DEFAULT)) {
 		emit this->launch();
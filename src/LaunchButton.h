@@ -2,6 +2,7 @@
 
 #include <QToolButton>
 
+class QEnterEvent;
 class QMouseEvent;
 
 class LaunchButton : public QToolButton {
@@ -11,8 +12,12 @@ public:
 	explicit LaunchButton(QWidget* parent = nullptr);
 
 protected:
+	void enterEvent(QEnterEvent* event) override;
+
 	void mouseDoubleClickEvent(QMouseEvent* event) override;
 
 signals:
+	void hovered();
+
 	void launch();
 };
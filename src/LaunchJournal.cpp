@@ -0,0 +1,428 @@
+#include "LaunchJournal.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QLockFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+namespace {
+
+constexpr quint32 JOURNAL_MAGIC = 0x4c4e4348; // LNCH
+constexpr quint32 JOURNAL_VERSION = 1;
+
+/// The journal grows in steps of this, so most launches don't have to remap it
+constexpr qint64 JOURNAL_GROWTH = 64 * 1024;
+
+/// Entries whose frecency decayed below this (about half a year without a launch) are dropped on compaction
+constexpr double FORGET_FRECENCY = 0.0001;
+
+struct JournalHeader {
+	quint32 magic;
+	quint32 version;
+	quint64 used;
+	quint64 reserved[2];
+};
+static_assert(sizeof(JournalHeader) == 32);
+
+enum class RecordType : quint8 {
+	/// Followed by the command line in UTF-8
+	LAUNCH,
+	/// Followed by a SummaryPayload, standing in for the entry's launches before the records that follow it
+	SUMMARY,
+};
+
+/// Records are stored in host byte order and padded to 8 bytes
+struct RecordHeader {
+	quint32 size;
+	RecordType type;
+	LaunchJournal::Status status;
+	quint16 reserved;
+	quint64 entryID;
+	/// Launch time, or the time of the last summarized launch
+	qint64 time;
+	quint32 spawnLatencyUs;
+	quint32 runTimeMs;
+	qint32 exitCode;
+	quint32 payloadSize;
+};
+static_assert(sizeof(RecordHeader) == 40);
+
+struct SummaryPayload {
+	qint64 launches;
+	qint64 crashes;
+	qint64 frecencyTime;
+	double frecency;
+};
+static_assert(sizeof(SummaryPayload) == 32);
+static_assert((sizeof(RecordHeader) + sizeof(SummaryPayload)) % 8 == 0);
+
+[[nodiscard]] constexpr qint64 alignRecordSize(qint64 size) {
+	return (size + 7) & ~qint64{7};
+}
+
+[[nodiscard]] double getDecay(qint64 elapsedMs) {
+	return std::exp2(-static_cast<double>(elapsedMs) / static_cast<double>(LaunchJournal::FRECENCY_HALF_LIFE_MS));
+}
+
+/// Scores are stored as of a point in time, and decayed whenever they're combined or read
+void addFrecency(double& score, qint64& scoreTime, double amount, qint64 amountTime) {
+	if (amountTime >= scoreTime) {
+		score = score * ::getDecay(amountTime - scoreTime) + amount;
+		scoreTime = amountTime;
+	} else {
+		score += amount * ::getDecay(scoreTime - amountTime);
+	}
+}
+
+[[nodiscard]] double getFrecencyAt(double score, qint64 scoreTime, qint64 time) {
+	return time > scoreTime ? score * ::getDecay(time - scoreTime) : score;
+}
+
+[[nodiscard]] std::optional<qint64> getMedian(QList<quint32> values) {
+	if (values.isEmpty()) {
+		return std::nullopt;
+	}
+	const auto middle = values.begin() + values.size() / 2;
+	std::nth_element(values.begin(), middle, values.end());
+	if (values.size() % 2 == 0) {
+		return (static_cast<qint64>(*middle) + *std::max_element(values.begin(), middle)) / 2;
+	}
+	return *middle;
+}
+
+template<typename T>
+[[nodiscard]] T readAt(const uchar* data, qint64 offset) {
+	T out;
+	std::memcpy(&out, data + offset, sizeof(T));
+	return out;
+}
+
+template<typename T>
+void writeAt(uchar* data, qint64 offset, const T& value) {
+	std::memcpy(data + offset, &value, sizeof(T));
+}
+
+} // namespace
+
+LaunchJournal::LaunchJournal(const QString& path)
+		: path(path)
+		, lock(std::make_unique<QLockFile>(path + ".lock")) {
+	QDir{}.mkpath(QFileInfo{path}.absolutePath());
+	this->writable = this->lock->tryLock(0);
+	this->open();
+
+	if (this->writable && this->needsCompaction()) {
+		this->compact();
+		this->open();
+	}
+}
+
+LaunchJournal::~LaunchJournal() {
+	this->close();
+}
+
+QString LaunchJournal::getDefaultPath() {
+	return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + QDir::separator() + "launches.journal";
+}
+
+quint64 LaunchJournal::getEntryID(const QString& section, const QString& name) {
+	const auto hash = QCryptographicHash::hash((section + '\0' + name).toUtf8(), QCryptographicHash::Sha1);
+	return ::readAt<quint64>(reinterpret_cast<const uchar*>(hash.constData()), 0);
+}
+
+bool LaunchJournal::isWritable() const {
+	return this->writable && this->data;
+}
+
+LaunchJournal::Handle LaunchJournal::recordLaunch(quint64 entryID, const QString& commandLine) {
+	if (!this->isWritable()) {
+		return -1;
+	}
+	const auto commandLineUTF8 = commandLine.toUtf8();
+	const qint64 size = ::alignRecordSize(sizeof(RecordHeader) + commandLineUTF8.size());
+	const qint64 offset = sizeof(JournalHeader) + this->used;
+	if (offset + size > this->capacity && !this->map(std::max(this->capacity * 2, (offset + size + JOURNAL_GROWTH - 1) / JOURNAL_GROWTH * JOURNAL_GROWTH))) {
+		return -1;
+	}
+
+	RecordHeader record{};
+	record.size = static_cast<quint32>(size);
+	record.type = RecordType::LAUNCH;
+	record.status = Status::RUNNING;
+	record.entryID = entryID;
+	record.time = QDateTime::currentMSecsSinceEpoch();
+	record.payloadSize = static_cast<quint32>(commandLineUTF8.size());
+	std::memset(this->data + offset, 0, size);
+	::writeAt(this->data, offset, record);
+	std::memcpy(this->data + offset + sizeof(RecordHeader), commandLineUTF8.constData(), commandLineUTF8.size());
+
+	// The record only becomes part of the journal once it's completely written
+	this->used += size;
+	::writeAt(this->data, offsetof(JournalHeader, used), static_cast<quint64>(this->used));
+
+	this->indexRecord(offset);
+	return offset;
+}
+
+void LaunchJournal::recordStarted(Handle handle, qint64 spawnLatencyUs) {
+	if (!this->isWritable() || handle < 0) {
+		return;
+	}
+	::writeAt(this->data, handle + offsetof(RecordHeader, spawnLatencyUs), static_cast<quint32>(std::clamp<qint64>(spawnLatencyUs, 0, std::numeric_limits<quint32>::max())));
+}
+
+void LaunchJournal::recordExit(Handle handle, Status status, int exitCode, qint64 runTimeMs) {
+	if (!this->isWritable() || handle < 0) {
+		return;
+	}
+	const auto clampedRunTimeMs = static_cast<quint32>(std::clamp<qint64>(runTimeMs, 0, std::numeric_limits<quint32>::max()));
+	::writeAt(this->data, handle + offsetof(RecordHeader, status), status);
+	::writeAt(this->data, handle + offsetof(RecordHeader, runTimeMs), clampedRunTimeMs);
+	::writeAt(this->data, handle + offsetof(RecordHeader, exitCode), static_cast<qint32>(exitCode));
+
+	auto& entry = this->entries[::readAt<RecordHeader>(this->data, handle).entryID];
+	if (status == Status::CRASHED) {
+		entry.crashes++;
+	}
+	if (status == Status::EXITED || status == Status::CRASHED) {
+		entry.runTimesMs.push_back(clampedRunTimeMs);
+		if (entry.runTimesMs.size() > RECORDS_KEPT_PER_ENTRY) {
+			entry.runTimesMs.pop_front();
+		}
+	}
+}
+
+LaunchJournal::Stats LaunchJournal::getStats(quint64 entryID) const {
+	const auto it = this->entries.constFind(entryID);
+	if (it == this->entries.constEnd()) {
+		return {};
+	}
+	Stats stats;
+	stats.launches = it->launches;
+	stats.crashes = it->crashes;
+	stats.frecency = ::getFrecencyAt(it->frecency, it->frecencyTime, QDateTime::currentMSecsSinceEpoch());
+	stats.lastLaunch = it->lastLaunch;
+	stats.medianRunTimeMs = ::getMedian(it->runTimesMs);
+	return stats;
+}
+
+std::optional<qint64> LaunchJournal::getMedianRunTimeMs(quint64 entryID, const QString& commandLine) const {
+	const auto it = this->entries.constFind(entryID);
+	if (it == this->entries.constEnd() || !this->data) {
+		return std::nullopt;
+	}
+	const auto commandLineUTF8 = commandLine.toUtf8();
+	QList<quint32> runTimesMs;
+	for (const auto offset : it->records) {
+		const auto record = ::readAt<RecordHeader>(this->data, offset);
+		if (record.type != RecordType::LAUNCH || record.status != Status::EXITED || record.exitCode != 0 || record.payloadSize != static_cast<quint32>(commandLineUTF8.size())) {
+			continue;
+		}
+		if (std::memcmp(this->data + offset + sizeof(RecordHeader), commandLineUTF8.constData(), commandLineUTF8.size()) == 0) {
+			runTimesMs.push_back(record.runTimeMs);
+		}
+	}
+	return ::getMedian(std::move(runTimesMs));
+}
+
+double LaunchJournal::getFrecency(quint64 entryID) const {
+	const auto it = this->entries.constFind(entryID);
+	if (it == this->entries.constEnd()) {
+		return 0.0;
+	}
+	return ::getFrecencyAt(it->frecency, it->frecencyTime, QDateTime::currentMSecsSinceEpoch());
+}
+
+void LaunchJournal::open() {
+	this->close();
+	this->entries.clear();
+
+	this->file = std::make_unique<QFile>(this->path);
+	if (!this->file->open(this->writable ? QIODevice::ReadWrite : QIODevice::ReadOnly)) {
+		this->writable = false;
+		return;
+	}
+	if (this->file->size() < static_cast<qint64>(sizeof(JournalHeader)) && !this->writable) {
+		return;
+	}
+	if (!this->map(std::max(this->file->size(), JOURNAL_GROWTH))) {
+		return;
+	}
+
+	// A journal from another version is started over, it only holds stats
+	auto header = ::readAt<JournalHeader>(this->data, 0);
+	if (header.magic != JOURNAL_MAGIC || header.version != JOURNAL_VERSION || header.used > static_cast<quint64>(this->capacity) - sizeof(JournalHeader)) {
+		if (!this->writable) {
+			this->close();
+			return;
+		}
+		header = {JOURNAL_MAGIC, JOURNAL_VERSION, 0, {}};
+		::writeAt(this->data, 0, header);
+	}
+	this->used = static_cast<qint64>(header.used);
+
+	const qint64 end = sizeof(JournalHeader) + this->used;
+	qint64 offset = sizeof(JournalHeader);
+	while (offset + static_cast<qint64>(sizeof(RecordHeader)) <= end) {
+		const auto record = ::readAt<RecordHeader>(this->data, offset);
+		if (record.size < sizeof(RecordHeader) || record.size % 8 != 0 || offset + record.size > end || record.payloadSize > record.size - sizeof(RecordHeader)) {
+			break;
+		}
+		if (record.type != RecordType::LAUNCH && (record.type != RecordType::SUMMARY || record.payloadSize != sizeof(SummaryPayload))) {
+			break;
+		}
+		this->indexRecord(offset);
+		offset += record.size;
+	}
+
+	// Anything past a damaged record is lost, but the journal keeps working
+	if (offset != end && this->writable) {
+		this->used = offset - static_cast<qint64>(sizeof(JournalHeader));
+		::writeAt(this->data, offsetof(JournalHeader, used), static_cast<quint64>(this->used));
+	}
+}
+
+void LaunchJournal::close() {
+	if (this->file && this->data) {
+		this->file->unmap(this->data);
+	}
+	this->data = nullptr;
+	this->capacity = 0;
+	this->used = 0;
+	this->file.reset();
+}
+
+bool LaunchJournal::map(qint64 size) {
+	if (this->data) {
+		this->file->unmap(this->data);
+		this->data = nullptr;
+	}
+	if (this->writable && this->file->size() < size && !this->file->resize(size)) {
+		return false;
+	}
+	size = std::min(size, this->file->size());
+	this->data = this->file->map(0, size);
+	this->capacity = this->data ? size : 0;
+	return this->data != nullptr;
+}
+
+void LaunchJournal::indexRecord(qint64 offset) {
+	const auto record = ::readAt<RecordHeader>(this->data, offset);
+	auto& entry = this->entries[record.entryID];
+	entry.records.push_back(offset);
+	entry.lastLaunch = std::max(entry.lastLaunch, record.time);
+
+	if (record.type == RecordType::SUMMARY) {
+		const auto summary = ::readAt<SummaryPayload>(this->data, offset + sizeof(RecordHeader));
+		entry.launches += summary.launches;
+		entry.crashes += summary.crashes;
+		::addFrecency(entry.frecency, entry.frecencyTime, summary.frecency, summary.frecencyTime);
+		return;
+	}
+
+	entry.launches++;
+	::addFrecency(entry.frecency, entry.frecencyTime, 1.0, record.time);
+	if (record.status == Status::CRASHED) {
+		entry.crashes++;
+	}
+	if (record.status == Status::EXITED || record.status == Status::CRASHED) {
+		entry.runTimesMs.push_back(record.runTimeMs);
+		if (entry.runTimesMs.size() > RECORDS_KEPT_PER_ENTRY) {
+			entry.runTimesMs.pop_front();
+		}
+	}
+}
+
+bool LaunchJournal::needsCompaction() const {
+	if (!this->data) {
+		return false;
+	}
+	const auto now = QDateTime::currentMSecsSinceEpoch();
+	qsizetype records = 0;
+	qsizetype needed = 0;
+	for (const auto& entry : this->entries) {
+		if (::getFrecencyAt(entry.frecency, entry.frecencyTime, now) < FORGET_FRECENCY) {
+			return true;
+		}
+		records += entry.records.size();
+		// Kept launches, plus the summary
+		needed += std::min(entry.records.size(), RECORDS_KEPT_PER_ENTRY + 1);
+	}
+	return records > needed * 2;
+}
+
+void LaunchJournal::compact() {
+	const auto now = QDateTime::currentMSecsSinceEpoch();
+
+	QByteArray compacted(sizeof(JournalHeader), '\0');
+	for (const auto& [entryID, entry] : this->entries.asKeyValueRange()) {
+		if (::getFrecencyAt(entry.frecency, entry.frecencyTime, now) < FORGET_FRECENCY) {
+			continue;
+		}
+
+		QList<qint64> launches;
+		SummaryPayload summary{};
+		qint64 summaryTime = 0;
+		bool hasSummary = false;
+		const auto addToSummary = [&](const RecordHeader& record, qint64 offset) {
+			hasSummary = true;
+			summaryTime = std::max(summaryTime, record.time);
+			if (record.type == RecordType::SUMMARY) {
+				const auto previous = ::readAt<SummaryPayload>(this->data, offset + sizeof(RecordHeader));
+				summary.launches += previous.launches;
+				summary.crashes += previous.crashes;
+				::addFrecency(summary.frecency, summary.frecencyTime, previous.frecency, previous.frecencyTime);
+				return;
+			}
+			summary.launches++;
+			if (record.status == Status::CRASHED) {
+				summary.crashes++;
+			}
+			::addFrecency(summary.frecency, summary.frecencyTime, 1.0, record.time);
+		};
+		for (const auto offset : entry.records) {
+			if (const auto record = ::readAt<RecordHeader>(this->data, offset); record.type == RecordType::SUMMARY) {
+				addToSummary(record, offset);
+			} else {
+				launches.push_back(offset);
+			}
+		}
+		const auto dropped = std::max<qsizetype>(launches.size() - RECORDS_KEPT_PER_ENTRY, 0);
+		for (qsizetype i = 0; i < dropped; i++) {
+			addToSummary(::readAt<RecordHeader>(this->data, launches[i]), launches[i]);
+		}
+
+		if (hasSummary) {
+			RecordHeader record{};
+			record.size = sizeof(RecordHeader) + sizeof(SummaryPayload);
+			record.type = RecordType::SUMMARY;
+			record.entryID = entryID;
+			record.time = summaryTime;
+			record.payloadSize = sizeof(SummaryPayload);
+			compacted.append(reinterpret_cast<const char*>(&record), sizeof(record));
+			compacted.append(reinterpret_cast<const char*>(&summary), sizeof(summary));
+		}
+		for (qsizetype i = dropped; i < launches.size(); i++) {
+			compacted.append(reinterpret_cast<const char*>(this->data + launches[i]), ::readAt<RecordHeader>(this->data, launches[i]).size);
+		}
+	}
+	const JournalHeader header{JOURNAL_MAGIC, JOURNAL_VERSION, static_cast<quint64>(compacted.size() - sizeof(JournalHeader)), {}};
+	std::memcpy(compacted.data(), &header, sizeof(header));
+
+	// Unmapped first, the journal can't be replaced while it's mapped on Windows
+	this->close();
+	QSaveFile out{this->path};
+	if (out.open(QIODevice::WriteOnly) && out.write(compacted) == compacted.size()) {
+		out.commit();
+	}
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+
+#include <QHash>
+#include <QList>
+#include <QString>
+
+class QFile;
+class QLockFile;
+
+/// Append-only record of every command launched from the launcher. The journal is memory mapped, so recording a
+/// launch is a copy into the map, and its exit status is patched into the same record once the process is done.
+/// Stats are indexed per entry when the journal is opened, and old launches are folded into one summary record
+/// per entry whenever the journal holds twice as many records as the index needs.
+class LaunchJournal {
+public:
+	enum class Status : quint8 {
+		/// Still running, or the launcher was closed before it exited
+		RUNNING,
+		EXITED,
+		CRASHED,
+		FAILED_TO_START,
+		/// Stopped by the user, which isn't a crash and doesn't count towards the usual run time
+		CANCELLED,
+	};
+
+	/// Offset of the launch record in the journal, or -1 if the journal couldn't be written to
+	using Handle = qint64;
+
+	struct Stats {
+		qint64 launches = 0;
+		qint64 crashes = 0;
+		/// Launches weighted by how recent they are, see FRECENCY_HALF_LIFE_MS
+		double frecency = 0.0;
+		/// Milliseconds since epoch
+		qint64 lastLaunch = 0;
+		/// Median run time of the most recent launches that ran to completion
+		std::optional<qint64> medianRunTimeMs;
+
+		[[nodiscard]] double getCrashRate() const { return this->launches > 0 ? static_cast<double>(this->crashes) / static_cast<double>(this->launches) : 0.0; }
+	};
+
+	/// A launch counts for half as much after this long
+	static constexpr qint64 FRECENCY_HALF_LIFE_MS = 14ll * 24 * 60 * 60 * 1000;
+
+	/// Launches kept verbatim per entry, older ones only survive in the entry's summary
+	static constexpr qsizetype RECORDS_KEPT_PER_ENTRY = 64;
+
+	explicit LaunchJournal(const QString& path = getDefaultPath());
+
+	~LaunchJournal();
+
+	[[nodiscard]] static QString getDefaultPath();
+
+	/// Entries are identified by their section and name, so stats survive the config being edited or moved
+	[[nodiscard]] static quint64 getEntryID(const QString& section, const QString& name);
+
+	/// False if another launcher has the journal open, stats are still available but nothing is recorded
+	[[nodiscard]] bool isWritable() const;
+
+	Handle recordLaunch(quint64 entryID, const QString& commandLine);
+
+	/// Time between asking for the process to start and it actually running
+	void recordStarted(Handle handle, qint64 spawnLatencyUs);
+
+	void recordExit(Handle handle, Status status, int exitCode, qint64 runTimeMs);
+
+	[[nodiscard]] Stats getStats(quint64 entryID) const;
+
+	/// Median run time of the entry's kept launches with exactly this command line that exited successfully,
+	/// so a compile of one map isn't estimated from compiles of another
+	[[nodiscard]] std::optional<qint64> getMedianRunTimeMs(quint64 entryID, const QString& commandLine) const;
+
+	/// Same as getStats(entryID).frecency, without computing the median run time
+	[[nodiscard]] double getFrecency(quint64 entryID) const;
+
+private:
+	struct EntryIndex {
+		qint64 launches = 0;
+		qint64 crashes = 0;
+		double frecency = 0.0;
+		qint64 frecencyTime = 0;
+		qint64 lastLaunch = 0;
+		/// Run times of the most recent finished launches, oldest first
+		QList<quint32> runTimesMs;
+		/// Offsets of the entry's records, oldest first
+		QList<qint64> records;
+	};
+
+	void open();
+
+	void close();
+
+	[[nodiscard]] bool map(qint64 size);
+
+	void indexRecord(qint64 offset);
+
+	[[nodiscard]] bool needsCompaction() const;
+
+	void compact();
+
+	QString path;
+	std::unique_ptr<QLockFile> lock;
+	bool writable = false;
+	std::unique_ptr<QFile> file;
+	uchar* data = nullptr;
+	qint64 capacity = 0;
+	/// Bytes of records following the journal header
+	qint64 used = 0;
+	QHash<quint64, EntryIndex> entries;
+};
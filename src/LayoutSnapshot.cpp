@@ -0,0 +1,105 @@
+#include "LayoutSnapshot.h"
+
+#include <algorithm>
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include "Config.h"
+
+namespace {
+
+constexpr quint32 SNAPSHOT_MAGIC = 0x4c594f54; // LYOT
+constexpr quint32 SNAPSHOT_VERSION = 2;
+
+} // namespace
+
+bool LayoutSnapshot::Snapshot::hasSameEntries(const Snapshot& other) const {
+	if (this->sections.size() != other.sections.size()) {
+		return false;
+	}
+	for (qsizetype i = 0; i < this->sections.size(); i++) {
+		const auto& lhs = this->sections[i];
+		const auto& rhs = other.sections[i];
+		if (lhs.name != rhs.name || lhs.entries.size() != rhs.entries.size()) {
+			return false;
+		}
+		if (!std::equal(lhs.entries.begin(), lhs.entries.end(), rhs.entries.begin(), [](const Entry& a, const Entry& b) { return a.name == b.name; })) {
+			return false;
+		}
+	}
+	return true;
+}
+
+QString LayoutSnapshot::getDefaultPath() {
+	return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QDir::separator() + "layout.bin";
+}
+
+qint64 LayoutSnapshot::getConfigModified(const QString& configPath) {
+	if (configPath.startsWith(':')) {
+		return 0;
+	}
+	const QFileInfo info{configPath};
+	return info.exists() ? info.lastModified().toMSecsSinceEpoch() : -1;
+}
+
+std::optional<LayoutSnapshot::Snapshot> LayoutSnapshot::load(const QString& configPath, const QString& gameOverride, const QString& path) {
+	QFile file{path};
+	if (!file.open(QIODevice::ReadOnly)) {
+		return std::nullopt;
+	}
+	QDataStream in{&file};
+	quint32 magic, version;
+	QString launcherVersion;
+	Snapshot snapshot;
+	in >> magic >> version >> launcherVersion >> snapshot.configPath >> snapshot.configFiles >> snapshot.gameOverride;
+	// The builtin config changes with the launcher, so snapshots from other versions are never reused
+	if (in.status() != QDataStream::Ok || magic != SNAPSHOT_MAGIC || version != SNAPSHOT_VERSION || launcherVersion != PROJECT_VERSION.data()) {
+		return std::nullopt;
+	}
+	if (snapshot.configPath != configPath || snapshot.gameOverride != gameOverride) {
+		return std::nullopt;
+	}
+	if (std::any_of(snapshot.configFiles.begin(), snapshot.configFiles.end(), [](const auto& file) { return getConfigModified(file.first) != file.second; })) {
+		return std::nullopt;
+	}
+
+	qint64 sectionCount;
+	in >> snapshot.windowWidth >> snapshot.windowHeight >> sectionCount;
+	for (qint64 i = 0; i < sectionCount && in.status() == QDataStream::Ok; i++) {
+		auto& section = snapshot.sections.emplace_back();
+		qint64 entryCount;
+		in >> section.name >> entryCount;
+		for (qint64 j = 0; j < entryCount && in.status() == QDataStream::Ok; j++) {
+			auto& entry = section.entries.emplace_back();
+			in >> entry.name >> entry.toolTip >> entry.icon >> entry.enabled;
+		}
+	}
+	if (in.status() != QDataStream::Ok) {
+		return std::nullopt;
+	}
+	return snapshot;
+}
+
+void LayoutSnapshot::save(const Snapshot& snapshot, const QString& path) {
+	(void) QDir{}.mkpath(QFileInfo{path}.absolutePath());
+	QSaveFile file{path};
+	if (!file.open(QIODevice::WriteOnly)) {
+		return;
+	}
+	QDataStream out{&file};
+	out << SNAPSHOT_MAGIC << SNAPSHOT_VERSION << QString{PROJECT_VERSION.data()} << snapshot.configPath << snapshot.configFiles << snapshot.gameOverride;
+	out << snapshot.windowWidth << snapshot.windowHeight << static_cast<qint64>(snapshot.sections.size());
+	for (const auto& section : snapshot.sections) {
+		out << section.name << static_cast<qint64>(section.entries.size());
+		for (const auto& entry : section.entries) {
+			out << entry.name << entry.toolTip << entry.icon << entry.enabled;
+		}
+	}
+	(void) file.commit();
+}
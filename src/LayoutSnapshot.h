@@ -0,0 +1,50 @@
+#pragma once
+
+#include <optional>
+#include <utility>
+
+#include <QImage>
+#include <QList>
+#include <QString>
+
+/// The last rendered launcher layout, saved on exit so the next start can paint it before the config is parsed.
+/// Only what is needed to draw the window is stored, the real buttons always come from the config.
+namespace LayoutSnapshot {
+
+struct Entry {
+	QString name;
+	QString toolTip;
+	QImage icon;
+	bool enabled = true;
+};
+
+struct Section {
+	QString name;
+	QList<Entry> entries;
+};
+
+struct Snapshot {
+	QString configPath;
+	/// Every file the config was built from, including the configs it extends or includes, and when it was modified
+	QList<std::pair<QString, qint64>> configFiles;
+	QString gameOverride;
+	int windowWidth = 0;
+	int windowHeight = 0;
+	QList<Section> sections;
+
+	/// Checks if the config would produce the same buttons in the same order, ignoring icons and tooltips
+	[[nodiscard]] bool hasSameEntries(const Snapshot& other) const;
+};
+
+[[nodiscard]] QString getDefaultPath();
+
+/// Timestamp of a config file, 0 for resources and -1 for files that don't exist, matching what the config parser records
+[[nodiscard]] qint64 getConfigModified(const QString& configPath);
+
+/// Returns the saved snapshot if it was taken from the given config, game override and launcher version,
+/// and none of the files the config was built from have changed since
+[[nodiscard]] std::optional<Snapshot> load(const QString& configPath, const QString& gameOverride, const QString& path = getDefaultPath());
+
+void save(const Snapshot& snapshot, const QString& path = getDefaultPath());
+
+} // namespace LayoutSnapshot
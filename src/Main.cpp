@@ -1,9 +1,18 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
 #include <QApplication>
 #include <QStyleHints>
 
 #include "Config.h"
+#include "ConfigLint.h"
 #include "Window.h"
 
+#ifdef _WIN32
+	#include <Windows.h>
+#endif
+
 int main(int argc, char** argv) {
 	QCoreApplication::setOrganizationName(PROJECT_ORGANIZATION.data());
 	QCoreApplication::setApplicationName(PROJECT_NAME.data());
@@ -13,6 +22,19 @@ int main(int argc, char** argv) {
 	QGuiApplication::setDesktopFileName(PROJECT_NAME.data());
 #endif
 
+	// Linting runs headless, so content CI can check configs without a display
+	if (std::any_of(argv + 1, argv + argc, [](const char* arg) { return std::strcmp(arg, "--lint") == 0; })) {
+#ifdef _WIN32
+		// The launcher is a GUI app, so without redirected output nothing would reach the console it was run from
+		if (!GetStdHandle(STD_OUTPUT_HANDLE) && AttachConsole(ATTACH_PARENT_PROCESS)) {
+			(void) std::freopen("CONOUT$", "w", stdout);
+			(void) std::freopen("CONOUT$", "w", stderr);
+		}
+#endif
+		QCoreApplication app(argc, argv);
+		return ConfigLint::run(QCoreApplication::arguments());
+	}
+
 	QApplication app(argc, argv);
 
 	if (QGuiApplication::styleHints()->colorScheme() == Qt::ColorScheme::Dark) {
@@ -1,149 +1,84 @@
 #include "NewModDialog.h"
 
-#include <cstring>
+#include <atomic>
 #include <filesystem>
+#include <functional>
 #include <utility>
 
-#include <miniz.h>
 #include <QCheckBox>
 #include <QComboBox>
 #include <QDesktopServices>
 #include <QDialogButtonBox>
 #include <QDir>
+#include <QEventLoop>
 #include <QFile>
 #include <QFileDialog>
+#include <QFileInfo>
 #include <QFormLayout>
+#include <QFutureWatcher>
 #include <QLabel>
 #include <QLineEdit>
 #include <QMessageBox>
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
 #include <QProgressBar>
 #include <QProgressDialog>
 #include <QPushButton>
 #include <QStandardPaths>
+#include <QtConcurrent>
 
+#include "Extract.h"
+#include "ExtractionSink.h"
 #include "Steam.h"
+#include "TemplatePrefetch.h"
 
 namespace {
 
-[[nodiscard]] QString join(const QStringList& list, const QString& separator) {
-	if (list.isEmpty()) {
-		return "";
-	}
-	QString result = list.first();
-	for (int i = 1; i < list.size(); i++) {
-		result += separator + list[i];
-	}
-	return result;
+/// Extracts on a worker thread so the UI keeps responding, and waits for it while the progress dialog is updated
+[[nodiscard]] bool runExtraction(QProgressDialog& progressDialog, const std::function<bool(const ExtractProgressCallback&)>& extract) {
+	std::atomic_bool canceled = false;
+	QObject::connect(&progressDialog, &QProgressDialog::canceled, &progressDialog, [&canceled] {
+		canceled = true;
+	});
+	const ExtractProgressCallback progress = [&progressDialog, &canceled](qsizetype processed, qsizetype total) {
+		QMetaObject::invokeMethod(&progressDialog, [&progressDialog, processed, total] {
+			progressDialog.setMaximum(static_cast<int>(total));
+			progressDialog.setValue(static_cast<int>(processed));
+		});
+		return !canceled;
+	};
+
+	QFutureWatcher<bool> watcher;
+	QEventLoop loop;
+	QObject::connect(&watcher, &QFutureWatcher<bool>::finished, &loop, &QEventLoop::quit);
+	watcher.setFuture(QtConcurrent::run([&extract, &progress] {
+		return extract(progress);
+	}));
+	loop.exec();
+	return watcher.result();
 }
 
-[[nodiscard]] bool writeDataToFile(const QByteArray& data, const QString& path) {
-	std::filesystem::create_directories(std::filesystem::path{path.toLocal8Bit().constData()}.parent_path());
-
-	QFile file{path};
-	if (!file.open(QIODevice::WriteOnly)) {
-		return false;
+void showSkippedLinks(const QStringList& skippedLinks, QWidget* parent) {
+	if (skippedLinks.isEmpty()) {
+		return;
 	}
-	file.write(data);
-	file.close();
-	return true;
-}
-
-[[nodiscard]] bool extractZIP(const QByteArray& zip, const QString& outputDir, QWidget* parent) {
-	mz_zip_archive zipArchive{};
-
-	if (!mz_zip_reader_init_mem(&zipArchive, zip.data(), zip.size(), 0)) {
-		return false;
-	}
-
-	// Collect file data
-	QMap<int, mz_zip_archive_file_stat> files;
-	QStringList filePaths;
-	const unsigned int fileCount = mz_zip_reader_get_num_files(&zipArchive);
-	for (int i = 0; std::cmp_less(i, fileCount); i++) {
-		if (mz_zip_reader_is_file_a_directory(&zipArchive, i)) {
-			continue;
-		}
-
-		mz_zip_archive_file_stat fileStat;
-		if (!mz_zip_reader_file_stat(&zipArchive, i, &fileStat)) {
-			return false;
-		}
-
-		files[i] = fileStat;
-
-		filePaths.push_back(fileStat.m_filename);
-		filePaths.back().replace('\\', '/');
-	}
-
-	// Find root dir(s) using probably the slowest algorithm ever
-	QList<QStringList> pathSplits;
-	for (const auto& path : filePaths) {
-		pathSplits.push_back(path.split('/'));
-	}
-	QStringList rootDirList;
-	while (true) {
-		bool allTheSame = true;
-		QString first = pathSplits[0][0];
-		for (const auto& path : pathSplits) {
-			if (path.length() == 1) {
-				allTheSame = false;
-				break;
-			}
-			if (path[0] != first) {
-				allTheSame = false;
-				break;
-			}
-		}
-		if (!allTheSame) {
-			break;
-		}
-		rootDirList.push_back(std::move(first));
-		for (auto& path : pathSplits) {
-			path.pop_front();
-		}
-	}
-	const qsizetype rootDirLen = ::join(rootDirList, "/").length();
-
-	// Write file without root dir(s)
-	QProgressDialog progressDialog{QObject::tr("Extracting zip..."), QObject::tr("Cancel"), 0, static_cast<int>(files.size()), parent};
-	progressDialog.setWindowModality(Qt::WindowModal);
-	for (auto file = files.cbegin(); file != files.cend(); ++file) {
-		if (progressDialog.wasCanceled()) {
-			return false;
-		}
-
-		QByteArray fileData;
-		fileData.resize(static_cast<qsizetype>(file.value().m_uncomp_size));
-		if (!mz_zip_reader_extract_to_mem(&zipArchive, file.key(), fileData.data(), fileData.size(), 0)) {
-			return false;
-		}
-
-		if (!::writeDataToFile(fileData, outputDir + QDir::separator() + QString{file.value().m_filename}.sliced(rootDirLen))) {
-			return false;
-		}
-
-		progressDialog.setValue(progressDialog.value() + 1);
-	}
-	progressDialog.setValue(progressDialog.maximum());
-
-	mz_zip_reader_end(&zipArchive);
-	return true;
+	QMessageBox links{QMessageBox::Warning, QObject::tr("Links Skipped"), QObject::tr("%1 link(s) in the template were not extracted.").arg(skippedLinks.size()), QMessageBox::Ok, parent};
+	links.setDetailedText(skippedLinks.join('\n'));
+	links.exec();
 }
 
 } // namespace
 
-NewModDialog::NewModDialog(QString gameRoot_, QString downloadURL_, QWidget* parent)
+NewModDialog::NewModDialog(QString gameRoot_, QString downloadURL_, QString downloadSHA256_, Mode mode_, QWidget* parent)
 		: QDialog(parent)
 		, gameRoot(std::move(gameRoot_))
-		, downloadURL(std::move(downloadURL_)) {
+		, downloadURL(std::move(downloadURL_))
+		, downloadSHA256(std::move(downloadSHA256_))
+		, mode(mode_) {
 	// Check for sourcemods
 	const bool knowsSourcemodsDirLocation = !::getSourceModsDir().isEmpty();
 
 	// Window setup
 	this->setModal(true);
-	this->setWindowTitle(tr("New Mod"));
+	this->setWindowTitle(this->mode == Mode::UPDATE ? tr("Update Mod from Template") : tr("New Mod"));
 	this->setMinimumWidth(350);
 
 	// Create UI elements
@@ -185,15 +120,43 @@ NewModDialog::NewModDialog(QString gameRoot_, QString downloadURL_, QWidget* par
 	this->addShortcutOnDesktop->setCheckState(Qt::Checked);
 	layout->addRow(tr("Create Desktop Shortcut"), this->addShortcutOnDesktop);
 
-	auto* buttonBox = new QDialogButtonBox{QDialogButtonBox::Ok | QDialogButtonBox::Cancel, Qt::Horizontal, this};
-	layout->addWidget(buttonBox);
+	auto* modFolderParent = new QWidget{this};
+	auto* modFolderLayout = new QHBoxLayout{modFolderParent};
+	modFolderLayout->setSpacing(4);
+	modFolderLayout->setContentsMargins(0, 0, 0, 0);
+
+	this->modFolder = new QLineEdit{modFolderParent};
+	modFolderLayout->addWidget(this->modFolder);
+
+	auto* modFolderSearch = new QPushButton{modFolderParent};
+	modFolderSearch->setIcon(this->style()->standardIcon(QStyle::SP_DirOpenIcon));
+	modFolderLayout->addWidget(modFolderSearch);
+
+	QObject::connect(modFolderSearch, &QPushButton::clicked, this, [this, knowsSourcemodsDirLocation] {
+		const auto startDir = knowsSourcemodsDirLocation ? ::getSourceModsDir() : this->gameRoot;
+		if (const auto path = QFileDialog::getExistingDirectory(this, tr("Select Mod Folder"), startDir); !path.isEmpty()) {
+			this->modFolder->setText(path);
+		}
+	});
+
+	layout->addRow(tr("Mod Folder"), modFolderParent);
+
+	this->buttonBox = new QDialogButtonBox{QDialogButtonBox::Ok | QDialogButtonBox::Cancel, Qt::Horizontal, this};
+	layout->addWidget(this->buttonBox);
 
 	this->downloadProgress = new QProgressBar{this};
 	this->downloadProgress->setFormat(tr("%vkb / %mkb"));
 	layout->addWidget(downloadProgress);
 
-	// Create network
-	this->network = new QNetworkAccessManager{this};
+	// Start downloading the template while the form is being filled in
+	TemplatePrefetch::get()->prefetch(this->downloadURL);
+
+	// Updating only needs to know where the mod is
+	const bool updating = this->mode == Mode::UPDATE;
+	layout->setRowVisible(this->parentFolder, !updating);
+	layout->setRowVisible(this->modID, !updating);
+	layout->setRowVisible(this->addShortcutOnDesktop, !updating);
+	layout->setRowVisible(modFolderParent, updating);
 
 	// We want the custom input to be invisible unless the combo box is on the custom option
 	layout->setRowVisible(parentFolderCustomParent, false);
@@ -203,9 +166,24 @@ NewModDialog::NewModDialog(QString gameRoot_, QString downloadURL_, QWidget* par
 	});
 
 	// Connect ok/cancel buttons to download stuff
-	buttonBox->show();
+	this->buttonBox->show();
 	this->downloadProgress->hide();
-	QObject::connect(buttonBox, &QDialogButtonBox::accepted, this, [this, buttonBox] {
+	QObject::connect(this->buttonBox, &QDialogButtonBox::accepted, this, [this] {
+		if (this->mode == Mode::UPDATE) {
+			// Validate mod folder
+			if (this->modFolder->text().trimmed().isEmpty() || !QFileInfo{this->modFolder->text().trimmed()}.isDir()) {
+				QMessageBox::critical(this, tr("Incorrect Input"), tr("Mod folder does not exist."));
+				return;
+			}
+			if (!QFile::exists(this->modFolder->text().trimmed() + '/' + TEMPLATE_MANIFEST_FILENAME) && QMessageBox::question(this, tr("No Template Record"), tr("This mod was not created by this launcher, so there is no record of which files came from the template. Only missing files will be added, and every other difference will be reported as a conflict. Continue?")) != QMessageBox::Yes) {
+				return;
+			}
+			this->downloadTemplate([this](const QByteArray& zip) {
+				this->updateMod(zip);
+			});
+			return;
+		}
+
 		// Validate mod ID
 		if (this->modID->text().trimmed().isEmpty()) {
 			QMessageBox::critical(this, tr("Incorrect Input"), tr("Mod ID must not be empty."));
@@ -220,64 +198,140 @@ NewModDialog::NewModDialog(QString gameRoot_, QString downloadURL_, QWidget* par
 			return;
 		}
 		if (std::filesystem::exists(modInstallDir.toLocal8Bit().constData())) {
-			QMessageBox::critical(this, tr("Incorrect Input"), tr("A folder with the name of the mod ID already exists at this install location."));
+			QMessageBox::critical(this, tr("Incorrect Input"), tr("A folder with the name of the mod ID already exists at this install location. To pull in changes to the template, use \"Update Mod from Template\" instead."));
 			return;
 		}
 
-		// Initiate the download
-		auto* reply = this->network->get(QNetworkRequest{QUrl(this->downloadURL)});
-
-		// Connect download progress to progress bar, measured in kb
-		QObject::connect(reply, &QNetworkReply::downloadProgress, this, [this, buttonBox](qint64 recv, qint64 total) {
-			buttonBox->hide();
-			this->downloadProgress->show();
-			if (total < 0) {
-				this->downloadProgress->setRange(0, 0);
-				this->downloadProgress->setTextVisible(false);
-			} else {
-				this->downloadProgress->setRange(0, static_cast<int>(total / 1000));
-				this->downloadProgress->setValue(static_cast<int>(recv / 1000));
-				this->downloadProgress->setTextVisible(true);
-			}
+		this->downloadTemplate([this](const QByteArray& zip) {
+			this->createMod(zip);
 		});
+	});
+	QObject::connect(this->buttonBox, &QDialogButtonBox::rejected, this, &NewModDialog::reject);
+}
 
-		// Connect finished downloading response to the rest of the processing code
-		QObject::connect(reply, &QNetworkReply::finished, this, [this, modInstallDir, reply] {
-			// Check for a download error
-			if (reply->error() != QNetworkReply::NoError) {
-				QMessageBox::critical(this, tr("Error"), tr("An error occurred while downloading the mod template: %1").arg(reply->errorString()));
-				this->accept();
-				return;
-			}
+void NewModDialog::downloadTemplate(std::function<void(const QByteArray&)> onDownloaded) {
+	// The template has usually been downloading since the dialog opened, this picks up wherever it got to
+	auto* prefetch = TemplatePrefetch::get();
 
-			// Extract zip contents in memory to destination
-			if (!::extractZIP(reply->readAll(), modInstallDir, this)) {
-				QDir{modInstallDir}.removeRecursively();
-				QMessageBox::critical(this, tr("Error"), tr("An error occurred while extracting the mod template."));
-				this->accept();
-				return;
-			}
+	// Connect download progress to progress bar, measured in kb
+	QObject::connect(prefetch, &TemplatePrefetch::progress, this, [this](const QString& url, qint64 recv, qint64 total) {
+		if (url != this->downloadURL) {
+			return;
+		}
+		this->buttonBox->hide();
+		this->downloadProgress->show();
+		if (total < 0) {
+			this->downloadProgress->setRange(0, 0);
+			this->downloadProgress->setTextVisible(false);
+		} else {
+			this->downloadProgress->setRange(0, static_cast<int>(total / 1000));
+			this->downloadProgress->setValue(static_cast<int>(recv / 1000));
+			this->downloadProgress->setTextVisible(true);
+		}
+	});
+
+	// Connect finished downloading response to the rest of the processing code
+	QObject::connect(prefetch, &TemplatePrefetch::finished, this, [this, onDownloaded = std::move(onDownloaded)](const QString& url) {
+		if (url != this->downloadURL) {
+			return;
+		}
+		const auto download = TemplatePrefetch::get()->take(url);
+
+		// Check for a download error
+		if (!download.error.isEmpty()) {
+			QMessageBox::critical(this, tr("Error"), tr("An error occurred while downloading the mod template: %1").arg(download.error));
+			this->accept();
+			return;
+		}
+
+		// Check the pinned checksum, if there is one
+		if (!this->downloadSHA256.isEmpty() && download.sha256.toHex() != this->downloadSHA256.toLatin1()) {
+			QMessageBox::critical(this, tr("Error"), tr("The downloaded mod template does not match its pinned SHA-256 checksum. It may be corrupted or truncated."));
+			this->accept();
+			return;
+		}
+
+		onDownloaded(download.data);
+	});
 
-			// Create desktop shortcut
-			if (this->addShortcutOnDesktop->isChecked()) {
-				const auto shortcutPath = QStandardPaths::writableLocation(QStandardPaths::DesktopLocation) + QDir::separator() + this->modID->text().trimmed();
+	prefetch->attach(this->downloadURL);
+}
+
+void NewModDialog::createMod(const QByteArray& zip) {
+	const auto modInstallDir = this->getModInstallDir();
+
+	// Extract template contents in memory to destination
+	QProgressDialog progressDialog{tr("Extracting template..."), tr("Cancel"), 0, 0, this};
+	progressDialog.setWindowModality(Qt::WindowModal);
+	const auto sink = ExtractionSink::create();
+	TemplateManifest manifest;
+	QStringList skippedLinks;
+	if (!::runExtraction(progressDialog, [&](const ExtractProgressCallback& progress) {
+		return ::extractZIP(zip, modInstallDir, *sink, &manifest, progress, &skippedLinks);
+	})) {
+		QDir{modInstallDir}.removeRecursively();
+		QMessageBox::critical(this, tr("Error"), tr("An error occurred while extracting the mod template."));
+		this->accept();
+		return;
+	}
+
+	::showSkippedLinks(skippedLinks, this);
+
+	// Remember what was installed, so the mod can be updated from newer revisions of the template
+	if (!::writeTemplateManifest(modInstallDir, manifest)) {
+		QMessageBox::warning(this, tr("Warning"), tr("The mod was created, but the list of files installed from the template couldn't be saved. Updating the mod from the template later will report every file as a conflict."));
+	}
+
+	// Create desktop shortcut
+	if (this->addShortcutOnDesktop->isChecked()) {
+		const auto shortcutPath = QStandardPaths::writableLocation(QStandardPaths::DesktopLocation) + QDir::separator() + this->modID->text().trimmed();
 #ifdef _WIN32
-				QFile::link(modInstallDir, shortcutPath + ".lnk");
+		QFile::link(modInstallDir, shortcutPath + ".lnk");
 #else
-				QFile::link(modInstallDir, shortcutPath);
+		QFile::link(modInstallDir, shortcutPath);
 #endif
-			}
+	}
 
-			// If installing to sourcemods, tell user they will need to restart steam
-			if (this->parentFolder->count() == 3 && this->parentFolder->currentIndex() == 0) {
-				QMessageBox::information(this, tr("Info"), tr("Your mod has been installed to Steam's SourceMods folder, which means it will show up in your Steam library! This requires you to restart Steam once."));
-			}
+	// If installing to sourcemods, tell user they will need to restart steam
+	if (this->parentFolder->count() == 3 && this->parentFolder->currentIndex() == 0) {
+		QMessageBox::information(this, tr("Info"), tr("Your mod has been installed to Steam's SourceMods folder, which means it will show up in your Steam library! This requires you to restart Steam once."));
+	}
 
-			QDesktopServices::openUrl(QUrl::fromLocalFile(modInstallDir));
-			this->accept();
-		});
-	});
-	QObject::connect(buttonBox, &QDialogButtonBox::rejected, this, &NewModDialog::reject);
+	QDesktopServices::openUrl(QUrl::fromLocalFile(modInstallDir));
+	this->accept();
+}
+
+void NewModDialog::updateMod(const QByteArray& zip) {
+	const auto modDir = this->modFolder->text().trimmed();
+
+	QProgressDialog progressDialog{tr("Updating mod..."), tr("Cancel"), 0, 0, this};
+	progressDialog.setWindowModality(Qt::WindowModal);
+	const auto sink = ExtractionSink::create();
+	auto manifest = ::readTemplateManifest(modDir);
+	TemplateUpdateReport report;
+	if (!::runExtraction(progressDialog, [&](const ExtractProgressCallback& progress) {
+		return ::updateFromZIP(zip, modDir, *sink, manifest, report, progress);
+	})) {
+		QMessageBox::critical(this, tr("Error"), tr("An error occurred while updating the mod from the template. Some files may have already been updated."));
+		this->accept();
+		return;
+	}
+	if (!::writeTemplateManifest(modDir, manifest)) {
+		QMessageBox::warning(this, tr("Warning"), tr("The mod was updated, but the list of files installed from the template couldn't be saved. The next update may report files as conflicts."));
+	}
+	::showSkippedLinks(report.skippedLinks, this);
+
+	QString summary = tr("%1 file(s) added, %2 updated, %3 removed.").arg(report.added.size()).arg(report.updated.size()).arg(report.removed.size());
+	if (report.conflicts.isEmpty()) {
+		QMessageBox::information(this, tr("Mod Updated"), summary);
+	} else {
+		QMessageBox conflicts{QMessageBox::Warning, tr("Mod Updated"), summary + '\n' + tr("%1 file(s) were modified locally and changed in the template, and were left alone.").arg(report.conflicts.size()), QMessageBox::Ok, this};
+		conflicts.setDetailedText(report.conflicts.join('\n'));
+		conflicts.exec();
+	}
+
+	QDesktopServices::openUrl(QUrl::fromLocalFile(modDir));
+	this->accept();
 }
 
 QString NewModDialog::getModInstallDirParent() const {
@@ -300,14 +354,15 @@ QString NewModDialog::getModInstallDir() const {
 	return this->getModInstallDirParent() + QDir::separator() + this->modID->text().trimmed();
 }
 
-void NewModDialog::open(QString gameRoot, QString downloadURL, QWidget* parent) {
-	auto* dialog = new NewModDialog{std::move(gameRoot), std::move(downloadURL), parent};
+void NewModDialog::open(QString gameRoot, QString downloadURL, QString downloadSHA256, Mode mode, QWidget* parent) {
+	auto* dialog = new NewModDialog{std::move(gameRoot), std::move(downloadURL), std::move(downloadSHA256), mode, parent};
 	dialog->exec();
 	dialog->deleteLater();
 }
 
 void NewModDialog::reject() {
 	if (!this->downloadProgress->isVisible()) {
+		TemplatePrefetch::get()->discard(this->downloadURL);
 		QDialog::reject();
 	}
 }
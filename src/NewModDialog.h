@@ -1,37 +1,52 @@
 #pragma once
 
+#include <functional>
+
 #include <QDialog>
 
 class QCheckBox;
 class QComboBox;
+class QDialogButtonBox;
 class QLineEdit;
-class QNetworkAccessManager;
 class QProgressBar;
 
 class NewModDialog : public QDialog {
 	Q_OBJECT;
 
 public:
-	NewModDialog(QString gameRoot_, QString downloadURL_, QWidget* parent = nullptr);
+	enum class Mode : unsigned char {
+		CREATE,
+		UPDATE,
+	};
+
+	NewModDialog(QString gameRoot_, QString downloadURL_, QString downloadSHA256_, Mode mode_ = Mode::CREATE, QWidget* parent = nullptr);
 
 	[[nodiscard]] QString getModInstallDirParent() const;
 
 	[[nodiscard]] QString getModInstallDir() const;
 
-	static void open(QString gameRoot, QString downloadURL, QWidget* parent = nullptr);
+	static void open(QString gameRoot, QString downloadURL, QString downloadSHA256, Mode mode = Mode::CREATE, QWidget* parent = nullptr);
 
 public Q_SLOTS:
 	void reject() override;
 
 private:
+	void downloadTemplate(std::function<void(const QByteArray&)> onDownloaded);
+
+	void createMod(const QByteArray& zip);
+
+	void updateMod(const QByteArray& zip);
+
 	QString gameRoot;
 	QString downloadURL;
+	QString downloadSHA256;
+	Mode mode;
 
 	QComboBox* parentFolder;
 	QLineEdit* parentFolderCustomPath;
 	QLineEdit* modID;
 	QCheckBox* addShortcutOnDesktop;
+	QLineEdit* modFolder;
+	QDialogButtonBox* buttonBox;
 	QProgressBar* downloadProgress;
-
-	QNetworkAccessManager* network = nullptr;
 };
@@ -8,6 +8,18 @@ constexpr std::string_view STR_GAME_OVERRIDE = "str_game_override";
 constexpr std::string_view BOOL_SINGLE_CLICK_TO_RUN = "opt_single_click_to_run";
 constexpr bool BOOL_SINGLE_CLICK_TO_RUN_DEFAULT = false;
 
+constexpr std::string_view BOOL_SORT_BY_MOST_USED = "opt_sort_by_most_used";
+constexpr bool BOOL_SORT_BY_MOST_USED_DEFAULT = false;
+
+constexpr std::string_view BOOL_PREWARM_GAME_FILES = "opt_prewarm_game_files";
+constexpr bool BOOL_PREWARM_GAME_FILES_DEFAULT = false;
+
+constexpr std::string_view BOOL_COLLECT_CRASH_REPORTS = "opt_collect_crash_reports";
+constexpr bool BOOL_COLLECT_CRASH_REPORTS_DEFAULT = true;
+
+constexpr std::string_view INT_CRASH_REPORTS_BUDGET_MB = "opt_crash_reports_budget_mb";
+constexpr int INT_CRASH_REPORTS_BUDGET_MB_DEFAULT = 2048;
+
 namespace Options {
 
 [[nodiscard]] QSettings& get();
@@ -0,0 +1,302 @@
+#include "PEIcon.h"
+
+#include <algorithm>
+#include <optional>
+
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtConcurrent>
+#include <QtEndian>
+
+namespace {
+
+constexpr quint32 RT_ICON = 3;
+constexpr quint32 RT_GROUP_ICON = 14;
+
+constexpr quint16 PE32_MAGIC = 0x10b;
+constexpr quint16 PE32_PLUS_MAGIC = 0x20b;
+constexpr quint32 RESOURCE_DIRECTORY_INDEX = 2;
+/// ICONDIR followed by a single ICONDIRENTRY
+constexpr quint32 ICO_HEADER_SIZE = 6 + 16;
+
+QMutex g_cacheMutex;
+QHash<QString, QImage> g_cache;
+
+/// Bounds checked little endian reads out of the mapped file
+class PEFile {
+public:
+	explicit PEFile(QByteArrayView data_)
+			: data(data_) {}
+
+	template<typename T>
+	[[nodiscard]] std::optional<T> read(qint64 offset) const {
+		if (offset < 0 || offset + static_cast<qint64>(sizeof(T)) > this->data.size()) {
+			return std::nullopt;
+		}
+		return qFromLittleEndian<T>(this->data.data() + offset);
+	}
+
+	[[nodiscard]] QByteArrayView slice(qint64 offset, qint64 size) const {
+		if (offset < 0 || size < 0 || offset + size > this->data.size()) {
+			return {};
+		}
+		return this->data.sliced(offset, size);
+	}
+
+	/// Finds the section containing the resource directory, and remembers it for resolving RVAs
+	[[nodiscard]] bool parseHeaders() {
+		if (!this->data.startsWith("MZ")) {
+			return false;
+		}
+		const auto peOffset = this->read<quint32>(0x3c);
+		if (!peOffset || this->slice(*peOffset, 4) != QByteArrayView{"PE\0\0", 4}) {
+			return false;
+		}
+		const qint64 coffOffset = *peOffset + 4;
+		const auto sectionCount = this->read<quint16>(coffOffset + 2);
+		const auto optionalHeaderSize = this->read<quint16>(coffOffset + 16);
+		if (!sectionCount || !optionalHeaderSize) {
+			return false;
+		}
+
+		const qint64 optionalHeaderOffset = coffOffset + 20;
+		const auto magic = this->read<quint16>(optionalHeaderOffset);
+		if (!magic || (*magic != PE32_MAGIC && *magic != PE32_PLUS_MAGIC)) {
+			return false;
+		}
+		const qint64 directoryCountOffset = optionalHeaderOffset + (*magic == PE32_PLUS_MAGIC ? 108 : 92);
+		const auto directoryCount = this->read<quint32>(directoryCountOffset);
+		if (!directoryCount || *directoryCount <= RESOURCE_DIRECTORY_INDEX) {
+			return false;
+		}
+		const auto resourceRVA = this->read<quint32>(directoryCountOffset + 4 + RESOURCE_DIRECTORY_INDEX * 8);
+		if (!resourceRVA || *resourceRVA == 0) {
+			return false;
+		}
+
+		this->sectionTableOffset = optionalHeaderOffset + *optionalHeaderSize;
+		this->sectionCount = *sectionCount;
+		const auto resourceOffset = this->rvaToOffset(*resourceRVA);
+		if (!resourceOffset) {
+			return false;
+		}
+		this->resourceOffset = *resourceOffset;
+		return true;
+	}
+
+	[[nodiscard]] std::optional<qint64> rvaToOffset(quint32 rva) const {
+		for (int i = 0; i < this->sectionCount; i++) {
+			const qint64 section = this->sectionTableOffset + i * 40;
+			const auto virtualSize = this->read<quint32>(section + 8);
+			const auto virtualAddress = this->read<quint32>(section + 12);
+			const auto rawSize = this->read<quint32>(section + 16);
+			const auto rawOffset = this->read<quint32>(section + 20);
+			if (!virtualSize || !virtualAddress || !rawSize || !rawOffset) {
+				return std::nullopt;
+			}
+			if (rva >= *virtualAddress && rva < static_cast<qint64>(*virtualAddress) + std::max(*virtualSize, *rawSize)) {
+				return static_cast<qint64>(*rawOffset) + (rva - *virtualAddress);
+			}
+		}
+		return std::nullopt;
+	}
+
+	/// Walks one level of the resource tree. Returns the offset of the matching entry's target relative to the
+	/// resource section, the first ID entry if id is empty. Subdirectories have the high bit of the target set.
+	[[nodiscard]] std::optional<quint32> findResourceEntry(quint32 directory, std::optional<quint32> id) const {
+		const qint64 directoryOffset = this->resourceOffset + directory;
+		const auto namedCount = this->read<quint16>(directoryOffset + 12);
+		const auto idCount = this->read<quint16>(directoryOffset + 14);
+		if (!namedCount || !idCount) {
+			return std::nullopt;
+		}
+		// Named entries come first, icons are always looked up by ID here
+		for (int i = *namedCount; i < *namedCount + *idCount; i++) {
+			const qint64 entry = directoryOffset + 16 + i * 8;
+			const auto entryID = this->read<quint32>(entry);
+			const auto target = this->read<quint32>(entry + 4);
+			if (!entryID || !target) {
+				return std::nullopt;
+			}
+			if (!id || *entryID == *id) {
+				return *target;
+			}
+		}
+		return std::nullopt;
+	}
+
+	/// Resolves type -> name -> first language down to the resource data
+	[[nodiscard]] QByteArrayView findResource(quint32 type, std::optional<quint32> id) const {
+		static constexpr quint32 SUBDIRECTORY = 0x80000000;
+		const auto typeDirectory = this->findResourceEntry(0, type);
+		if (!typeDirectory || !(*typeDirectory & SUBDIRECTORY)) {
+			return {};
+		}
+		const auto nameDirectory = this->findResourceEntry(*typeDirectory & ~SUBDIRECTORY, id);
+		if (!nameDirectory || !(*nameDirectory & SUBDIRECTORY)) {
+			return {};
+		}
+		const auto dataEntry = this->findResourceEntry(*nameDirectory & ~SUBDIRECTORY, std::nullopt);
+		if (!dataEntry || (*dataEntry & SUBDIRECTORY)) {
+			return {};
+		}
+		const auto dataRVA = this->read<quint32>(this->resourceOffset + *dataEntry);
+		const auto dataSize = this->read<quint32>(this->resourceOffset + *dataEntry + 4);
+		if (!dataRVA || !dataSize) {
+			return {};
+		}
+		const auto dataOffset = this->rvaToOffset(*dataRVA);
+		if (!dataOffset) {
+			return {};
+		}
+		return this->slice(*dataOffset, *dataSize);
+	}
+
+private:
+	QByteArrayView data;
+	qint64 sectionTableOffset = 0;
+	int sectionCount = 0;
+	qint64 resourceOffset = 0;
+};
+
+[[nodiscard]] QImage decodeIcon(const PEFile& pe, int size) {
+	// The group lists every image of the icon, pick the smallest one at least as big as requested
+	const auto group = pe.findResource(RT_GROUP_ICON, std::nullopt);
+	if (group.size() < 6) {
+		return {};
+	}
+	const PEFile groupReader{group};
+	const auto count = *groupReader.read<quint16>(4);
+
+	qint64 bestEntry = -1;
+	int bestWidth = 0;
+	int bestBitCount = 0;
+	for (int i = 0; i < count; i++) {
+		const qint64 entry = 6 + i * 14;
+		const auto width = groupReader.read<quint8>(entry);
+		const auto bitCount = groupReader.read<quint16>(entry + 6);
+		if (!width || !bitCount) {
+			break;
+		}
+		const int w = *width == 0 ? 256 : *width;
+		const bool better = bestEntry < 0
+				|| (bestWidth < size && w > bestWidth)
+				|| (w >= size && w < bestWidth)
+				|| (w == bestWidth && *bitCount > bestBitCount);
+		if (better) {
+			bestEntry = entry;
+			bestWidth = w;
+			bestBitCount = *bitCount;
+		}
+	}
+	if (bestEntry < 0) {
+		return {};
+	}
+
+	const auto iconID = groupReader.read<quint16>(bestEntry + 12);
+	const auto image = iconID ? pe.findResource(RT_ICON, *iconID) : QByteArrayView{};
+	if (image.isEmpty()) {
+		return {};
+	}
+
+	QImage out;
+	if (image.startsWith("\x89PNG")) {
+		out = QImage::fromData(image, "PNG");
+	} else {
+		// Wrap the bitmap in a single image ICO so Qt can decode it
+		QByteArray ico;
+		ico.reserve(ICO_HEADER_SIZE + image.size());
+		QBuffer buffer{&ico};
+		buffer.open(QIODevice::WriteOnly);
+		const auto write = [&buffer]<typename T>(T value) {
+			value = qToLittleEndian(value);
+			buffer.write(reinterpret_cast<const char*>(&value), sizeof(T));
+		};
+		write(quint16{0});
+		write(quint16{1});
+		write(quint16{1});
+		// The group entry is an ICONDIRENTRY (size included) with the resource ID in place of the image offset
+		buffer.write(group.sliced(bestEntry, 12).data(), 12);
+		write(ICO_HEADER_SIZE);
+		// The image has to start exactly where the offset says, or Qt rejects every bitmap icon
+		Q_ASSERT(buffer.pos() == ICO_HEADER_SIZE);
+		buffer.write(image.data(), image.size());
+		buffer.close();
+		out = QImage::fromData(ico, "ICO");
+	}
+	if (!out.isNull() && (out.width() > size || out.height() > size)) {
+		out = out.scaled(size, size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+	}
+	return out;
+}
+
+[[nodiscard]] QString getDiskCachePath(const QString& key) {
+	const auto hash = QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1).toHex();
+	return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QDir::separator() + "icons" + QDir::separator() + hash + ".png";
+}
+
+} // namespace
+
+QImage PEIcon::read(const QString& path, int size) {
+	QFile file{path};
+	if (!file.open(QIODevice::ReadOnly) || file.size() <= 0) {
+		return {};
+	}
+	const auto* mapped = file.map(0, file.size());
+	if (!mapped) {
+		return {};
+	}
+	PEFile pe{QByteArrayView{mapped, file.size()}};
+	if (!pe.parseHeaders()) {
+		return {};
+	}
+	return ::decodeIcon(pe, size);
+}
+
+QImage PEIcon::get(const QString& path, int size) {
+	const QFileInfo info{path};
+	if (!info.isFile()) {
+		return {};
+	}
+	const auto key = QString("%1|%2|%3|%4").arg(info.absoluteFilePath()).arg(info.lastModified().toMSecsSinceEpoch()).arg(info.size()).arg(size);
+	{
+		const QMutexLocker lock{&g_cacheMutex};
+		if (const auto it = g_cache.constFind(key); it != g_cache.constEnd()) {
+			return *it;
+		}
+	}
+
+	// An empty file on disk means the executable has no usable icon
+	QImage image;
+	const auto diskCachePath = ::getDiskCachePath(key);
+	if (QFile cached{diskCachePath}; cached.open(QIODevice::ReadOnly)) {
+		if (cached.size() > 0) {
+			image.loadFromData(cached.readAll(), "PNG");
+		}
+	} else {
+		image = PEIcon::read(path, size);
+		(void) QDir{}.mkpath(QFileInfo{diskCachePath}.absolutePath());
+		if (QSaveFile out{diskCachePath}; out.open(QIODevice::WriteOnly)) {
+			if (!image.isNull()) {
+				image.save(&out, "PNG");
+			}
+			(void) out.commit();
+		}
+	}
+
+	const QMutexLocker lock{&g_cacheMutex};
+	g_cache.insert(key, image);
+	return image;
+}
+
+QFuture<QImage> PEIcon::getAsync(const QString& path, int size) {
+	return QtConcurrent::run(&PEIcon::get, path, size);
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <QFuture>
+#include <QImage>
+#include <QString>
+
+/// Reads icons out of the resources of Windows executables, on any platform
+namespace PEIcon {
+
+/// Maps the file and decodes the image of its first icon group closest to the given size.
+/// Only the headers and the resources that are needed get paged in. Returns a null image on failure.
+[[nodiscard]] QImage read(const QString& path, int size);
+
+/// Like read, but cached in memory and on disk, keyed by the path, the file's timestamp and size
+[[nodiscard]] QImage get(const QString& path, int size);
+
+/// Runs get on a background thread
+[[nodiscard]] QFuture<QImage> getAsync(const QString& path, int size);
+
+} // namespace PEIcon
@@ -0,0 +1,104 @@
+#include "Prewarm.h"
+
+#include <algorithm>
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QSet>
+#include <QThreadPool>
+
+#ifdef __linux__
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+namespace {
+
+QMutex g_warmedMutex;
+QSet<QString> g_warmed;
+
+[[nodiscard]] QThreadPool& getPrewarmPool() {
+	// One thread, so requests queue up instead of fighting over the disk
+	static auto* pool = [] {
+		auto* p = new QThreadPool;
+		p->setMaxThreadCount(1);
+		return p;
+	}();
+	return *pool;
+}
+
+/// Returns the number of bytes requested
+[[nodiscard]] qint64 warmFile(const QFileInfo& info, qint64 budget) {
+	const auto size = std::min(info.size(), budget);
+	if (size <= 0) {
+		return 0;
+	}
+#ifdef __linux__
+	const int fd = ::open(QFile::encodeName(info.absoluteFilePath()).constData(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return 0;
+	}
+	// readahead blocks until the pages are queued, which keeps the budget honest
+	if (::readahead(fd, 0, static_cast<size_t>(size)) != 0) {
+		::posix_fadvise(fd, 0, size, POSIX_FADV_WILLNEED);
+	}
+	::close(fd);
+	return size;
+#else
+	QFile file{info.absoluteFilePath()};
+	if (!file.open(QIODevice::ReadOnly)) {
+		return 0;
+	}
+	static constexpr qint64 CHUNK_SIZE = 1024 * 1024;
+	QByteArray buffer(CHUNK_SIZE, Qt::Uninitialized);
+	qint64 read = 0;
+	while (read < size) {
+		const auto chunk = file.read(buffer.data(), std::min(CHUNK_SIZE, size - read));
+		if (chunk <= 0) {
+			break;
+		}
+		read += chunk;
+	}
+	return read;
+#endif
+}
+
+[[nodiscard]] QFileInfoList expandGlob(const QString& glob) {
+	const QFileInfo info{glob};
+	return QDir{info.absolutePath()}.entryInfoList({info.fileName()}, QDir::Files | QDir::Readable);
+}
+
+} // namespace
+
+void Prewarm::request(const QStringList& directories, const QStringList& globs, int budgetMB) {
+	if (budgetMB <= 0 || (directories.isEmpty() && globs.isEmpty())) {
+		return;
+	}
+	::getPrewarmPool().start([directories, globs, budget = static_cast<qint64>(budgetMB) * 1024 * 1024]() mutable {
+		QFileInfoList files;
+		for (const auto& directory : directories) {
+			files += QDir{directory}.entryInfoList(QDir::Files | QDir::Readable);
+		}
+		for (const auto& glob : globs) {
+			files += ::expandGlob(glob);
+		}
+
+		for (const auto& file : files) {
+			if (budget <= 0) {
+				break;
+			}
+			const auto key = file.absoluteFilePath() + '@' + QString::number(file.lastModified().toMSecsSinceEpoch());
+			{
+				QMutexLocker lock{&g_warmedMutex};
+				if (g_warmed.contains(key)) {
+					continue;
+				}
+				g_warmed.insert(key);
+			}
+			budget -= ::warmFile(file, budget);
+		}
+	});
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <QStringList>
+
+namespace Prewarm {
+
+/// Pulls the files in the given directories and the files matching the given globs into the OS page cache.
+/// Runs on a background thread, and stops after reading budgetMB megabytes. Files are only warmed once per session.
+void request(const QStringList& directories, const QStringList& globs, int budgetMB);
+
+} // namespace Prewarm
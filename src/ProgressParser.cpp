@@ -0,0 +1,73 @@
+#include "ProgressParser.h"
+
+#include <algorithm>
+
+ProgressParser::ProgressParser(const QString& pattern_, int max_, const QString& phasePattern_)
+		: pattern(pattern_)
+		, phasePattern(phasePattern_)
+		, max(std::max(max_, 1)) {}
+
+bool ProgressParser::isValid() const {
+	return !this->pattern.pattern().isEmpty() && this->pattern.isValid() && (this->phasePattern.pattern().isEmpty() || this->phasePattern.isValid());
+}
+
+bool ProgressParser::feed(QStringView output) {
+	if (!this->isValid()) {
+		return false;
+	}
+	this->line += output;
+
+	bool changed = false;
+	while (true) {
+		const auto end = std::find_if(this->line.cbegin(), this->line.cend(), [](QChar c) { return c == '\n' || c == '\r'; }) - this->line.cbegin();
+		const auto segment = QStringView{this->line}.first(end);
+
+		// Phase names come before the progress printed on the same line, so they're looked for first
+		if (!this->linePhaseChecked && !this->phasePattern.pattern().isEmpty()) {
+			if (const auto match = this->phasePattern.matchView(segment); match.hasMatch()) {
+				this->phase = (this->phasePattern.captureCount() > 0 ? match.captured(1) : match.captured(0)).trimmed();
+				this->value = 0;
+				this->lineMatched = std::max(this->lineMatched, match.capturedEnd(0));
+				this->linePhaseChecked = true;
+				changed = true;
+			}
+		}
+
+		// Only new output is matched, so a tick is never counted twice
+		const auto matchedBefore = this->lineMatched;
+		auto matches = this->pattern.globalMatchView(segment.sliced(matchedBefore));
+		while (matches.hasNext()) {
+			const auto match = matches.next();
+			this->lineMatched = matchedBefore + match.capturedEnd(0);
+			int newValue = this->value + 1;
+			if (this->pattern.captureCount() > 0) {
+				bool ok = false;
+				newValue = match.capturedView(1).toInt(&ok);
+				if (!ok) {
+					continue;
+				}
+			}
+			newValue = std::clamp(newValue, 0, this->max);
+			changed = changed || newValue != this->value;
+			this->value = newValue;
+		}
+
+		if (end == this->line.size()) {
+			break;
+		}
+		this->line.remove(0, end + 1);
+		this->lineMatched = 0;
+		this->linePhaseChecked = false;
+	}
+
+	// Tools that never print a newline would otherwise grow this forever
+	if (this->line.size() > MAX_PENDING_LINE) {
+		this->line.clear();
+		this->lineMatched = 0;
+	}
+	return changed;
+}
+
+double ProgressParser::getFraction() const {
+	return static_cast<double>(this->value) / static_cast<double>(this->max);
+}
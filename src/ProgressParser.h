@@ -0,0 +1,45 @@
+#pragma once
+
+#include <QRegularExpression>
+#include <QString>
+#include <QStringView>
+
+/// Pulls progress out of a tool's console output as it arrives. Output doesn't have to arrive in whole lines,
+/// tools like vvis print "0...1...2..." a tick at a time on the same line.
+class ProgressParser {
+public:
+	/// If the progress pattern has a capture group it holds the current value, otherwise every match counts as one step.
+	/// A line matching the phase pattern starts a new phase and resets the progress, its first capture group (or the
+	/// whole match) names the phase.
+	ProgressParser(const QString& pattern, int max, const QString& phasePattern = {});
+
+	[[nodiscard]] bool isValid() const;
+
+	/// Returns true if the phase or progress changed
+	bool feed(QStringView output);
+
+	[[nodiscard]] const QString& getPhase() const { return this->phase; }
+
+	[[nodiscard]] int getValue() const { return this->value; }
+
+	[[nodiscard]] int getMax() const { return this->max; }
+
+	/// Progress through the current phase, from 0 to 1
+	[[nodiscard]] double getFraction() const;
+
+private:
+	/// Output that doesn't end in a newline is only kept up to this long
+	static constexpr qsizetype MAX_PENDING_LINE = 64 * 1024;
+
+	QRegularExpression pattern;
+	QRegularExpression phasePattern;
+	int max;
+
+	QString phase;
+	int value = 0;
+
+	/// The line being printed, and how much of it was already matched
+	QString line;
+	qsizetype lineMatched = 0;
+	bool linePhaseChecked = false;
+};
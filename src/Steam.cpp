@@ -1,6 +1,11 @@
 #include "Steam.h"
 
 #include <filesystem>
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFileInfo>
+
 #ifdef _WIN32
 	#include <memory>
 	#include <Windows.h>
@@ -11,7 +16,7 @@
 namespace {
 
 /// Copied from sourcepp
-[[nodiscard]] QString getSourceModsDirHelper() {
+[[nodiscard]] QString getSteamDirHelper() {
 	std::filesystem::path steamLocation;
 	std::error_code ec;
 
@@ -91,15 +96,44 @@ namespace {
 	}
 #endif
 
-	if (const auto sourceModPath = (steamLocation / "steamapps" / "sourcemods").string(); std::filesystem::exists(sourceModPath, ec)) {
-		return sourceModPath.c_str();
+	if (!std::filesystem::exists(steamLocation, ec)) {
+		return "";
+	}
+	return QString::fromStdU16String(steamLocation.u16string());
+}
+
+[[nodiscard]] QString getSourceModsDirHelper() {
+	const auto& steamDir = getSteamDir();
+	if (steamDir.isEmpty()) {
+		return "";
+	}
+	if (const auto sourceModPath = QDir::toNativeSeparators(steamDir + "/steamapps/sourcemods"); QFileInfo{sourceModPath}.isDir()) {
+		return sourceModPath;
 	}
 	return "";
 }
 
 } // namespace
 
+const QString& getSteamDir() {
+	static QString location = ::getSteamDirHelper();
+	return location;
+}
+
 const QString& getSourceModsDir() {
 	static QString location = ::getSourceModsDirHelper();
 	return location;
 }
+
+QString getRootPath(bool usesLegacyBinDir) {
+	QString rootPath = QCoreApplication::applicationDirPath();
+	if (usesLegacyBinDir) {
+		rootPath += "/..";
+	} else {
+		rootPath += "/../..";
+	}
+	if (auto cleanPath = QDir::cleanPath(rootPath); !cleanPath.isEmpty()) {
+		return cleanPath;
+	}
+	return rootPath;
+}
@@ -2,4 +2,9 @@
 
 #include <QString>
 
+[[nodiscard]] const QString& getSteamDir();
+
 [[nodiscard]] const QString& getSourceModsDir();
+
+/// The game's root dir, relative to where the launcher is installed (one level further up unless the config uses the legacy bin dir)
+[[nodiscard]] QString getRootPath(bool usesLegacyBinDir);
@@ -0,0 +1,254 @@
+#include "SteamIndex.h"
+
+#include <algorithm>
+#include <utility>
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtConcurrent>
+
+#include "KeyValues.h"
+
+namespace {
+
+constexpr quint32 CACHE_MAGIC = 0x53544958; // STIX
+constexpr quint32 CACHE_VERSION = 1;
+
+#ifdef _WIN32
+constexpr auto PATH_CASE_SENSITIVITY = Qt::CaseInsensitive;
+#else
+constexpr auto PATH_CASE_SENSITIVITY = Qt::CaseSensitive;
+#endif
+
+[[nodiscard]] qint64 getModified(const QFileInfo& info) {
+	return info.exists() ? info.lastModified().toMSecsSinceEpoch() : 0;
+}
+
+[[nodiscard]] QString cleanPath(const QString& path) {
+	return QDir::cleanPath(QDir::fromNativeSeparators(path));
+}
+
+[[nodiscard]] std::optional<KeyValues::Element> readKeyValues(const QString& path) {
+	QFile file{path};
+	if (!file.open(QIODevice::ReadOnly)) {
+		return std::nullopt;
+	}
+	return KeyValues::parse(file.readAll());
+}
+
+[[nodiscard]] QStringList readLibraryFolders(const QString& steamDir) {
+	// The Steam directory is always a library, even if libraryfolders.vdf is missing
+	QStringList libraries{::cleanPath(steamDir)};
+
+	const auto libraryFolders = ::readKeyValues(steamDir + "/steamapps/libraryfolders.vdf");
+	if (!libraryFolders) {
+		return libraries;
+	}
+	const auto* root = libraryFolders->find(u"libraryfolders");
+	if (!root) {
+		return libraries;
+	}
+	for (const auto& library : root->children) {
+		bool isLibrary = false;
+		(void) library.key.toInt(&isLibrary);
+		// Newer files have an object per library, older ones map the number straight to the path
+		const auto path = ::cleanPath(library.children.empty() ? library.value : library.get(u"path"));
+		if (isLibrary && !path.isEmpty() && !libraries.contains(path, PATH_CASE_SENSITIVITY)) {
+			libraries.push_back(path);
+		}
+	}
+	return libraries;
+}
+
+[[nodiscard]] SteamIndex::Game readGame(const QString& manifestPath, const QString& library) {
+	SteamIndex::Game game;
+	game.manifestPath = manifestPath;
+	game.manifestModified = ::getModified(QFileInfo{manifestPath});
+
+	const auto manifest = ::readKeyValues(manifestPath);
+	const auto* appState = manifest ? manifest->find(u"AppState") : nullptr;
+	if (!appState) {
+		return game;
+	}
+	game.appID = appState->get(u"appid");
+	game.name = appState->get(u"name");
+	if (const auto installDir = appState->get(u"installdir"); !installDir.isEmpty()) {
+		game.installDir = library + "/steamapps/common/" + installDir;
+	}
+	if (game.installDir.isEmpty()) {
+		return game;
+	}
+
+	for (const auto& dir : QDir{game.installDir}.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+		if (QFileInfo::exists(dir.absoluteFilePath() + "/gameinfo.txt")) {
+			game.gameFolders.push_back(dir.fileName());
+		}
+	}
+	return game;
+}
+
+[[nodiscard]] SteamIndex::SourceMod readSourceMod(const QString& path) {
+	SteamIndex::SourceMod mod;
+	mod.folder = QFileInfo{path}.fileName();
+	mod.path = path;
+	mod.name = mod.folder;
+
+	const QString gameInfoPath = path + "/gameinfo.txt";
+	mod.gameInfoModified = ::getModified(QFileInfo{gameInfoPath});
+
+	const auto gameInfo = ::readKeyValues(gameInfoPath);
+	const auto* root = gameInfo ? gameInfo->find(u"GameInfo") : nullptr;
+	if (!root) {
+		return mod;
+	}
+	if (auto name = root->get(u"game"); !name.isEmpty()) {
+		mod.name = std::move(name);
+	}
+	if (const auto* fileSystem = root->find(u"FileSystem")) {
+		mod.steamAppID = fileSystem->get(u"SteamAppId");
+	}
+	return mod;
+}
+
+void writeCache(const QString& cachePath, const SteamIndex::Index& index) {
+	(void) QDir{}.mkpath(QFileInfo{cachePath}.absolutePath());
+	QSaveFile file{cachePath};
+	if (!file.open(QIODevice::WriteOnly)) {
+		return;
+	}
+	QDataStream out{&file};
+	out << CACHE_MAGIC << CACHE_VERSION << index.steamDir << index.libraryFoldersModified << index.libraries;
+	out << static_cast<qint64>(index.games.size());
+	for (const auto& game : index.games) {
+		out << game.appID << game.name << game.installDir << game.gameFolders << game.manifestPath << game.manifestModified;
+	}
+	out << static_cast<qint64>(index.sourceMods.size());
+	for (const auto& mod : index.sourceMods) {
+		out << mod.folder << mod.path << mod.name << mod.steamAppID << mod.gameInfoModified;
+	}
+	(void) file.commit();
+}
+
+} // namespace
+
+const SteamIndex::Game* SteamIndex::Index::findGameByInstallDir(const QString& installDir) const {
+	const auto path = ::cleanPath(installDir);
+	for (const auto& game : this->games) {
+		if (::cleanPath(game.installDir).compare(path, PATH_CASE_SENSITIVITY) == 0) {
+			return &game;
+		}
+	}
+	return nullptr;
+}
+
+QString SteamIndex::getDefaultCachePath() {
+	return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QDir::separator() + "steam_index.bin";
+}
+
+std::optional<SteamIndex::Index> SteamIndex::load(const QString& steamDir, const QString& cachePath) {
+	QFile file{cachePath};
+	if (!file.open(QIODevice::ReadOnly)) {
+		return std::nullopt;
+	}
+	QDataStream in{&file};
+	quint32 magic, version;
+	Index index;
+	in >> magic >> version >> index.steamDir >> index.libraryFoldersModified >> index.libraries;
+	if (in.status() != QDataStream::Ok || magic != CACHE_MAGIC || version != CACHE_VERSION || index.steamDir != steamDir) {
+		return std::nullopt;
+	}
+
+	qint64 count;
+	in >> count;
+	for (qint64 i = 0; i < count && in.status() == QDataStream::Ok; i++) {
+		auto& game = index.games.emplace_back();
+		in >> game.appID >> game.name >> game.installDir >> game.gameFolders >> game.manifestPath >> game.manifestModified;
+	}
+	in >> count;
+	for (qint64 i = 0; i < count && in.status() == QDataStream::Ok; i++) {
+		auto& mod = index.sourceMods.emplace_back();
+		in >> mod.folder >> mod.path >> mod.name >> mod.steamAppID >> mod.gameInfoModified;
+	}
+	if (in.status() != QDataStream::Ok) {
+		return std::nullopt;
+	}
+	return index;
+}
+
+SteamIndex::Index SteamIndex::update(const QString& steamDir, const std::optional<Index>& previous, const QString& cachePath) {
+	Index index;
+	index.steamDir = steamDir;
+
+	const bool previousValid = previous && previous->steamDir == steamDir;
+
+	index.libraryFoldersModified = ::getModified(QFileInfo{steamDir + "/steamapps/libraryfolders.vdf"});
+	if (previousValid && index.libraryFoldersModified != 0 && previous->libraryFoldersModified == index.libraryFoldersModified) {
+		index.libraries = previous->libraries;
+	} else {
+		index.libraries = ::readLibraryFolders(steamDir);
+	}
+
+	// Listing directories and checking timestamps is cheap, only changed files get parsed
+	QHash<QString, const Game*> previousGames;
+	QHash<QString, const SourceMod*> previousSourceMods;
+	if (previousValid) {
+		for (const auto& game : previous->games) {
+			previousGames.insert(game.manifestPath, &game);
+		}
+		for (const auto& mod : previous->sourceMods) {
+			previousSourceMods.insert(mod.path, &mod);
+		}
+	}
+
+	QList<std::pair<QString, QString>> staleManifests;
+	for (const auto& library : index.libraries) {
+		for (const auto& manifest : QDir{library + "/steamapps"}.entryInfoList({"appmanifest_*.acf"}, QDir::Files)) {
+			const auto manifestPath = manifest.absoluteFilePath();
+			if (const auto* cached = previousGames.value(manifestPath); cached && cached->manifestModified == ::getModified(manifest)) {
+				index.games.push_back(*cached);
+			} else {
+				staleManifests.emplace_back(manifestPath, library);
+			}
+		}
+	}
+
+	QStringList staleSourceMods;
+	for (const auto& dir : QDir{steamDir + "/steamapps/sourcemods"}.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+		const QFileInfo gameInfo{dir.absoluteFilePath() + "/gameinfo.txt"};
+		if (!gameInfo.isFile()) {
+			continue;
+		}
+		if (const auto* cached = previousSourceMods.value(dir.absoluteFilePath()); cached && cached->gameInfoModified == ::getModified(gameInfo)) {
+			index.sourceMods.push_back(*cached);
+		} else {
+			staleSourceMods.push_back(dir.absoluteFilePath());
+		}
+	}
+
+	index.games += QtConcurrent::blockingMapped<QList<Game>>(staleManifests, [](const std::pair<QString, QString>& manifest) {
+		return ::readGame(manifest.first, manifest.second);
+	});
+	index.sourceMods += QtConcurrent::blockingMapped<QList<SourceMod>>(staleSourceMods, &::readSourceMod);
+
+	// Manifests that failed to parse are kept out so they get another try next time
+	index.games.removeIf([](const Game& game) {
+		return game.appID.isEmpty() || game.installDir.isEmpty();
+	});
+	std::sort(index.games.begin(), index.games.end(), [](const Game& lhs, const Game& rhs) {
+		return lhs.name.compare(rhs.name, Qt::CaseInsensitive) < 0;
+	});
+	std::sort(index.sourceMods.begin(), index.sourceMods.end(), [](const SourceMod& lhs, const SourceMod& rhs) {
+		return lhs.name.compare(rhs.name, Qt::CaseInsensitive) < 0;
+	});
+
+	if (!cachePath.isEmpty()) {
+		::writeCache(cachePath, index);
+	}
+	return index;
+}
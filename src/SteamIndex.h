@@ -0,0 +1,51 @@
+#pragma once
+
+#include <optional>
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+/// Installed Steam games and sourcemods, from libraryfolders.vdf, appmanifest_*.acf and gameinfo.txt.
+/// Everything takes the Steam directory as a parameter, so it can be pointed at a fake Steam tree.
+namespace SteamIndex {
+
+struct Game {
+	QString appID;
+	QString name;
+	QString installDir;
+	/// Folders in the install directory that have a gameinfo.txt, i.e. valid ${GAME} values
+	QStringList gameFolders;
+	QString manifestPath;
+	qint64 manifestModified = 0;
+};
+
+struct SourceMod {
+	QString folder;
+	QString path;
+	QString name;
+	QString steamAppID;
+	qint64 gameInfoModified = 0;
+};
+
+struct Index {
+	QString steamDir;
+	qint64 libraryFoldersModified = 0;
+	QStringList libraries;
+	QList<Game> games;
+	QList<SourceMod> sourceMods;
+
+	/// Returns the installed game at the given path, if there is one
+	[[nodiscard]] const Game* findGameByInstallDir(const QString& installDir) const;
+};
+
+[[nodiscard]] QString getDefaultCachePath();
+
+/// Reads the cached index without touching the Steam directory, returns nothing if the cache is for another Steam install
+[[nodiscard]] std::optional<Index> load(const QString& steamDir, const QString& cachePath = getDefaultCachePath());
+
+/// Revalidates the previous index against the disk and saves it to the cache if a path is given.
+/// Only files with changed timestamps are parsed again, and those are parsed in parallel.
+[[nodiscard]] Index update(const QString& steamDir, const std::optional<Index>& previous, const QString& cachePath = getDefaultCachePath());
+
+} // namespace SteamIndex
@@ -0,0 +1,165 @@
+#include "TemplatePrefetch.h"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QStringList>
+#include <QTemporaryFile>
+
+struct TemplatePrefetch::Transfer {
+	QNetworkReply* reply = nullptr;
+	QTemporaryFile spool;
+	QCryptographicHash hash{QCryptographicHash::Sha256};
+	qint64 received = 0;
+	qint64 total = -1;
+	bool attached = false;
+	bool done = false;
+	QString error;
+};
+
+TemplatePrefetch* TemplatePrefetch::get() {
+	// Parented to the application so the spool files are cleaned up on exit
+	static auto* instance = new TemplatePrefetch{QCoreApplication::instance()};
+	return instance;
+}
+
+TemplatePrefetch::TemplatePrefetch(QObject* parent)
+		: QObject(parent)
+		, network(new QNetworkAccessManager{this}) {}
+
+void TemplatePrefetch::prefetch(const QString& url) {
+	if (url.isEmpty()) {
+		return;
+	}
+	QStringList abandoned;
+	for (const auto& [otherURL, transfer] : this->transfers.asKeyValueRange()) {
+		if (otherURL != url && !transfer->attached && !transfer->done) {
+			abandoned.push_back(otherURL);
+		}
+	}
+	for (const auto& otherURL : abandoned) {
+		this->abort(otherURL);
+	}
+	if (!this->transfers.contains(url)) {
+		this->start(url);
+	}
+}
+
+void TemplatePrefetch::attach(const QString& url) {
+	// A speculative transfer that failed is retried, the user may have fixed their connection since
+	if (const auto it = this->transfers.constFind(url); it != this->transfers.constEnd() && (*it)->done && !(*it)->error.isEmpty()) {
+		this->transfers.erase(it);
+	}
+	if (!this->transfers.contains(url)) {
+		this->start(url);
+	}
+	const auto transfer = this->transfers[url];
+	transfer->attached = true;
+
+	// Queued, so whoever is attaching has a chance to connect first. If the transfer is still running,
+	// finished() comes from the reply instead.
+	QMetaObject::invokeMethod(this, [this, url, transfer, wasDone = transfer->done] {
+		if (this->transfers.value(url) != transfer) {
+			return;
+		}
+		emit this->progress(url, transfer->received, transfer->total);
+		if (wasDone) {
+			emit this->finished(url);
+		}
+	}, Qt::QueuedConnection);
+}
+
+TemplatePrefetch::Result TemplatePrefetch::take(const QString& url) {
+	const auto transfer = this->transfers.take(url);
+	if (!transfer || !transfer->done) {
+		if (transfer && transfer->reply) {
+			transfer->reply->abort();
+		}
+		return {{}, {}, tr("The download was cancelled.")};
+	}
+	if (!transfer->error.isEmpty()) {
+		return {{}, {}, transfer->error};
+	}
+	if (!transfer->spool.seek(0)) {
+		return {{}, {}, tr("Could not read the downloaded file.")};
+	}
+	return {transfer->spool.readAll(), transfer->hash.result(), {}};
+}
+
+void TemplatePrefetch::discard(const QString& url) {
+	if (const auto transfer = this->transfers.value(url); transfer && !transfer->done) {
+		this->abort(url);
+	} else if (transfer) {
+		transfer->attached = false;
+	}
+}
+
+void TemplatePrefetch::start(const QString& url) {
+	auto transfer = std::make_shared<Transfer>();
+	if (!transfer->spool.open()) {
+		transfer->done = true;
+		transfer->error = tr("Could not create a temporary file to download into.");
+		this->transfers[url] = std::move(transfer);
+		return;
+	}
+	auto* reply = this->network->get(QNetworkRequest{QUrl(url)});
+	transfer->reply = reply;
+	this->transfers[url] = transfer;
+
+	// Spool and hash the template as it arrives, so checking the pinned checksum doesn't need another pass
+	const auto write = [transfer](const QByteArray& chunk) {
+		transfer->hash.addData(chunk);
+		transfer->received += chunk.size();
+		return transfer->spool.write(chunk) == chunk.size();
+	};
+	QObject::connect(reply, &QNetworkReply::readyRead, this, [this, url, transfer, reply, write] {
+		if (!write(reply->readAll())) {
+			transfer->error = tr("Could not write the download to a temporary file.");
+			reply->abort();
+			return;
+		}
+		if (!transfer->attached && transfer->received > MAX_SPOOL_SIZE) {
+			this->abort(url);
+		}
+	});
+	QObject::connect(reply, &QNetworkReply::downloadProgress, this, [this, url, transfer](qint64 received, qint64 total) {
+		transfer->total = total;
+		// Don't bother speculating on templates that are too big to be worth holding on to
+		if (!transfer->attached && total > MAX_SPOOL_SIZE) {
+			this->abort(url);
+			return;
+		}
+		if (transfer->attached) {
+			emit this->progress(url, received, total);
+		}
+	});
+	QObject::connect(reply, &QNetworkReply::finished, this, [this, url, transfer, reply, write] {
+		reply->deleteLater();
+		transfer->reply = nullptr;
+		transfer->done = true;
+		if (this->transfers.value(url) != transfer) {
+			// Aborted
+			return;
+		}
+		if (transfer->error.isEmpty() && reply->error() != QNetworkReply::NoError) {
+			transfer->error = reply->errorString();
+		} else if (const auto chunk = reply->readAll(); transfer->error.isEmpty() && !chunk.isEmpty() && !write(chunk)) {
+			transfer->error = tr("Could not write the download to a temporary file.");
+		}
+		if (!transfer->attached && !transfer->error.isEmpty()) {
+			this->transfers.remove(url);
+			return;
+		}
+		if (transfer->attached) {
+			emit this->finished(url);
+		}
+	});
+}
+
+void TemplatePrefetch::abort(const QString& url) {
+	// Removed first, so the finished handler knows nobody wants this transfer anymore
+	if (const auto transfer = this->transfers.take(url); transfer && transfer->reply) {
+		transfer->reply->abort();
+	}
+}
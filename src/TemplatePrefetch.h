@@ -0,0 +1,59 @@
+#pragma once
+
+#include <memory>
+
+#include <QHash>
+#include <QObject>
+
+class QNetworkAccessManager;
+
+/// Downloads mod templates speculatively, as soon as it looks like one is about to be used.
+/// Transfers are spooled to a temporary file and hashed as they arrive, so NewModDialog can attach to an
+/// in-flight or finished transfer instead of starting the download after OK is pressed.
+class TemplatePrefetch : public QObject {
+	Q_OBJECT;
+
+public:
+	/// Speculative transfers that grow past this are dropped, unless something is waiting on them
+	static constexpr qint64 MAX_SPOOL_SIZE = 256 * 1024 * 1024;
+
+	struct Result {
+		QByteArray data;
+		QByteArray sha256;
+		QString error;
+	};
+
+	/// Shared by the whole application, so hovering a menu entry and opening the dialog use the same transfer
+	[[nodiscard]] static TemplatePrefetch* get();
+
+	/// Starts downloading the template in the background if it isn't already.
+	/// Only one speculative transfer runs at a time, other ones nobody is waiting on are aborted.
+	void prefetch(const QString& url);
+
+	/// Marks the template as needed and starts it if it wasn't prefetched. progress() is emitted right away with
+	/// the current state, and finished() is emitted once the transfer is done, even if it already was.
+	void attach(const QString& url);
+
+	/// Hands over the finished transfer and forgets about it
+	[[nodiscard]] Result take(const QString& url);
+
+	/// Aborts the transfer if it's still running. Finished transfers are kept, they're under the size cap.
+	void discard(const QString& url);
+
+signals:
+	void progress(const QString& url, qint64 received, qint64 total);
+
+	void finished(const QString& url);
+
+private:
+	struct Transfer;
+
+	explicit TemplatePrefetch(QObject* parent = nullptr);
+
+	void start(const QString& url);
+
+	void abort(const QString& url);
+
+	QNetworkAccessManager* network;
+	QHash<QString, std::shared_ptr<Transfer>> transfers;
+};
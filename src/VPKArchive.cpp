@@ -0,0 +1,474 @@
+#include "VPKArchive.h"
+
+#include <algorithm>
+
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QtEndian>
+
+#include <miniz.h>
+
+namespace {
+
+constexpr quint32 VPK_SIGNATURE = 0x55aa1234;
+constexpr qint64 V1_HEADER_SIZE = 12;
+constexpr qint64 V2_HEADER_SIZE = 28;
+
+/// CRC-32, preload size, archive index, offset, size and terminator
+constexpr qint64 ENTRY_SIZE = 18;
+constexpr quint16 ENTRY_TERMINATOR = 0xffff;
+
+/// The tree stores a single space for the root directory and for files without an extension
+constexpr QByteArrayView EMPTY_FIELD{" "};
+
+constexpr QLatin1StringView DIR_SUFFIX{"_dir.vpk"};
+
+/// Real archives are a handful of folders deep, anything past this is a damaged or hostile tree
+constexpr qsizetype MAX_DIRECTORY_DEPTH = 64;
+
+template<typename T>
+[[nodiscard]] std::optional<T> read(QByteArrayView data, qint64 offset) {
+	if (offset < 0 || offset + static_cast<qint64>(sizeof(T)) > data.size()) {
+		return std::nullopt;
+	}
+	return qFromLittleEndian<T>(data.data() + offset);
+}
+
+/// Returns a view of the null terminated string at the offset, and moves the offset past it
+[[nodiscard]] std::optional<QByteArrayView> readString(QByteArrayView data, qint64& offset) {
+	const auto end = data.indexOf('\0', offset);
+	if (end < 0) {
+		return std::nullopt;
+	}
+	const auto string = data.sliced(offset, end - offset);
+	offset = end + 1;
+	return string;
+}
+
+// Game content is looked up without regard to case, but only ASCII is folded so hashing and comparing always agree
+
+[[nodiscard]] constexpr char toLower(char c) {
+	return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+[[nodiscard]] int compareIgnoringCase(QByteArrayView lhs, QByteArrayView rhs) {
+	const auto size = std::min(lhs.size(), rhs.size());
+	for (qsizetype i = 0; i < size; i++) {
+		if (const auto l = static_cast<uchar>(::toLower(lhs[i])), r = static_cast<uchar>(::toLower(rhs[i])); l != r) {
+			return l < r ? -1 : 1;
+		}
+	}
+	return lhs.size() == rhs.size() ? 0 : (lhs.size() < rhs.size() ? -1 : 1);
+}
+
+[[nodiscard]] bool startsWithIgnoringCase(QByteArrayView text, QByteArrayView prefix) {
+	return text.size() >= prefix.size() && ::compareIgnoringCase(text.first(prefix.size()), prefix) == 0;
+}
+
+[[nodiscard]] int compareFiles(const VPKArchive::File& file, QByteArrayView name, QByteArrayView extension) {
+	if (const auto result = ::compareIgnoringCase(file.name, name); result != 0) {
+		return result;
+	}
+	return ::compareIgnoringCase(file.extension, extension);
+}
+
+/// Whether "name.extension" starts with the prefix, without putting the two together
+[[nodiscard]] bool fileNameStartsWith(const VPKArchive::File& file, QByteArrayView prefix) {
+	if (prefix.size() <= file.name.size()) {
+		return ::startsWithIgnoringCase(file.name, prefix);
+	}
+	return ::compareIgnoringCase(file.name, prefix.first(file.name.size())) == 0
+		&& !file.extension.isEmpty()
+		&& prefix[file.name.size()] == '.'
+		&& ::startsWithIgnoringCase(file.extension, prefix.sliced(file.name.size() + 1));
+}
+
+/// A single path component that can't climb out of or name something outside the folder it's extracted to
+[[nodiscard]] bool isSafeComponent(QByteArrayView component) {
+	return !component.isEmpty()
+		&& component != "."
+		&& component != ".."
+		&& !component.contains('/')
+		&& !component.contains('\\')
+		&& !component.contains(':');
+}
+
+/// Relative, no "." or ".." components, no drive letters, and not absurdly deep. The root is the empty path.
+[[nodiscard]] bool isSafeDirectoryPath(QByteArrayView path) {
+	if (path.isEmpty()) {
+		return true;
+	}
+	qsizetype depth = 0;
+	qsizetype start = 0;
+	while (start <= path.size()) {
+		auto end = path.indexOf('/', start);
+		if (end < 0) {
+			end = path.size();
+		}
+		if (++depth > MAX_DIRECTORY_DEPTH || !::isSafeComponent(path.sliced(start, end - start))) {
+			return false;
+		}
+		start = end + 1;
+	}
+	return true;
+}
+
+/// Lowercase isn't needed, lookups ignore case
+[[nodiscard]] QByteArray normalizePath(QStringView path) {
+	auto out = path.toUtf8();
+	out.replace('\\', '/');
+	while (out.startsWith('/')) {
+		out.remove(0, 1);
+	}
+	return out;
+}
+
+void collectFiles(const QList<VPKArchive::Directory>& directories, quint32 directory, QList<quint32>& out, qsizetype limit) {
+	for (const auto file : directories[directory].files) {
+		if (limit > 0 && out.size() >= limit) {
+			return;
+		}
+		out.push_back(file);
+	}
+	for (const auto subdirectory : directories[directory].subdirectories) {
+		::collectFiles(directories, subdirectory, out, limit);
+	}
+}
+
+[[nodiscard]] quint32 getCRC32(const std::pair<QByteArrayView, QByteArrayView>& data) {
+	auto crc = mz_crc32(MZ_CRC32_INIT, reinterpret_cast<const mz_uint8*>(data.first.data()), static_cast<size_t>(data.first.size()));
+	crc = mz_crc32(crc, reinterpret_cast<const mz_uint8*>(data.second.data()), static_cast<size_t>(data.second.size()));
+	return static_cast<quint32>(crc);
+}
+
+} // namespace
+
+bool VPKArchive::PathKey::operator==(const PathKey& other) const {
+	return ::compareIgnoringCase(this->path, other.path) == 0;
+}
+
+size_t qHash(const VPKArchive::PathKey& key, size_t seed) noexcept {
+	// FNV-1a over the lowercased path
+	quint64 hash = 0xcbf29ce484222325ull ^ seed;
+	for (const auto c : key.path) {
+		hash = (hash ^ static_cast<uchar>(::toLower(c))) * 0x100000001b3ull;
+	}
+	return static_cast<size_t>(hash);
+}
+
+std::unique_ptr<VPKArchive> VPKArchive::open(const QString& path) {
+	std::unique_ptr<VPKArchive> archive{new VPKArchive};
+	archive->path = path;
+	archive->dirFile.setFileName(path);
+	if (!archive->dirFile.open(QIODevice::ReadOnly) || archive->dirFile.size() < V1_HEADER_SIZE) {
+		return nullptr;
+	}
+	// The tree is never copied out of the mapping, only the pages it touches are read
+	const auto* data = archive->dirFile.map(0, archive->dirFile.size());
+	if (!data) {
+		return nullptr;
+	}
+	archive->dirData = {data, archive->dirFile.size()};
+
+	const auto signature = ::read<quint32>(archive->dirData, 0);
+	const auto version = ::read<quint32>(archive->dirData, 4);
+	const auto treeSize = ::read<quint32>(archive->dirData, 8);
+	if (!signature || *signature != VPK_SIGNATURE || !version || (*version != 1 && *version != 2) || !treeSize) {
+		return nullptr;
+	}
+	const auto headerSize = *version == 1 ? V1_HEADER_SIZE : V2_HEADER_SIZE;
+	if (headerSize + *treeSize > archive->dirData.size()) {
+		return nullptr;
+	}
+	archive->dataOffset = headerSize + *treeSize;
+	if (!archive->parseTree(archive->dirData.sliced(headerSize, *treeSize), headerSize)) {
+		return nullptr;
+	}
+	return archive;
+}
+
+QString VPKArchive::getFileName(quint32 file) const {
+	const auto& entry = this->files[file];
+	if (entry.extension.isEmpty()) {
+		return QString::fromUtf8(entry.name);
+	}
+	return QString::fromUtf8(entry.name) + '.' + QString::fromUtf8(entry.extension);
+}
+
+QString VPKArchive::getFilePath(quint32 file) const {
+	const auto& directory = this->directories[this->files[file].directory];
+	if (directory.path.isEmpty()) {
+		return this->getFileName(file);
+	}
+	return QString::fromUtf8(directory.path) + '/' + this->getFileName(file);
+}
+
+std::optional<quint32> VPKArchive::findFile(QStringView path) const {
+	const auto query = ::normalizePath(path);
+	const QByteArrayView view{query};
+	const auto slash = view.lastIndexOf('/');
+	const auto directory = this->directoryIndex.constFind({slash < 0 ? QByteArrayView{} : view.first(slash)});
+	if (directory == this->directoryIndex.constEnd()) {
+		return std::nullopt;
+	}
+
+	const auto fileName = slash < 0 ? view : view.sliced(slash + 1);
+	const auto dot = fileName.lastIndexOf('.');
+	const auto name = dot < 0 ? fileName : fileName.first(dot);
+	const auto extension = dot < 0 ? QByteArrayView{} : fileName.sliced(dot + 1);
+
+	const auto& candidates = this->directories[*directory].files;
+	const auto it = std::lower_bound(candidates.begin(), candidates.end(), 0, [this, name, extension](quint32 file, int) {
+		return ::compareFiles(this->files[file], name, extension) < 0;
+	});
+	if (it == candidates.end() || ::compareFiles(this->files[*it], name, extension) != 0) {
+		return std::nullopt;
+	}
+	return *it;
+}
+
+std::optional<quint32> VPKArchive::findDirectory(QStringView path) const {
+	auto query = ::normalizePath(path);
+	while (query.endsWith('/')) {
+		query.chop(1);
+	}
+	if (const auto it = this->directoryIndex.constFind({query}); it != this->directoryIndex.constEnd()) {
+		return *it;
+	}
+	return std::nullopt;
+}
+
+QList<quint32> VPKArchive::findByPrefix(QStringView prefix, qsizetype limit) const {
+	const auto query = ::normalizePath(prefix);
+	const QByteArrayView view{query};
+	const auto slash = view.lastIndexOf('/');
+	const auto directory = this->directoryIndex.constFind({slash < 0 ? QByteArrayView{} : view.first(slash)});
+	if (directory == this->directoryIndex.constEnd()) {
+		return {};
+	}
+
+	const auto rest = slash < 0 ? view : view.sliced(slash + 1);
+	QList<quint32> out;
+	for (const auto file : this->directories[*directory].files) {
+		if (limit > 0 && out.size() >= limit) {
+			return out;
+		}
+		if (::fileNameStartsWith(this->files[file], rest)) {
+			out.push_back(file);
+		}
+	}
+	for (const auto subdirectory : this->directories[*directory].subdirectories) {
+		if (::startsWithIgnoringCase(this->directories[subdirectory].name, rest)) {
+			::collectFiles(this->directories, subdirectory, out, limit);
+		}
+	}
+	return out;
+}
+
+QList<quint32> VPKArchive::getFilesUnder(quint32 directory) const {
+	QList<quint32> out;
+	::collectFiles(this->directories, directory, out, -1);
+	return out;
+}
+
+std::optional<QByteArray> VPKArchive::read(quint32 file) {
+	const auto data = this->getData(file);
+	if (!data || ::getCRC32(*data) != this->files[file].crc32) {
+		return std::nullopt;
+	}
+	QByteArray out;
+	out.reserve(data->first.size() + data->second.size());
+	out.append(data->first);
+	out.append(data->second);
+	return out;
+}
+
+bool VPKArchive::extract(quint32 file, const QString& outputPath) {
+	const auto data = this->getData(file);
+	if (!data || ::getCRC32(*data) != this->files[file].crc32) {
+		return false;
+	}
+	if (!QDir{}.mkpath(QFileInfo{outputPath}.absolutePath())) {
+		return false;
+	}
+	QSaveFile out{outputPath};
+	if (!out.open(QIODevice::WriteOnly)) {
+		return false;
+	}
+	for (const auto view : {data->first, data->second}) {
+		if (!view.isEmpty() && out.write(view.data(), view.size()) != view.size()) {
+			return false;
+		}
+	}
+	return out.commit();
+}
+
+bool VPKArchive::parseTree(QByteArrayView tree, qint64 treeOffset) {
+	// The root is always there, even in an empty archive
+	this->directories.push_back({});
+	this->directoryIndex.insert({QByteArrayView{}}, 0);
+
+	// Files are grouped by extension, then by directory
+	qint64 offset = 0;
+	while (true) {
+		const auto extension = ::readString(tree, offset);
+		if (!extension) {
+			return false;
+		}
+		if (extension->isEmpty()) {
+			break;
+		}
+		while (true) {
+			auto directoryPath = ::readString(tree, offset);
+			if (!directoryPath) {
+				return false;
+			}
+			if (directoryPath->isEmpty()) {
+				break;
+			}
+			if (*directoryPath == EMPTY_FIELD) {
+				directoryPath = QByteArrayView{};
+			}
+			while (directoryPath->endsWith('/')) {
+				directoryPath->chop(1);
+			}
+			// Entries that would be extracted outside the output folder are skipped, but still read past
+			const auto safeDirectory = ::isSafeDirectoryPath(*directoryPath);
+			const auto directory = safeDirectory ? this->getOrAddDirectory(*directoryPath) : 0;
+
+			while (true) {
+				const auto name = ::readString(tree, offset);
+				if (!name) {
+					return false;
+				}
+				if (name->isEmpty()) {
+					break;
+				}
+				const auto crc32 = ::read<quint32>(tree, offset);
+				const auto preloadSize = ::read<quint16>(tree, offset + 4);
+				const auto archiveIndex = ::read<quint16>(tree, offset + 6);
+				const auto entryOffset = ::read<quint32>(tree, offset + 8);
+				const auto entrySize = ::read<quint32>(tree, offset + 12);
+				const auto terminator = ::read<quint16>(tree, offset + 16);
+				if (!crc32 || !preloadSize || !archiveIndex || !entryOffset || !entrySize || !terminator || *terminator != ENTRY_TERMINATOR) {
+					return false;
+				}
+				offset += ENTRY_SIZE;
+				if (offset + *preloadSize > tree.size()) {
+					return false;
+				}
+				if (!safeDirectory || !::isSafeComponent(*name) || (*extension != EMPTY_FIELD && !::isSafeComponent(*extension))) {
+					offset += *preloadSize;
+					continue;
+				}
+
+				this->directories[directory].files.push_back(static_cast<quint32>(this->files.size()));
+				this->files.push_back({
+					*name,
+					*extension == EMPTY_FIELD ? QByteArrayView{} : *extension,
+					directory,
+					*crc32,
+					static_cast<quint32>(treeOffset + offset),
+					*preloadSize,
+					*archiveIndex,
+					*entryOffset,
+					*entrySize,
+				});
+				offset += *preloadSize;
+			}
+		}
+	}
+
+	// Sorted once here so lookups can binary search and the browser lists everything in order
+	for (auto& directory : this->directories) {
+		std::sort(directory.subdirectories.begin(), directory.subdirectories.end(), [this](quint32 lhs, quint32 rhs) {
+			return ::compareIgnoringCase(this->directories[lhs].name, this->directories[rhs].name) < 0;
+		});
+		std::sort(directory.files.begin(), directory.files.end(), [this](quint32 lhs, quint32 rhs) {
+			return ::compareFiles(this->files[lhs], this->files[rhs].name, this->files[rhs].extension) < 0;
+		});
+	}
+	return true;
+}
+
+quint32 VPKArchive::getOrAddDirectory(QByteArrayView path) {
+	// Walk up to the deepest directory that already exists, the root always does
+	qsizetype existingEnd = path.size();
+	quint32 parent = 0;
+	while (true) {
+		if (const auto it = this->directoryIndex.constFind({path.first(existingEnd)}); it != this->directoryIndex.constEnd()) {
+			parent = *it;
+			break;
+		}
+		existingEnd = std::max<qsizetype>(path.first(existingEnd).lastIndexOf('/'), 0);
+	}
+
+	// Then add the missing ones below it. Only the deepest directories are named in the tree, their parents are views
+	// of the same string.
+	while (existingEnd < path.size()) {
+		const auto start = existingEnd == 0 ? 0 : existingEnd + 1;
+		auto end = path.indexOf('/', start);
+		if (end < 0) {
+			end = path.size();
+		}
+		const auto index = static_cast<quint32>(this->directories.size());
+		this->directories.push_back({path.first(end), path.sliced(start, end - start), parent, {}, {}});
+		this->directories[parent].subdirectories.push_back(index);
+		this->directoryIndex.insert({path.first(end)}, index);
+		parent = index;
+		existingEnd = end;
+	}
+	return parent;
+}
+
+QString VPKArchive::getOutputPath(quint32 file, const QString& outputDir) const {
+	const auto root = QDir::cleanPath(QFileInfo{outputDir}.absoluteFilePath());
+	const auto outputPath = QDir::cleanPath(root + '/' + this->getFilePath(file));
+	if (!outputPath.startsWith(root.endsWith('/') ? root : root + '/')) {
+		return {};
+	}
+	return outputPath;
+}
+
+std::optional<std::pair<QByteArrayView, QByteArrayView>> VPKArchive::getData(quint32 file) {
+	if (file >= this->files.size()) {
+		return std::nullopt;
+	}
+	const auto& entry = this->files[file];
+	const auto preload = this->dirData.sliced(entry.preloadOffset, entry.preloadSize);
+	if (entry.size == 0) {
+		return std::pair{preload, QByteArrayView{}};
+	}
+	const auto source = entry.archiveIndex == DIR_ARCHIVE_INDEX ? this->dirData.sliced(this->dataOffset) : this->getChunk(entry.archiveIndex);
+	if (static_cast<qint64>(entry.offset) + entry.size > source.size()) {
+		return std::nullopt;
+	}
+	return std::pair{preload, source.sliced(entry.offset, entry.size)};
+}
+
+QByteArrayView VPKArchive::getChunk(quint16 archiveIndex) {
+	QMutexLocker lock{&this->chunksMutex};
+	if (archiveIndex >= this->chunks.size()) {
+		this->chunks.resize(archiveIndex + 1);
+	}
+	auto& chunk = this->chunks[archiveIndex];
+	if (chunk.opened) {
+		return chunk.data;
+	}
+	chunk.opened = true;
+
+	// pak01_dir.vpk keeps the rest of its data in pak01_000.vpk, pak01_001.vpk and so on
+	if (!this->path.endsWith(DIR_SUFFIX, Qt::CaseInsensitive)) {
+		return {};
+	}
+	chunk.file = std::make_unique<QFile>(this->path.chopped(DIR_SUFFIX.size()) + QString{"_%1.vpk"}.arg(archiveIndex, 3, 10, QChar{'0'}));
+	if (!chunk.file->open(QIODevice::ReadOnly)) {
+		return {};
+	}
+	// Mapped once and kept for as long as the archive is open, reads come straight out of the page cache
+	if (const auto* data = chunk.file->map(0, chunk.file->size())) {
+		chunk.data = {data, chunk.file->size()};
+	}
+	return chunk.data;
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+
+/// Read-only access to a Valve VPK archive (versions 1 and 2). The directory file is mapped and indexed in place,
+/// every name in the index points into the mapping, and file contents are read straight out of the mapped chunks.
+/// Lookups are case insensitive and accept either slash. Reading and extracting are safe from several threads.
+/// Entries with paths that could escape an output folder ("..", drive letters and the like) are left out of the index.
+class VPKArchive {
+public:
+	/// Where the data of a file is stored when it's in the directory file rather than a numbered chunk
+	static constexpr quint16 DIR_ARCHIVE_INDEX = 0x7fff;
+
+	struct File {
+		/// Without the extension
+		QByteArrayView name;
+		/// Empty if the file has none
+		QByteArrayView extension;
+		quint32 directory = 0;
+		quint32 crc32 = 0;
+		quint32 preloadOffset = 0;
+		quint16 preloadSize = 0;
+		quint16 archiveIndex = 0;
+		quint32 offset = 0;
+		quint32 size = 0;
+
+		[[nodiscard]] qint64 getSize() const { return static_cast<qint64>(this->preloadSize) + this->size; }
+	};
+
+	struct Directory {
+		/// Path from the root without a trailing slash, empty for the root itself
+		QByteArrayView path;
+		/// The last component of the path
+		QByteArrayView name;
+		quint32 parent = 0;
+		/// Sorted by name
+		QList<quint32> subdirectories;
+		/// Sorted by name, then extension
+		QList<quint32> files;
+	};
+
+	/// Opens a "_dir.vpk" file, or a VPK that holds all of its data itself. Returns nullptr if the file can't be mapped,
+	/// isn't a VPK of a supported version, or its directory tree is damaged.
+	[[nodiscard]] static std::unique_ptr<VPKArchive> open(const QString& path);
+
+	[[nodiscard]] const QString& getPath() const { return this->path; }
+
+	/// The root directory is always the first one
+	[[nodiscard]] const QList<Directory>& getDirectories() const { return this->directories; }
+
+	[[nodiscard]] const QList<File>& getFiles() const { return this->files; }
+
+	[[nodiscard]] QString getFileName(quint32 file) const;
+
+	/// The path of a file from the root of the archive
+	[[nodiscard]] QString getFilePath(quint32 file) const;
+
+	[[nodiscard]] std::optional<quint32> findFile(QStringView path) const;
+
+	[[nodiscard]] std::optional<quint32> findDirectory(QStringView path) const;
+
+	/// Files whose path starts with the prefix, at most limit of them if it's positive. A prefix ending in a slash
+	/// matches everything in that directory. Only the directory the prefix ends in is searched, not the whole archive.
+	[[nodiscard]] QList<quint32> findByPrefix(QStringView prefix, qsizetype limit = -1) const;
+
+	/// Every file in the directory and its subdirectories
+	[[nodiscard]] QList<quint32> getFilesUnder(quint32 directory) const;
+
+	/// Where a file goes when extracted to the output directory, or an empty string if it would end up outside of it.
+	/// Paths that could escape are already dropped while the tree is read, this is checked again right before writing.
+	[[nodiscard]] QString getOutputPath(quint32 file, const QString& outputDir) const;
+
+	/// Returns the contents of a file, after checking its CRC-32
+	[[nodiscard]] std::optional<QByteArray> read(quint32 file);
+
+	/// Writes a file to disk straight from the mapped archive without copying it into memory first, creating any
+	/// missing parent directories. The CRC-32 is checked before anything is written.
+	[[nodiscard]] bool extract(quint32 file, const QString& outputPath);
+
+private:
+	/// Case insensitive key into the mapped directory file
+	struct PathKey {
+		QByteArrayView path;
+
+		[[nodiscard]] bool operator==(const PathKey& other) const;
+	};
+	friend size_t qHash(const PathKey& key, size_t seed) noexcept;
+
+	struct Chunk {
+		std::unique_ptr<QFile> file;
+		QByteArrayView data;
+		bool opened = false;
+	};
+
+	VPKArchive() = default;
+
+	[[nodiscard]] bool parseTree(QByteArrayView tree, qint64 treeOffset);
+
+	[[nodiscard]] quint32 getOrAddDirectory(QByteArrayView path);
+
+	/// The preload bytes and the rest of the file's data, as views into the mapped files
+	[[nodiscard]] std::optional<std::pair<QByteArrayView, QByteArrayView>> getData(quint32 file);
+
+	[[nodiscard]] QByteArrayView getChunk(quint16 archiveIndex);
+
+	QString path;
+	QFile dirFile;
+	QByteArrayView dirData;
+	qint64 dataOffset = 0;
+
+	QList<Directory> directories;
+	QList<File> files;
+	QHash<PathKey, quint32> directoryIndex;
+
+	QMutex chunksMutex;
+	std::vector<Chunk> chunks;
+};
@@ -0,0 +1,225 @@
+#include "VPKBrowserDialog.h"
+
+#include <atomic>
+#include <utility>
+
+#include <QDesktopServices>
+#include <QDialogButtonBox>
+#include <QDir>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLineEdit>
+#include <QLocale>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QSet>
+#include <QStyle>
+#include <QTreeWidget>
+#include <QUrl>
+#include <QVBoxLayout>
+#include <QtConcurrent>
+
+namespace {
+
+enum Column {
+	COLUMN_NAME,
+	COLUMN_SIZE,
+};
+
+constexpr int ROLE_INDEX = Qt::UserRole;
+constexpr int ROLE_IS_DIRECTORY = Qt::UserRole + 1;
+constexpr int ROLE_POPULATED = Qt::UserRole + 2;
+
+/// Prefixes as short as a single letter can match most of an archive, nobody scrolls through more than this
+constexpr qsizetype SEARCH_RESULT_LIMIT = 1000;
+
+/// Data formats that no platform executes when opened
+const QSet<QString> OPENABLE_EXTENSIONS{
+	"bik", "bmp", "cfg", "dmx", "jpeg", "jpg", "json", "kv", "kv3", "lst", "mdl", "mp3", "ogg", "pcf", "phy", "png",
+	"res", "tga", "txt", "vcd", "vdf", "vmf", "vmt", "vtf", "vtx", "vvd", "wav", "webm",
+};
+
+} // namespace
+
+VPKBrowserDialog::VPKBrowserDialog(QString path_, QWidget* parent)
+		: QDialog(parent)
+		, path(std::move(path_))
+		, loading(new QFutureWatcher<std::shared_ptr<VPKArchive>>{this})
+		, extraction(new QFutureWatcher<int>{this}) {
+	// Window setup
+	this->setModal(true);
+	this->setWindowTitle(tr("VPK Browser - %1").arg(QFileInfo{this->path}.fileName()));
+	this->setMinimumSize(560, 480);
+
+	// Create UI elements
+	auto* layout = new QVBoxLayout{this};
+
+	this->search = new QLineEdit{this};
+	this->search->setPlaceholderText(tr("Search by path, e.g. materials/models/props"));
+	this->search->setClearButtonEnabled(true);
+	this->search->setEnabled(false);
+	layout->addWidget(this->search);
+
+	this->entries = new QTreeWidget{this};
+	this->entries->setHeaderLabels({tr("Name"), tr("Size")});
+	this->entries->setSelectionMode(QAbstractItemView::ExtendedSelection);
+	this->entries->header()->setSectionResizeMode(COLUMN_NAME, QHeaderView::Stretch);
+	this->entries->header()->setStretchLastSection(false);
+	layout->addWidget(this->entries);
+
+	this->status = new QLabel{tr("Loading..."), this};
+	layout->addWidget(this->status);
+
+	auto* buttonBox = new QDialogButtonBox{QDialogButtonBox::Close, Qt::Horizontal, this};
+	this->extractButton = buttonBox->addButton(tr("Extract..."), QDialogButtonBox::ActionRole);
+	this->extractButton->setEnabled(false);
+	layout->addWidget(buttonBox);
+
+	QObject::connect(this->search, &QLineEdit::textChanged, this, &VPKBrowserDialog::showSearchResults);
+	QObject::connect(this->entries, &QTreeWidget::itemExpanded, this, [this](QTreeWidgetItem* item) {
+		// Large archives have tens of thousands of files, folders are only filled in once they're opened
+		if (item->data(COLUMN_NAME, ROLE_IS_DIRECTORY).toBool() && !item->data(COLUMN_NAME, ROLE_POPULATED).toBool()) {
+			item->setData(COLUMN_NAME, ROLE_POPULATED, true);
+			this->showDirectory(item, item->data(COLUMN_NAME, ROLE_INDEX).toUInt());
+		}
+	});
+	QObject::connect(this->entries, &QTreeWidget::itemDoubleClicked, this, [this](const QTreeWidgetItem* item) {
+		if (!item->data(COLUMN_NAME, ROLE_IS_DIRECTORY).toBool()) {
+			this->openFile(item->data(COLUMN_NAME, ROLE_INDEX).toUInt());
+		}
+	});
+	QObject::connect(this->extractButton, &QPushButton::clicked, this, &VPKBrowserDialog::extractSelected);
+	QObject::connect(buttonBox, &QDialogButtonBox::rejected, this, &VPKBrowserDialog::reject);
+
+	QObject::connect(this->loading, &QFutureWatcher<std::shared_ptr<VPKArchive>>::finished, this, [this] {
+		this->archive = this->loading->result();
+		if (!this->archive) {
+			this->status->setText(tr("%1 is not a VPK archive, or it is damaged.").arg(QDir::toNativeSeparators(this->path)));
+			return;
+		}
+		this->search->setEnabled(true);
+		this->extractButton->setEnabled(true);
+		this->showSearchResults({});
+	});
+	QObject::connect(this->extraction, &QFutureWatcher<int>::finished, this, [this] {
+		this->extractButton->setEnabled(true);
+		if (const auto failed = this->extraction->result(); failed > 0) {
+			QMessageBox::warning(this, tr("Extraction Failed"), tr("%1 files could not be extracted. Their chunks may be missing or damaged.").arg(failed));
+		}
+		this->status->setText(tr("Extraction finished."));
+	});
+
+	this->loading->setFuture(QtConcurrent::run([path = this->path] {
+		return std::shared_ptr<VPKArchive>{VPKArchive::open(path)};
+	}));
+}
+
+void VPKBrowserDialog::showDirectory(QTreeWidgetItem* parent, quint32 directory) {
+	const auto& directories = this->archive->getDirectories();
+	for (const auto subdirectory : directories[directory].subdirectories) {
+		auto* item = parent ? new QTreeWidgetItem{parent} : new QTreeWidgetItem{this->entries};
+		item->setText(COLUMN_NAME, QString::fromUtf8(directories[subdirectory].name));
+		item->setIcon(COLUMN_NAME, this->style()->standardIcon(QStyle::SP_DirIcon));
+		item->setData(COLUMN_NAME, ROLE_INDEX, subdirectory);
+		item->setData(COLUMN_NAME, ROLE_IS_DIRECTORY, true);
+		item->setChildIndicatorPolicy(QTreeWidgetItem::ShowIndicator);
+	}
+	for (const auto file : directories[directory].files) {
+		this->addFile(parent, file, false);
+	}
+}
+
+void VPKBrowserDialog::showSearchResults(const QString& prefix) {
+	if (!this->archive) {
+		return;
+	}
+	this->entries->clear();
+	this->entries->setRootIsDecorated(prefix.isEmpty());
+
+	if (prefix.isEmpty()) {
+		this->showDirectory(nullptr, 0);
+		this->status->setText(tr("%1 files in %2 folders.").arg(this->archive->getFiles().size()).arg(this->archive->getDirectories().size() - 1));
+	} else {
+		const auto results = this->archive->findByPrefix(prefix, SEARCH_RESULT_LIMIT);
+		for (const auto file : results) {
+			this->addFile(nullptr, file, true);
+		}
+		this->status->setText(results.size() < SEARCH_RESULT_LIMIT ? tr("%1 files match.").arg(results.size()) : tr("Showing the first %1 matches.").arg(results.size()));
+	}
+	this->entries->resizeColumnToContents(COLUMN_SIZE);
+}
+
+QTreeWidgetItem* VPKBrowserDialog::addFile(QTreeWidgetItem* parent, quint32 file, bool fullPath) {
+	auto* item = parent ? new QTreeWidgetItem{parent} : new QTreeWidgetItem{this->entries};
+	item->setText(COLUMN_NAME, fullPath ? this->archive->getFilePath(file) : this->archive->getFileName(file));
+	item->setIcon(COLUMN_NAME, this->style()->standardIcon(QStyle::SP_FileIcon));
+	item->setData(COLUMN_NAME, ROLE_INDEX, file);
+	item->setData(COLUMN_NAME, ROLE_IS_DIRECTORY, false);
+	item->setText(COLUMN_SIZE, QLocale{}.formattedDataSize(this->archive->getFiles()[file].getSize()));
+	item->setTextAlignment(COLUMN_SIZE, Qt::AlignRight | Qt::AlignVCenter);
+	return item;
+}
+
+void VPKBrowserDialog::extractSelected() {
+	if (!this->archive || this->extraction->isRunning()) {
+		return;
+	}
+
+	// Selecting a folder and something inside it shouldn't extract the same file twice
+	QSet<quint32> selected;
+	for (const auto* item : this->entries->selectedItems()) {
+		const auto index = item->data(COLUMN_NAME, ROLE_INDEX).toUInt();
+		if (item->data(COLUMN_NAME, ROLE_IS_DIRECTORY).toBool()) {
+			for (const auto file : this->archive->getFilesUnder(index)) {
+				selected.insert(file);
+			}
+		} else {
+			selected.insert(index);
+		}
+	}
+	if (selected.isEmpty()) {
+		QMessageBox::information(this, tr("Extract"), tr("Select the files or folders to extract first."));
+		return;
+	}
+
+	const auto outputDir = QFileDialog::getExistingDirectory(this, tr("Extract To"));
+	if (outputDir.isEmpty()) {
+		return;
+	}
+
+	this->extractButton->setEnabled(false);
+	this->status->setText(tr("Extracting %1 files...").arg(selected.size()));
+	this->extraction->setFuture(QtConcurrent::run([archive = this->archive, files = selected.values(), outputDir]() mutable {
+		std::atomic<int> failed = 0;
+		QtConcurrent::blockingMap(files, [&archive, &failed, &outputDir](quint32 file) {
+			if (const auto outputPath = archive->getOutputPath(file, outputDir); outputPath.isEmpty() || !archive->extract(file, outputPath)) {
+				failed++;
+			}
+		});
+		return failed.load();
+	}));
+}
+
+void VPKBrowserDialog::openFile(quint32 file) {
+	// Opened from a scratch copy, there's no way to hand an application a file inside the archive
+	const auto outputPath = this->archive->getOutputPath(file, QDir::tempPath() + "/sdk_launcher_vpk/" + QFileInfo{this->path}.completeBaseName());
+	if (outputPath.isEmpty() || !this->archive->extract(file, outputPath)) {
+		QMessageBox::warning(this, tr("Extraction Failed"), tr("%1 could not be extracted. Its chunk may be missing or damaged.").arg(this->archive->getFilePath(file)));
+		return;
+	}
+	// Opening a file runs it if it's a program or script, so anything that isn't known to be plain game data is only
+	// shown in its folder
+	if (OPENABLE_EXTENSIONS.contains(QFileInfo{outputPath}.suffix().toLower())) {
+		QDesktopServices::openUrl(QUrl::fromLocalFile(outputPath));
+	} else {
+		QDesktopServices::openUrl(QUrl::fromLocalFile(QFileInfo{outputPath}.absolutePath()));
+	}
+}
+
+void VPKBrowserDialog::open(const QString& path, QWidget* parent) {
+	auto* dialog = new VPKBrowserDialog{path, parent};
+	dialog->exec();
+	dialog->deleteLater();
+}
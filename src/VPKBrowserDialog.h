@@ -0,0 +1,43 @@
+#pragma once
+
+#include <memory>
+
+#include <QDialog>
+#include <QFutureWatcher>
+
+#include "VPKArchive.h"
+
+class QLabel;
+class QLineEdit;
+class QPushButton;
+class QTreeWidget;
+class QTreeWidgetItem;
+
+class VPKBrowserDialog : public QDialog {
+	Q_OBJECT;
+
+public:
+	explicit VPKBrowserDialog(QString path_, QWidget* parent = nullptr);
+
+	static void open(const QString& path, QWidget* parent = nullptr);
+
+private:
+	QString path;
+	std::shared_ptr<VPKArchive> archive;
+	QLineEdit* search;
+	QTreeWidget* entries;
+	QLabel* status;
+	QPushButton* extractButton;
+	QFutureWatcher<std::shared_ptr<VPKArchive>>* loading;
+	QFutureWatcher<int>* extraction;
+
+	void showDirectory(QTreeWidgetItem* parent, quint32 directory);
+
+	void showSearchResults(const QString& prefix);
+
+	QTreeWidgetItem* addFile(QTreeWidgetItem* parent, quint32 file, bool fullPath);
+
+	void extractSelected();
+
+	void openFile(quint32 file);
+};
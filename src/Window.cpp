@@ -2,11 +2,20 @@
 
 #include "Window.h"
 
+#include <algorithm>
 #include <chrono>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <QAction>
 #include <QApplication>
+#include <QCloseEvent>
+#include <QDateTime>
 #include <QDesktopServices>
 #include <QDir>
 #include <QFileDialog>
+#include <QFileInfo>
 #include <QInputDialog>
 #include <QLabel>
 #include <QMenuBar>
@@ -15,18 +24,41 @@
 #include <QScrollArea>
 #include <QStyle>
 #include <QStyleHints>
+#include <QTcpServer>
+#include <QTimer>
+#include <QtConcurrent>
+#include <QUdpSocket>
 #include <QVBoxLayout>
 
+#include "AddonIndex.h"
+#include "AddonManagerDialog.h"
+#include "CommandProgressDialog.h"
 #include "Config.h"
+#include "CrashCollector.h"
+#include "CrashReportsDialog.h"
+#include "DiskUsageDialog.h"
+#include "DuplicateFilesDialog.h"
 #include "GameConfig.h"
 #include "LaunchButton.h"
+#include "LaunchJournal.h"
+#include "LayoutSnapshot.h"
 #include "NewModDialog.h"
 #include "NewP2CEAddonDialog.h"
 #include "Options.h"
+#include "PEIcon.h"
+#include "Prewarm.h"
 #include "Steam.h"
+#include "SteamIndex.h"
+#include "TemplatePrefetch.h"
+#include "VPKBrowserDialog.h"
 
 #ifdef _WIN32
 #include <shlobj_core.h>
+#else
+#include <sys/resource.h>
+#endif
+#ifdef __linux__
+#include <sched.h>
 #endif
 
 namespace {
@@ -46,6 +78,28 @@ void clearLayout(QLayout* layout, bool deleteWidgets = true) {
 	}
 }
 
+void addSectionHeader(QVBoxLayout* layout, const QString& text, QWidget* parent) {
+	auto* name = new QLabel(text, parent);
+	name->setStyleSheet("QLabel { font-size: 11pt; }");
+	layout->addWidget(name);
+
+	auto* line = new QFrame(parent);
+	line->setFrameShape(QFrame::HLine);
+	layout->addWidget(line);
+}
+
+[[nodiscard]] LaunchButton* createLaunchButton(const QString& text, QWidget* parent) {
+	auto* button = new LaunchButton(parent);
+	button->setStyleSheet(
+			"LaunchButton          { background-color: rgba(  0,   0, 0,  0); border: none; }\n"
+			"LaunchButton::pressed { background-color: rgba(220, 220, 0, 32); border: none; }\n"
+			"LaunchButton::hover   { background-color: rgba(220, 220, 0, 32); border: none; }");
+	button->setToolButtonStyle(Qt::ToolButtonTextBesideIcon);
+	button->setText(text);
+	button->setIconSize({16, 16});
+	return button;
+}
+
 #ifdef _WIN32
 [[nodiscard]] QIcon getExecutableIcon(const QString& path) {
 	HICON hIcon;
@@ -58,17 +112,99 @@ void clearLayout(QLayout* layout, bool deleteWidgets = true) {
 }
 #endif
 
-[[nodiscard]] QString getRootPath(bool usesLegacyBinDir) {
-	QString rootPath = QCoreApplication::applicationDirPath();
-	if (usesLegacyBinDir) {
-		rootPath += "/..";
-	} else {
-		rootPath += "/../..";
+void applyEntryScheduling(QProcess* process, const GameConfig::Command& command) {
+	if (!command.environment.isEmpty()) {
+		auto environment = QProcessEnvironment::systemEnvironment();
+		for (const auto& [key, value] : command.environment.asKeyValueRange()) {
+			environment.insert(key, value);
+		}
+		process->setProcessEnvironment(environment);
 	}
-	if (auto cleanPath = QDir::cleanPath(rootPath); !cleanPath.isEmpty()) {
-		return cleanPath;
+
+#ifndef _WIN32
+	if (command.priority == 0 && command.cpuAffinity.isEmpty() && command.memoryLimitMB <= 0) {
+		return;
 	}
-	return rootPath;
+	// Runs in the child between fork and exec, so only async-signal-safe calls are allowed in here
+	process->setChildProcessModifier([priority = command.priority, cpuAffinity = command.cpuAffinity, memoryLimitMB = command.memoryLimitMB] {
+		if (priority != 0) {
+			::setpriority(PRIO_PROCESS, 0, priority);
+		}
+#ifdef __linux__
+		if (!cpuAffinity.isEmpty()) {
+			cpu_set_t cpus;
+			CPU_ZERO(&cpus);
+			for (const int cpu : cpuAffinity) {
+				if (cpu >= 0 && cpu < CPU_SETSIZE) {
+					CPU_SET(cpu, &cpus);
+				}
+			}
+			::sched_setaffinity(0, sizeof(cpus), &cpus);
+		}
+#endif
+		if (rlimit limit{}; memoryLimitMB > 0 && ::getrlimit(RLIMIT_DATA, &limit) == 0) {
+			// Soft limit only, the process may raise it back up to the hard limit
+			const auto softLimit = static_cast<rlim_t>(memoryLimitMB) * 1024 * 1024;
+			if (limit.rlim_max == RLIM_INFINITY || softLimit <= limit.rlim_max) {
+				limit.rlim_cur = softLimit;
+				::setrlimit(RLIMIT_DATA, &limit);
+			}
+		}
+	});
+#endif
+}
+
+/// Asks the OS for free ports that are open for both UDP and TCP, like the engine needs for game traffic and rcon.
+/// They're all held until every port is found so they're distinct, but another program could still take one before
+/// the instance using it starts. Ports that couldn't be found are 0.
+[[nodiscard]] QList<quint16> allocatePorts(int count) {
+	QList<quint16> ports;
+	std::vector<std::unique_ptr<QUdpSocket>> udpSockets;
+	std::vector<std::unique_ptr<QTcpServer>> tcpServers;
+	for (int i = 0; i < count; i++) {
+		quint16 port = 0;
+		for (int attempt = 0; attempt < 8 && port == 0; attempt++) {
+			auto udpSocket = std::make_unique<QUdpSocket>();
+			if (!udpSocket->bind(QHostAddress::Any, 0)) {
+				break;
+			}
+			auto tcpServer = std::make_unique<QTcpServer>();
+			if (!tcpServer->listen(QHostAddress::Any, udpSocket->localPort())) {
+				continue;
+			}
+			port = udpSocket->localPort();
+			udpSockets.push_back(std::move(udpSocket));
+			tcpServers.push_back(std::move(tcpServer));
+		}
+		ports.push_back(port);
+	}
+	return ports;
+}
+
+[[nodiscard]] QString formatRunTime(qint64 ms) {
+	const auto minutes = ms / 60'000;
+	if (minutes < 1) {
+		return QObject::tr("%1s").arg(ms / 1000);
+	}
+	if (minutes < 60) {
+		return QObject::tr("%1m").arg(minutes);
+	}
+	return QObject::tr("%1h %2m").arg(minutes / 60).arg(minutes % 60);
+}
+
+/// Empty if the entry was never launched, otherwise a line to append to the entry's tooltip
+[[nodiscard]] QString getLaunchStatsText(const LaunchJournal::Stats& stats) {
+	if (stats.launches <= 0) {
+		return "";
+	}
+	QString text = '\n' + QObject::tr("Launched %n time(s)", nullptr, static_cast<int>(stats.launches));
+	if (stats.crashes > 0) {
+		text += QObject::tr(", crashed %1% of the time").arg(qRound(stats.getCrashRate() * 100.0));
+	}
+	if (stats.medianRunTimeMs) {
+		text += QObject::tr(", usually runs for %1").arg(::formatRunTime(*stats.medianRunTimeMs));
+	}
+	return text;
 }
 
 } // namespace
@@ -76,7 +212,8 @@ void clearLayout(QLayout* layout, bool deleteWidgets = true) {
 Window::Window(QWidget* parent)
 		: QMainWindow(parent)
 		, gameDefault(PROJECT_DEFAULT_MOD.data())
-		, configUsingLegacyBinDir(false) {
+		, configUsingLegacyBinDir(false)
+		, configPrewarmBudgetMB(DEFAULT_PREWARM_BUDGET_MB) {
 	this->setWindowTitle(PROJECT_NAME.data());
 	this->setMinimumHeight(400);
 
@@ -109,6 +246,25 @@ Window::Window(QWidget* parent)
 	singleClickToRunAction->setCheckable(true);
 	singleClickToRunAction->setChecked(Options::get<bool>(BOOL_SINGLE_CLICK_TO_RUN, BOOL_SINGLE_CLICK_TO_RUN_DEFAULT));
 
+	auto* sortByMostUsedAction = configMenu->addAction(tr("Sort by Most Used"), [this] {
+		Options::set(BOOL_SORT_BY_MOST_USED, !Options::get<bool>(BOOL_SORT_BY_MOST_USED, BOOL_SORT_BY_MOST_USED_DEFAULT));
+		this->loadMostRecentGameConfig();
+	});
+	sortByMostUsedAction->setCheckable(true);
+	sortByMostUsedAction->setChecked(Options::get<bool>(BOOL_SORT_BY_MOST_USED, BOOL_SORT_BY_MOST_USED_DEFAULT));
+
+	auto* prewarmGameFilesAction = configMenu->addAction(tr("Prewarm Game Files"), [] {
+		Options::set(BOOL_PREWARM_GAME_FILES, !Options::get<bool>(BOOL_PREWARM_GAME_FILES, BOOL_PREWARM_GAME_FILES_DEFAULT));
+	});
+	prewarmGameFilesAction->setCheckable(true);
+	prewarmGameFilesAction->setChecked(Options::get<bool>(BOOL_PREWARM_GAME_FILES, BOOL_PREWARM_GAME_FILES_DEFAULT));
+
+	auto* collectCrashReportsAction = configMenu->addAction(tr("Collect Crash Reports"), [] {
+		Options::set(BOOL_COLLECT_CRASH_REPORTS, !Options::get<bool>(BOOL_COLLECT_CRASH_REPORTS, BOOL_COLLECT_CRASH_REPORTS_DEFAULT));
+	});
+	collectCrashReportsAction->setCheckable(true);
+	collectCrashReportsAction->setChecked(Options::get<bool>(BOOL_COLLECT_CRASH_REPORTS, BOOL_COLLECT_CRASH_REPORTS_DEFAULT));
+
 	// Game menu
 	auto* gameMenu = this->menuBar()->addMenu(tr("Game"));
 
@@ -126,22 +282,44 @@ Window::Window(QWidget* parent)
 		this->loadMostRecentGameConfig();
 	});
 
+	this->game_chooseGame = gameMenu->addMenu(tr("Installed Games and Mods"));
+	this->game_chooseGame->setDisabled(true);
+
 	// Utilities menu
 	auto* utilitiesMenu = this->menuBar()->addMenu(tr("Utilities"));
 
 	this->utilities_createNewMod = utilitiesMenu->addMenu(this->style()->standardIcon(QStyle::SP_FileIcon), tr("Create New Mod"));
 
+	this->utilities_updateMod = utilitiesMenu->addMenu(this->style()->standardIcon(QStyle::SP_BrowserReload), tr("Update Mod from Template"));
+
 	this->utilities_createNewAddon = utilitiesMenu->addAction(this->style()->standardIcon(QStyle::SP_FileIcon), tr("Create New Addon"), [this] {
-		QString gameRoot;
-		if (Options::contains(STR_GAME_OVERRIDE)) {
-			gameRoot = Options::get<QString>(STR_GAME_OVERRIDE);
-		} else {
-			gameRoot = this->gameDefault;
+		NewP2CEAddonDialog::open(this->getGameRoot(), this);
+	});
+
+	this->utilities_manageAddons = utilitiesMenu->addAction(this->style()->standardIcon(QStyle::SP_FileDialogListView), tr("Manage Addons"), [this] {
+		if (this->addonIndex) {
+			AddonManagerDialog::open(this->addonIndex, this);
 		}
-		if (!QDir::isAbsolutePath(gameRoot)) {
-			gameRoot = ::getRootPath(this->configUsingLegacyBinDir) + QDir::separator() + gameRoot;
+	});
+
+	utilitiesMenu->addSeparator();
+
+	utilitiesMenu->addAction(this->style()->standardIcon(QStyle::SP_DriveHDIcon), tr("Disk Usage"), [this] {
+		DiskUsageDialog::open(::getRootPath(this->configUsingLegacyBinDir), this->getGameRoot(), this);
+	});
+
+	utilitiesMenu->addAction(this->style()->standardIcon(QStyle::SP_FileDialogContentsView), tr("Find Duplicate Files"), [this] {
+		DuplicateFilesDialog::open({this->getGameRoot(), ::getSourceModsDir()}, this);
+	});
+
+	utilitiesMenu->addAction(this->style()->standardIcon(QStyle::SP_DirOpenIcon), tr("Browse VPK..."), [this] {
+		if (const auto path = QFileDialog::getOpenFileName(this, tr("Open VPK"), this->getGameRoot(), tr("VPK Archives (*.vpk)")); !path.isEmpty()) {
+			VPKBrowserDialog::open(path, this);
 		}
-		NewP2CEAddonDialog::open(gameRoot, this);
+	});
+
+	utilitiesMenu->addAction(this->style()->standardIcon(QStyle::SP_MessageBoxWarning), tr("Crash Reports"), [this] {
+		CrashReportsDialog::open(this);
 	});
 
 	// Help menu
@@ -173,7 +351,58 @@ Window::Window(QWidget* parent)
 
 	new QVBoxLayout(this->main);
 
-	this->loadMostRecentGameConfig();
+	// Command entries are checked in the background, and disabled if they can't be run
+	this->preflight = new QFutureWatcher<CommandPreflight::Result>(this);
+	QObject::connect(this->preflight, &QFutureWatcher<CommandPreflight::Result>::resultReadyAt, this, [this](int index) {
+		if (this->preflight->isCanceled() || index >= this->preflightButtons.size()) {
+			return;
+		}
+		if (const auto result = this->preflight->resultAt(index); result.status != CommandPreflight::Status::OK) {
+			auto* button = this->preflightButtons[index];
+			button->setDisabled(true);
+			button->setToolTip(result.reason + '\n' + button->toolTip());
+		}
+	});
+
+	// Installed games and mods come from the cache right away, and are revalidated in the background
+	this->steamIndexUpdate = new QFutureWatcher<SteamIndex::Index>(this);
+	QObject::connect(this->steamIndexUpdate, &QFutureWatcher<SteamIndex::Index>::finished, this, [this] {
+		this->steamIndex = this->steamIndexUpdate->result();
+		this->regenerateGameChoices();
+	});
+	if (const auto& steamDir = getSteamDir(); !steamDir.isEmpty()) {
+		this->steamIndex = SteamIndex::load(steamDir);
+		this->steamIndexUpdate->setFuture(QtConcurrent::run([steamDir, previous = this->steamIndex] {
+			return SteamIndex::update(steamDir, previous);
+		}));
+	}
+
+	// The layout from the last run is painted right away, and replaced once the config is parsed off the UI thread
+	this->startupParse = new QFutureWatcher<ParsedGameConfig>(this);
+	QObject::connect(this->startupParse, &QFutureWatcher<ParsedGameConfig>::finished, this, [this] {
+		if (this->startupParse->isCanceled()) {
+			return;
+		}
+		auto parsed = this->startupParse->result();
+		const auto painted = std::move(this->layoutSnapshot);
+		const int pendingLaunch = std::exchange(this->snapshotPendingLaunch, -1);
+		this->applyGameConfig(parsed.path, std::move(parsed.gameConfig), parsed.diagnostics);
+
+		// A button clicked before the config was ready is launched if it's still in the same place
+		if (pendingLaunch >= 0 && pendingLaunch < this->buttons.size() && painted.hasSameEntries(this->layoutSnapshot) && this->buttons[pendingLaunch]->isEnabled()) {
+			emit this->buttons[pendingLaunch]->launch();
+		}
+	});
+	const auto configPath = getMostRecentGameConfigPath();
+	if (const auto snapshot = LayoutSnapshot::load(configPath, Options::get<QString>(STR_GAME_OVERRIDE))) {
+		this->paintLayoutSnapshot(*snapshot);
+	}
+	this->startupParse->setFuture(QtConcurrent::run([configPath] {
+		ParsedGameConfig parsed;
+		parsed.path = configPath;
+		parsed.gameConfig = GameConfig::parse(configPath, &parsed.diagnostics);
+		return parsed;
+	}));
 }
 
 QString Window::getStrataIconPath() {
@@ -194,48 +423,83 @@ QString Window::getSDKLauncherIconPath() {
 }
 
 void Window::loadMostRecentGameConfig() {
-	if (const auto recentConfigs = Options::get<QStringList>(STR_RECENT_CONFIGS); recentConfigs.isEmpty()) {
-		this->loadDefaultGameConfig();
-	} else {
-		this->loadGameConfig(recentConfigs.first());
-	}
+	this->loadGameConfig(getMostRecentGameConfigPath());
 }
 
 void Window::loadDefaultGameConfig() {
-	if (const auto defaultConfigPath = QCoreApplication::applicationDirPath() + "/SDKLauncherDefault.json"; QFile::exists(defaultConfigPath)) {
-		this->loadGameConfig(defaultConfigPath);
-	} else {
-		this->loadGameConfig(QString(":/config/%1.json").arg(PROJECT_DEFAULT_MOD.data()));
-	}
+	this->loadGameConfig(getDefaultGameConfigPath());
 }
 
 void Window::loadGameConfig(const QString& path) {
+	// Anything loaded by hand takes over from the config still being parsed at startup
+	this->startupParse->cancel();
+	this->snapshotPendingLaunch = -1;
+
+	QList<GameConfig::Diagnostic> diagnostics;
+	auto gameConfig = GameConfig::parse(path, &diagnostics);
+	this->applyGameConfig(path, std::move(gameConfig), diagnostics);
+}
+
+void Window::applyGameConfig(const QString& path, std::optional<GameConfig> gameConfig, const QList<GameConfig::Diagnostic>& diagnostics) {
+	this->preflight->cancel();
+	this->preflightButtons.clear();
+	this->layoutSnapshot = {};
+
 	auto* layout = dynamic_cast<QVBoxLayout*>(this->main->layout());
 	::clearLayout(layout);
 
-	auto gameConfig = GameConfig::parse(path);
+	QStringList diagnosticLines;
+	for (const auto& [line, column, message, file] : diagnostics) {
+		// Problems in the configs this one extends or includes say which file they're in
+		const auto prefix = QFileInfo{file} != QFileInfo{path} ? QFileInfo{file}.fileName() + ':' : QString{};
+		diagnosticLines.push_back(line > 0 ? tr("%1%2:%3: %4").arg(prefix).arg(line).arg(column).arg(message) : prefix + message);
+	}
 	if (!gameConfig) {
 		auto* test = new QLabel(tr("Invalid game configuration."), this->main);
+		test->setToolTip(diagnosticLines.join('\n'));
 		layout->addWidget(test);
+		if (!diagnosticLines.isEmpty()) {
+			auto* details = new QLabel(diagnosticLines.first(), this->main);
+			details->setWordWrap(true);
+			layout->addWidget(details);
+		}
 		layout->addStretch();
 		return;
 	}
+	if (!diagnosticLines.isEmpty()) {
+		auto* warning = new QLabel(tr("Some of this game configuration was skipped, hover for details."), this->main);
+		warning->setWordWrap(true);
+		warning->setToolTip(diagnosticLines.join('\n'));
+		layout->addWidget(warning);
+	}
 
 	this->configUsingLegacyBinDir = gameConfig->getUsesLegacyBinDir();
-	this->configModTemplateURL = gameConfig->getModTemplateURL();
+	this->configModTemplates = gameConfig->getModTemplates();
+	this->configPrewarmBudgetMB = gameConfig->getPrewarmBudgetMB();
 
 	this->utilities_createNewMod->clear();
-	if (this->configModTemplateURL.isEmpty()) {
-		this->utilities_createNewMod->setDisabled(true);
-	} else {
-		for (const auto& [desc, url] : this->configModTemplateURL.asKeyValueRange()) {
-			this->utilities_createNewMod->addAction(desc, [this, url] {
-				NewModDialog::open(::getRootPath(this->configUsingLegacyBinDir), url, this);
+	this->utilities_updateMod->clear();
+	this->utilities_createNewMod->setDisabled(this->configModTemplates.isEmpty());
+	this->utilities_updateMod->setDisabled(this->configModTemplates.isEmpty());
+	for (const auto& [desc, modTemplate] : this->configModTemplates.asKeyValueRange()) {
+		auto* createAction = this->utilities_createNewMod->addAction(desc, [this, modTemplate] {
+			NewModDialog::open(::getRootPath(this->configUsingLegacyBinDir), modTemplate.url, modTemplate.sha256, NewModDialog::Mode::CREATE, this);
+		});
+		auto* updateAction = this->utilities_updateMod->addAction(desc, [this, modTemplate] {
+			NewModDialog::open(::getRootPath(this->configUsingLegacyBinDir), modTemplate.url, modTemplate.sha256, NewModDialog::Mode::UPDATE, this);
+		});
+		// Hovering a template is a good sign it's about to be picked, so start downloading it
+		for (auto* action : {createAction, updateAction}) {
+			QObject::connect(action, &QAction::hovered, this, [url = modTemplate.url] {
+				TemplatePrefetch::get()->prefetch(url);
 			});
 		}
 	}
 
 	this->utilities_createNewAddon->setDisabled(!gameConfig->supportsP2CEAddons());
+	this->utilities_manageAddons->setDisabled(!gameConfig->supportsP2CEAddons());
+
+	this->regenerateGameChoices();
 
 	auto recentConfigs = Options::get<QStringList>(STR_RECENT_CONFIGS);
 	if (recentConfigs.contains(path)) {
@@ -290,6 +554,19 @@ void Window::loadGameConfig(const QString& path) {
 	const QString gameDir = Options::contains(STR_GAME_OVERRIDE) ? Options::get<QString>(STR_GAME_OVERRIDE) : this->gameDefault;
 	gameConfig->setVariable("GAME", gameDir);
 
+	// Index addons in the background so the addon manager opens instantly
+	if (gameConfig->supportsP2CEAddons()) {
+		if (const auto gameRoot = this->getGameRoot(); !this->addonIndex || this->addonIndex->getGameRoot() != gameRoot) {
+			delete this->addonIndex;
+			this->addonIndex = new AddonIndex{gameRoot, this};
+		}
+	} else {
+		delete this->addonIndex;
+		this->addonIndex = nullptr;
+	}
+
+	this->configPrewarmFiles = gameConfig->getPrewarmFiles();
+
 	// Set ${GAME_ICON}
 	if (const QIcon gameIcon{gameConfig->getGameIcon()}; !gameIcon.isNull() && !gameIcon.availableSizes().isEmpty()) {
 		this->game_overrideGame->setIcon(gameIcon);
@@ -299,37 +576,49 @@ void Window::loadGameConfig(const QString& path) {
 		gameConfig->setVariable("GAME_ICON", "");
 	}
 
+	// Icons, tooltips and preflight results are filled in when the snapshot is saved
+	this->layoutSnapshot.configPath = path;
+	this->layoutSnapshot.configFiles = gameConfig->getSourceFiles();
+	this->layoutSnapshot.gameOverride = Options::get<QString>(STR_GAME_OVERRIDE);
+	this->layoutSnapshot.windowWidth = gameConfig->getWindowWidth();
+	this->layoutSnapshot.windowHeight = gameConfig->getWindowHeight();
+
+	// Launch buttons resolve their command when clicked, so they share the finished config
+	const auto config = std::make_shared<const GameConfig>(std::move(*gameConfig));
+
 	this->buttons.clear();
-	for (int i = 0; i < gameConfig->getSections().size(); i++) {
-		auto& section = gameConfig->getSections()[i];
-
-		auto* name = new QLabel(section.name, this->main);
-		name->setStyleSheet("QLabel { font-size: 11pt; }");
-		layout->addWidget(name);
-
-		auto* line = new QFrame(this->main);
-		line->setFrameShape(QFrame::HLine);
-		layout->addWidget(line);
-
-		for (auto& entry : section.entries) {
-			auto* button = new LaunchButton(this->main);
-			button->setStyleSheet(
-					"LaunchButton          { background-color: rgba(  0,   0, 0,  0); border: none; }\n"
-					"LaunchButton::pressed { background-color: rgba(220, 220, 0, 32); border: none; }\n"
-					"LaunchButton::hover   { background-color: rgba(220, 220, 0, 32); border: none; }");
-			button->setToolButtonStyle(Qt::ToolButtonTextBesideIcon);
-			button->setText(entry.name);
-			button->setIconSize({16, 16});
+	QStringList preflightActions;
+	const bool sortByMostUsed = Options::get<bool>(BOOL_SORT_BY_MOST_USED, BOOL_SORT_BY_MOST_USED_DEFAULT);
+	for (int i = 0; i < config->getSections().size(); i++) {
+		auto& section = config->getSections()[i];
+		auto& snapshotSection = this->layoutSnapshot.sections.emplace_back();
+		snapshotSection.name = config->getString(section.name);
+
+		::addSectionHeader(layout, snapshotSection.name, this->main);
+
+		// Entries launched often and recently float to the top of their section
+		QList<std::pair<double, const GameConfig::Entry*>> entries;
+		for (const auto& entry : config->getEntries(section)) {
+			entries.emplace_back(sortByMostUsed ? this->launchJournal.getFrecency(LaunchJournal::getEntryID(snapshotSection.name, config->getString(entry.name))) : 0.0, &entry);
+		}
+		std::stable_sort(entries.begin(), entries.end(), [](const auto& lhs, const auto& rhs) {
+			return lhs.first > rhs.first;
+		});
+
+		for (const auto& [frecency, entryPtr] : entries) {
+			const auto& entry = *entryPtr;
+			auto* button = ::createLaunchButton(config->getString(entry.name), this->main);
 			layout->addWidget(button);
 			this->buttons.push_back(button);
+			snapshotSection.entries.emplace_back().name = button->text();
 
 			bool iconSet = false;
-			if (!entry.iconOverride.isEmpty()) {
-				button->setIcon(QIcon{entry.iconOverride});
+			if (entry.iconOverride != 0) {
+				button->setIcon(QIcon{config->getString(entry.iconOverride)});
 				iconSet = true;
 			}
 
-			QString action = entry.action;
+			QString action = config->getString(entry.action);
 			if (action.endsWith('/') || action.endsWith('\\')) {
 				action = action.sliced(0, action.size() - 1);
 			}
@@ -338,7 +627,7 @@ void Window::loadGameConfig(const QString& path) {
 					button->setIcon(this->style()->standardIcon(QStyle::SP_MessageBoxCritical));
 					button->setToolTip(tr("This button has an invalid type. Check the config for any spelling errors."));
 					break;
-				case GameConfig::ActionType::COMMAND:
+				case GameConfig::ActionType::COMMAND: {
 					if (!iconSet) {
 #ifdef _WIN32
 						if (auto icon = ::getExecutableIcon(action + ".exe"); !icon.isNull()) {
@@ -347,43 +636,50 @@ void Window::loadGameConfig(const QString& path) {
 							button->setIcon(this->style()->standardIcon(QStyle::SP_FileLinkIcon));
 						}
 #else
+						// Shared configs point at Windows tools too, their icons are read from the executable off the UI thread
 						button->setIcon(this->style()->standardIcon(QStyle::SP_FileLinkIcon));
+						if (const QString exePath = action + ".exe"; QFileInfo::exists(exePath)) {
+							auto* iconWatcher = new QFutureWatcher<QImage>(button);
+							QObject::connect(iconWatcher, &QFutureWatcher<QImage>::finished, button, [button, iconWatcher] {
+								if (const auto image = iconWatcher->result(); !image.isNull()) {
+									button->setIcon(QIcon{QPixmap::fromImage(image)});
+								}
+								iconWatcher->deleteLater();
+							});
+							iconWatcher->setFuture(PEIcon::getAsync(exePath, 16));
+						}
 #endif
 					}
-					button->setToolTip(action + " " + entry.arguments.join(" "));
-					QObject::connect(button, &LaunchButton::launch, this, [this, action, args=entry.arguments, cwd=rootPath] {
-						auto* process = new QProcess;
-						QObject::connect(process, &QProcess::errorOccurred, this, [this, timeStart = std::chrono::steady_clock::now()](QProcess::ProcessError code) {
-							QString error;
-							switch (code) {
-								using enum QProcess::ProcessError;
-								case FailedToStart:
-									error = tr("The process failed to start. Perhaps the executable it points to might not exist?");
-									break;
-								case Crashed: {
-									if (const auto timeEnd = std::chrono::steady_clock::now(); std::chrono::duration<float, std::milli>(timeEnd - timeStart).count() > 30'000) {
-										return;
-									}
-									error = tr("The process crashed.");
-									break;
-								}
-								case Timedout:
-									error = tr("The process timed out.");
-									break;
-								case ReadError:
-								case WriteError:
-									error = tr("The process hit an I/O error.");
-									break;
-								case UnknownError:
-									error = tr("The process hit an unknown error.");
-									break;
+					const auto entryID = LaunchJournal::getEntryID(snapshotSection.name, button->text());
+					button->setToolTip(action + " " + config->getArguments(entry).join(" ") + ::getLaunchStatsText(this->launchJournal.getStats(entryID)));
+					if (entry.instances > 1) {
+						button->setToolTip(tr("Starts %1 instances").arg(entry.instances) + '\n' + button->toolTip());
+					}
+					this->preflightButtons.push_back(button);
+					preflightActions.push_back(action);
+					QObject::connect(button, &LaunchButton::hovered, this, [this, binDir=QFileInfo{action}.absolutePath()] {
+						if (Options::get<bool>(BOOL_PREWARM_GAME_FILES, BOOL_PREWARM_GAME_FILES_DEFAULT)) {
+							Prewarm::request({binDir}, this->configPrewarmFiles, this->configPrewarmBudgetMB);
+						}
+					});
+					QObject::connect(button, &LaunchButton::launch, this, [this, action, config, entry=&entry, cwd=rootPath, entryID] {
+						const auto command = config->getCommand(*entry);
+						// Free ports are picked for every instance at once, so no two instances can end up with the same one
+						const auto ports = command.usesPort() ? ::allocatePorts(command.instances) : QList<quint16>{};
+						for (int i = 0; i < command.instances; i++) {
+							auto instance = command.forInstance(i, ports.value(i));
+							if (i == 0) {
+								this->startCommand(action, instance, cwd, entryID);
+								continue;
 							}
-							QMessageBox::critical(this, tr("Error"), tr("An error occurred executing this command: %1").arg(error));
-						});
-						process->setWorkingDirectory(cwd);
-						process->start(action, args);
+							// Staggered so the instances don't all read the same files from a cold cache at once
+							QTimer::singleShot(i * command.instanceStaggerMs, this, [this, action, instance=std::move(instance), cwd, entryID] {
+								this->startCommand(action, instance, cwd, entryID);
+							});
+						}
 					});
 					break;
+				}
 				case GameConfig::ActionType::LINK:
 					if (!iconSet) {
 						button->setIcon(this->style()->standardIcon(QStyle::SP_MessageBoxInformation));
@@ -398,22 +694,35 @@ void Window::loadGameConfig(const QString& path) {
 						button->setIcon(this->style()->standardIcon(QStyle::SP_DirLinkIcon));
 					}
 					button->setToolTip(action);
-					QObject::connect(button, &LaunchButton::launch, this, [action] {
-						QDesktopServices::openUrl(QUrl::fromLocalFile(action));
+					// File explorers can't look inside VPKs, so those open in the launcher's own browser
+					QObject::connect(button, &LaunchButton::launch, this, [this, action] {
+						if (action.endsWith(".vpk", Qt::CaseInsensitive)) {
+							VPKBrowserDialog::open(action, this);
+						} else {
+							QDesktopServices::openUrl(QUrl::fromLocalFile(action));
+						}
 					});
 					break;
 			}
 		}
 
-		if (i + 1 != gameConfig->getSections().size()) {
+		if (i + 1 != config->getSections().size()) {
 			layout->addSpacing(16);
 		}
 	}
 
 	layout->addStretch();
 
+	// Warm up the first command's binaries in case the user launches it
+	if (Options::get<bool>(BOOL_PREWARM_GAME_FILES, BOOL_PREWARM_GAME_FILES_DEFAULT) && !preflightActions.isEmpty()) {
+		Prewarm::request({QFileInfo{preflightActions.first()}.absolutePath()}, this->configPrewarmFiles, this->configPrewarmBudgetMB);
+	}
+
+	// Check command entries without blocking window population
+	this->preflight->setFuture(CommandPreflight::checkAll(std::move(preflightActions)));
+
 	// Set window sizing
-	this->resize(gameConfig->getWindowWidth(), gameConfig->getWindowHeight());
+	this->resize(config->getWindowWidth(), config->getWindowHeight());
 	// Update button widths. Just in case
 	this->resizeEvent(nullptr);
 }
@@ -439,6 +748,182 @@ void Window::regenerateRecentConfigs() {
 	});
 }
 
+void Window::regenerateGameChoices() {
+	this->game_chooseGame->clear();
+	if (!this->steamIndex) {
+		this->game_chooseGame->setDisabled(true);
+		return;
+	}
+
+	const auto rootPath = ::getRootPath(this->configUsingLegacyBinDir);
+	const QDir rootDir{rootPath};
+	const auto addChoice = [this, &rootDir](const QString& text, const QString& path) {
+		this->game_chooseGame->addAction(text, [this, game = QDir::cleanPath(rootDir.relativeFilePath(path))] {
+			Options::set(STR_GAME_OVERRIDE, game);
+			this->loadMostRecentGameConfig();
+		});
+	};
+
+	// Game folders next to the current one, then sourcemods made for the same game
+	const auto* installedGame = this->steamIndex->findGameByInstallDir(rootPath);
+	if (installedGame) {
+		for (const auto& gameFolder : installedGame->gameFolders) {
+			addChoice(gameFolder, rootDir.filePath(gameFolder));
+		}
+	}
+	bool addedSeparator = false;
+	for (const auto& mod : this->steamIndex->sourceMods) {
+		if (installedGame && mod.steamAppID != installedGame->appID) {
+			continue;
+		}
+		if (!addedSeparator && !this->game_chooseGame->isEmpty()) {
+			this->game_chooseGame->addSeparator();
+			addedSeparator = true;
+		}
+		addChoice(tr("%1 (sourcemods/%2)").arg(mod.name, mod.folder), mod.path);
+	}
+	this->game_chooseGame->setDisabled(this->game_chooseGame->isEmpty());
+}
+
+void Window::paintLayoutSnapshot(const LayoutSnapshot::Snapshot& snapshot) {
+	auto* layout = dynamic_cast<QVBoxLayout*>(this->main->layout());
+
+	this->buttons.clear();
+	int index = 0;
+	for (int i = 0; i < snapshot.sections.size(); i++) {
+		const auto& section = snapshot.sections[i];
+		::addSectionHeader(layout, section.name, this->main);
+
+		for (const auto& entry : section.entries) {
+			auto* button = ::createLaunchButton(entry.name, this->main);
+			if (!entry.icon.isNull()) {
+				button->setIcon(QIcon{QPixmap::fromImage(entry.icon)});
+			}
+			button->setToolTip(entry.toolTip);
+			button->setEnabled(entry.enabled);
+			layout->addWidget(button);
+			this->buttons.push_back(button);
+
+			// Nothing can be launched until the config is parsed, so the click is remembered until then
+			QObject::connect(button, &LaunchButton::launch, this, [this, index] {
+				this->snapshotPendingLaunch = index;
+			});
+			index++;
+		}
+
+		if (i + 1 != snapshot.sections.size()) {
+			layout->addSpacing(16);
+		}
+	}
+
+	layout->addStretch();
+
+	this->layoutSnapshot = snapshot;
+	this->resize(snapshot.windowWidth, snapshot.windowHeight);
+	this->resizeEvent(nullptr);
+}
+
+void Window::startCommand(const QString& action, const GameConfig::Command& command, const QString& cwd, quint64 entryID) {
+	auto* process = new QProcess;
+	QObject::connect(process, &QProcess::errorOccurred, this, [this, process, timeStart = std::chrono::steady_clock::now()](QProcess::ProcessError code) {
+		// Cancelling terminates the process, which shows up as a crash
+		if (code == QProcess::Crashed && CommandProgressDialog::wasCancelled(process)) {
+			return;
+		}
+		QString error;
+		switch (code) {
+			using enum QProcess::ProcessError;
+			case FailedToStart:
+				error = tr("The process failed to start. Perhaps the executable it points to might not exist?");
+				break;
+			case Crashed: {
+				if (const auto timeEnd = std::chrono::steady_clock::now(); std::chrono::duration<float, std::milli>(timeEnd - timeStart).count() > 30'000) {
+					return;
+				}
+				error = tr("The process crashed.");
+				break;
+			}
+			case Timedout:
+				error = tr("The process timed out.");
+				break;
+			case ReadError:
+			case WriteError:
+				error = tr("The process hit an I/O error.");
+				break;
+			case UnknownError:
+				error = tr("The process hit an unknown error.");
+				break;
+		}
+		QMessageBox::critical(this, tr("Error"), tr("An error occurred executing this command: %1").arg(error));
+	});
+	// Dumps and logs are gathered off the UI thread, so a crash never blocks the launcher
+	CrashCollector::Request crashRequest;
+	crashRequest.program = action;
+	crashRequest.arguments = command.arguments;
+	crashRequest.workingDirectory = cwd;
+	crashRequest.environment = command.environment;
+	crashRequest.gameDir = this->getGameRoot();
+	crashRequest.startedAt = QDateTime::currentMSecsSinceEpoch();
+	QObject::connect(process, &QProcess::finished, this, [process, crashRequest = std::move(crashRequest)](int exitCode, QProcess::ExitStatus exitStatus) mutable {
+		if (exitStatus != QProcess::CrashExit || CommandProgressDialog::wasCancelled(process) || !Options::get<bool>(BOOL_COLLECT_CRASH_REPORTS, BOOL_COLLECT_CRASH_REPORTS_DEFAULT)) {
+			return;
+		}
+		crashRequest.exitCode = exitCode;
+		(void) CrashCollector::collect(std::move(crashRequest), Options::get<int>(INT_CRASH_REPORTS_BUDGET_MB, INT_CRASH_REPORTS_BUDGET_MB_DEFAULT));
+	});
+	process->setWorkingDirectory(cwd);
+	::applyEntryScheduling(process, command);
+
+	// Compile tools that print their progress get a window following it, estimated from previous runs on the same map
+	const auto commandLine = action + ' ' + command.arguments.join(' ');
+	if (!command.progressPattern.isEmpty()) {
+		process->setProcessChannelMode(QProcess::MergedChannels);
+		auto* progressDialog = new CommandProgressDialog{process, QFileInfo{action}.fileName(), command, this->launchJournal.getMedianRunTimeMs(entryID, commandLine), this};
+		progressDialog->show();
+	}
+
+	// Journaled for the stats in tooltips and sorting by most used
+	const auto journalHandle = this->launchJournal.recordLaunch(entryID, commandLine);
+	const auto spawnStart = std::chrono::steady_clock::now();
+	QObject::connect(process, &QProcess::started, this, [this, journalHandle, spawnStart] {
+		this->launchJournal.recordStarted(journalHandle, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - spawnStart).count());
+	});
+	QObject::connect(process, &QProcess::finished, this, [this, process, journalHandle, spawnStart](int exitCode, QProcess::ExitStatus exitStatus) {
+		const auto runTimeMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - spawnStart).count();
+		auto status = exitStatus == QProcess::CrashExit ? LaunchJournal::Status::CRASHED : LaunchJournal::Status::EXITED;
+		if (CommandProgressDialog::wasCancelled(process)) {
+			status = LaunchJournal::Status::CANCELLED;
+		}
+		this->launchJournal.recordExit(journalHandle, status, exitCode, runTimeMs);
+	});
+	QObject::connect(process, &QProcess::errorOccurred, this, [this, journalHandle](QProcess::ProcessError code) {
+		if (code == QProcess::FailedToStart) {
+			this->launchJournal.recordExit(journalHandle, LaunchJournal::Status::FAILED_TO_START, -1, 0);
+		}
+	});
+	process->start(action, command.arguments);
+}
+
+void Window::closeEvent(QCloseEvent* event) {
+	// Icons load asynchronously and preflight can disable buttons, so the final state is read off the buttons
+	if (!this->layoutSnapshot.configPath.isEmpty()) {
+		qsizetype index = 0;
+		for (auto& section : this->layoutSnapshot.sections) {
+			for (auto& entry : section.entries) {
+				if (index >= this->buttons.size()) {
+					break;
+				}
+				const auto* button = this->buttons[index++];
+				entry.toolTip = button->toolTip();
+				entry.icon = button->icon().pixmap(button->iconSize()).toImage();
+				entry.enabled = button->isEnabled();
+			}
+		}
+		LayoutSnapshot::save(this->layoutSnapshot);
+	}
+	QMainWindow::closeEvent(event);
+}
+
 void Window::resizeEvent(QResizeEvent* event) {
 	for (auto* button : this->buttons) {
 		button->setFixedWidth(this->width() - 18);
@@ -447,3 +932,25 @@ void Window::resizeEvent(QResizeEvent* event) {
 		QMainWindow::resizeEvent(event);
 	}
 }
+
+QString Window::getMostRecentGameConfigPath() {
+	if (const auto recentConfigs = Options::get<QStringList>(STR_RECENT_CONFIGS); !recentConfigs.isEmpty()) {
+		return recentConfigs.first();
+	}
+	return getDefaultGameConfigPath();
+}
+
+QString Window::getDefaultGameConfigPath() {
+	if (const auto defaultConfigPath = QCoreApplication::applicationDirPath() + "/SDKLauncherDefault.json"; QFile::exists(defaultConfigPath)) {
+		return defaultConfigPath;
+	}
+	return QString(":/config/%1.json").arg(PROJECT_DEFAULT_MOD.data());
+}
+
+QString Window::getGameRoot() const {
+	QString gameRoot = Options::contains(STR_GAME_OVERRIDE) ? Options::get<QString>(STR_GAME_OVERRIDE) : this->gameDefault;
+	if (!QDir::isAbsolutePath(gameRoot)) {
+		gameRoot = ::getRootPath(this->configUsingLegacyBinDir) + QDir::separator() + gameRoot;
+	}
+	return gameRoot;
+}
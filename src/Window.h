@@ -1,11 +1,22 @@
 #pragma once
 
+#include <optional>
+
+#include <QFutureWatcher>
 #include <QMainWindow>
 
+#include "CommandPreflight.h"
+#include "GameConfig.h"
+#include "LaunchJournal.h"
+#include "LayoutSnapshot.h"
+#include "SteamIndex.h"
+
 class QAction;
+class QCloseEvent;
 class QMenu;
 class QResizeEvent;
 
+class AddonIndex;
 class LaunchButton;
 
 class Window : public QMainWindow {
@@ -26,21 +37,62 @@ public:
 
 	void regenerateRecentConfigs();
 
+	void regenerateGameChoices();
+
 protected:
+	void closeEvent(QCloseEvent* event) override;
+
 	void resizeEvent(QResizeEvent* event) override;
 
 private:
+	struct ParsedGameConfig {
+		QString path;
+		std::optional<GameConfig> gameConfig;
+		QList<GameConfig::Diagnostic> diagnostics;
+	};
+
 	QString gameDefault;
 	bool configUsingLegacyBinDir;
-	QMap<QString, QString> configModTemplateURL;
+	QMap<QString, GameConfig::ModTemplate> configModTemplates;
+	QStringList configPrewarmFiles;
+	int configPrewarmBudgetMB;
 
 	QMenu* recent;
 	QAction* config_loadDefault;
 	QAction* game_overrideGame;
 	QAction* game_resetToDefault;
+	QMenu* game_chooseGame;
 	QMenu* utilities_createNewMod;
+	QMenu* utilities_updateMod;
 	QAction* utilities_createNewAddon;
+	QAction* utilities_manageAddons;
 
 	QWidget* main;
 	QList<LaunchButton*> buttons;
+
+	QFutureWatcher<CommandPreflight::Result>* preflight;
+	QList<LaunchButton*> preflightButtons;
+
+	AddonIndex* addonIndex = nullptr;
+
+	std::optional<SteamIndex::Index> steamIndex;
+	QFutureWatcher<SteamIndex::Index>* steamIndexUpdate;
+
+	QFutureWatcher<ParsedGameConfig>* startupParse;
+	LayoutSnapshot::Snapshot layoutSnapshot;
+	int snapshotPendingLaunch = -1;
+
+	LaunchJournal launchJournal;
+
+	[[nodiscard]] static QString getMostRecentGameConfigPath();
+
+	[[nodiscard]] static QString getDefaultGameConfigPath();
+
+	void applyGameConfig(const QString& path, std::optional<GameConfig> gameConfig, const QList<GameConfig::Diagnostic>& diagnostics);
+
+	void paintLayoutSnapshot(const LayoutSnapshot::Snapshot& snapshot);
+
+	void startCommand(const QString& action, const GameConfig::Command& command, const QString& cwd, quint64 entryID);
+
+	[[nodiscard]] QString getGameRoot() const;
 };